@@ -0,0 +1,270 @@
+#pragma once
+
+#include "./TextOutput.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// AsyncOutput
+// Descr: Moves status output off the stepping thread. The
+// simulation pushes raw state snapshots into a bounded
+// lock free ring buffer, a background thread formats and
+// writes them.
+//////////////////////////////////////////////////////////
+
+// Bounded single producer, single consumer queue. Capacity is
+// rounded up to a power of two.
+template <typename T>
+class SpscRingBuffer
+{
+public:
+
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t roundedCapacity = 1;
+        while (roundedCapacity < capacity)
+        {
+            roundedCapacity *= 2;
+        }
+
+        m_Slots.resize(roundedCapacity);
+        m_Mask = roundedCapacity - 1;
+    }
+
+    size_t Capacity() const
+    {
+        return m_Slots.size();
+    }
+
+    // Number of queued items. Exact only from the producer or consumer
+    // thread while the other one is idle.
+    size_t Size() const
+    {
+        return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+    }
+
+    // Producer only. Returns false if the buffer is full.
+    bool TryPush(const T& item)
+    {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail - m_Head.load(std::memory_order_acquire) == m_Slots.size())
+        {
+            return false;
+        }
+
+        m_Slots[tail & m_Mask] = item;
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the buffer is empty.
+    bool TryPop(T& outItem)
+    {
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        if (head == m_Tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        outItem = m_Slots[head & m_Mask];
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> m_Slots;
+    size_t m_Mask = 0;
+
+    // Head and tail on separate cache lines so producer and consumer
+    // don't invalidate each other's line on every operation.
+    alignas(64) std::atomic<size_t> m_Head{0};  // Next slot to pop.
+    alignas(64) std::atomic<size_t> m_Tail{0};  // Next slot to push.
+};
+
+// What Push does when the ring buffer is full.
+enum class BackpressurePolicy
+{
+    Block,      // Wait for the writer, nothing is lost.
+    Drop,       // Discard the new snapshot.
+    Decimate    // Discard it and only keep every 2nd, 4th, ... snapshot
+                // until the writer has caught up.
+};
+
+struct AsyncOutputStats
+{
+    uint64_t m_Pushed = 0;      // Snapshots offered by the simulation.
+    uint64_t m_Written = 0;     // Snapshots formatted and written.
+    uint64_t m_Dropped = 0;     // Discarded because the buffer was full.
+    uint64_t m_Decimated = 0;   // Skipped while decimating.
+    uint64_t m_Blocked = 0;     // Pushes which had to wait, Block only.
+};
+
+// Prints DynamicEntityType states in the same format as
+// Simulation::PrintStatus, from a background thread. Use as the
+// output sink of a Simulation, eg
+//   sim.SetOutputSink([&](double t, const auto& state){ printer.Push(t, state); });
+template <typename DynamicEntityType>
+class AsyncStatusPrinter
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+
+    AsyncStatusPrinter(std::ostream& out,
+        size_t capacity = 4096,
+        BackpressurePolicy policy = BackpressurePolicy::Block)
+    : m_Out(out)
+    , m_Policy(policy)
+    , m_Buffer(capacity)
+    {
+        m_Writer = std::thread([this]{ WriterLoop(); });
+    }
+
+    AsyncStatusPrinter(const AsyncStatusPrinter&) = delete;
+    AsyncStatusPrinter& operator=(const AsyncStatusPrinter&) = delete;
+
+    ~AsyncStatusPrinter()
+    {
+        Stop();
+    }
+
+    // Called from the simulation thread only.
+    void Push(double time, const State& state)
+    {
+        m_Pushed.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_Policy == BackpressurePolicy::Decimate)
+        {
+            // Back to every snapshot once the writer has caught up.
+            if (m_DecimationFactor > 1 && m_Buffer.Size() < m_Buffer.Capacity() / 4)
+            {
+                m_DecimationFactor = 1;
+            }
+
+            if (m_DecimationCount++ % m_DecimationFactor != 0)
+            {
+                m_Decimated.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        const Snapshot snapshot{time, state};
+        if (m_Buffer.TryPush(snapshot))
+        {
+            return;
+        }
+
+        switch (m_Policy)
+        {
+            case BackpressurePolicy::Block:
+                m_Blocked.fetch_add(1, std::memory_order_relaxed);
+                while (!m_Buffer.TryPush(snapshot))
+                {
+                    std::this_thread::yield();
+                }
+                break;
+
+            case BackpressurePolicy::Drop:
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+
+            case BackpressurePolicy::Decimate:
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                m_DecimationFactor = std::min<uint64_t>(2 * m_DecimationFactor, MaxDecimationFactor);
+                m_DecimationCount = 1;
+                break;
+        }
+    }
+
+    // Writes out everything pushed so far and stops the writer thread.
+    void Stop()
+    {
+        if (m_Writer.joinable())
+        {
+            m_Stop.store(true, std::memory_order_release);
+            m_Writer.join();
+            m_Out.flush();
+        }
+    }
+
+    AsyncOutputStats GetStats() const
+    {
+        AsyncOutputStats stats;
+        stats.m_Pushed = m_Pushed.load(std::memory_order_relaxed);
+        stats.m_Written = m_Written.load(std::memory_order_relaxed);
+        stats.m_Dropped = m_Dropped.load(std::memory_order_relaxed);
+        stats.m_Decimated = m_Decimated.load(std::memory_order_relaxed);
+        stats.m_Blocked = m_Blocked.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+
+    struct Snapshot
+    {
+        double m_Time;
+        State m_State;
+    };
+
+    static constexpr uint64_t MaxDecimationFactor = 1024;
+
+    void WriterLoop()
+    {
+        Snapshot snapshot;
+        while (true)
+        {
+            // Check for stop before draining, so nothing pushed before
+            // Stop() is left behind.
+            const bool stopping = m_Stop.load(std::memory_order_acquire);
+
+            bool wroteAny = false;
+            while (m_Buffer.TryPop(snapshot))
+            {
+                TextOutput::AppendStatus<DynamicEntityType>(m_Text, snapshot.m_Time, snapshot.m_State);
+                if (m_Text.Size() >= TextOutput::DefaultBlockSize)
+                {
+                    m_Text.WriteTo(m_Out);
+                }
+                m_Written.fetch_add(1, std::memory_order_relaxed);
+                wroteAny = true;
+            }
+            m_Text.WriteTo(m_Out);
+
+            if (stopping)
+            {
+                return;
+            }
+
+            if (!wroteAny)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+private:
+    TextOutput::TextBuffer m_Text;          // Writer thread only.
+    std::ostream& m_Out;                    // Writer thread only, until Stop().
+    const BackpressurePolicy m_Policy;
+    SpscRingBuffer<Snapshot> m_Buffer;
+
+    // Simulation thread only.
+    uint64_t m_DecimationFactor = 1;
+    uint64_t m_DecimationCount = 0;
+
+    std::atomic<uint64_t> m_Pushed{0};
+    std::atomic<uint64_t> m_Written{0};
+    std::atomic<uint64_t> m_Dropped{0};
+    std::atomic<uint64_t> m_Decimated{0};
+    std::atomic<uint64_t> m_Blocked{0};
+    std::atomic<bool> m_Stop{false};
+
+    std::thread m_Writer;
+};
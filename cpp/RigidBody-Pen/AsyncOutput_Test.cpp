@@ -0,0 +1,148 @@
+#include "./AsyncOutput.h"
+#include "./DynamicEntities.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <chrono>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+//////////////////////////////////////////////////////////
+// AsyncOutput Unit Tests
+//////////////////////////////////////////////////////////
+
+// Output which takes a while per write, to make the writer
+// thread fall behind the simulation.
+class SlowStreamBuf : public std::streambuf
+{
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        return count;
+    }
+
+    int overflow(int ch) override
+    {
+        return ch;
+    }
+};
+
+static size_t CountSnapshots(const std::string& text)
+{
+    size_t count = 0;
+    for (size_t pos = text.find("\nt = "); pos != std::string::npos; pos = text.find("\nt = ", pos + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+
+int main(void)
+{
+    //////////////////////////////////////////////////////////
+    // Test ring buffer capacity and order.
+    {
+        SpscRingBuffer<int> buffer(3);
+        bool ringEq = buffer.Capacity() == 4;
+        for (int i = 0; i < 4; ++i)
+        {
+            ringEq = ringEq && buffer.TryPush(i);
+        }
+        ringEq = ringEq && !buffer.TryPush(4) && buffer.Size() == 4;
+
+        int item = -1;
+        for (int i = 0; i < 4; ++i)
+        {
+            ringEq = ringEq && buffer.TryPop(item) && item == i;
+        }
+        ringEq = ringEq && !buffer.TryPop(item);
+        TestUtils::ReportResults(ringEq, "Async Output Test: Ring Buffer Order");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test ring buffer across threads loses and reorders nothing.
+    {
+        SpscRingBuffer<int> buffer(64);
+        const int count = 200000;
+
+        std::thread producer([&]
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                while (!buffer.TryPush(i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        bool inOrder = true;
+        int item = 0;
+        for (int expected = 0; expected < count; ++expected)
+        {
+            while (!buffer.TryPop(item))
+            {
+                std::this_thread::yield();
+            }
+            inOrder = inOrder && item == expected;
+        }
+        producer.join();
+        TestUtils::ReportResults(inOrder, "Async Output Test: Ring Buffer Threads");
+    }
+
+    const CrudeSpinningPen::State penStateInput{
+        0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+    const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+    const CrudeSpinningPen csp(penStateInput, inertia);
+
+    //////////////////////////////////////////////////////////
+    // Test blocking printer writes every state of a Simulation,
+    // formatted as PrintStatus does.
+    {
+        std::ostringstream out;
+        AsyncStatusPrinter<CrudeSpinningPen> printer(out, 8, BackpressurePolicy::Block);
+
+        Simulation simCsp(2.04, .01, false, csp);
+        simCsp.SetOutputSink([&](double time, const CrudeSpinningPen::State& state)
+        {
+            printer.Push(time, state);
+        });
+        simCsp.Run();
+        printer.Stop();
+
+        const AsyncOutputStats stats = printer.GetStats();
+        const bool allWritten = stats.m_Pushed == 205 && stats.m_Written == 205 &&
+            stats.m_Dropped == 0 && CountSnapshots(out.str()) == 205 &&
+            out.str().find("CSP: x = 0.000000") != std::string::npos;
+        TestUtils::ReportResults(allWritten, "Async Output Test: Block Writes All");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test drop and decimate against a slow output account for
+    // every snapshot.
+    for (BackpressurePolicy policy : {BackpressurePolicy::Drop, BackpressurePolicy::Decimate})
+    {
+        SlowStreamBuf slowBuf;
+        std::ostream out(&slowBuf);
+        AsyncStatusPrinter<CrudeSpinningPen> printer(out, 4, policy);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            printer.Push(0.01 * i, penStateInput);
+        }
+        printer.Stop();
+
+        const AsyncOutputStats stats = printer.GetStats();
+        const bool accounted = stats.m_Pushed == 2000 &&
+            stats.m_Written + stats.m_Dropped + stats.m_Decimated == 2000 &&
+            stats.m_Dropped > 0 && stats.m_Blocked == 0 &&
+            (policy == BackpressurePolicy::Drop) == (stats.m_Decimated == 0);
+        TestUtils::ReportResults(accounted, policy == BackpressurePolicy::Drop ?
+            "Async Output Test: Drop Counts" : "Async Output Test: Decimate Counts");
+    }
+
+    return 0;
+}
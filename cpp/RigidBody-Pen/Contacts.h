@@ -0,0 +1,464 @@
+#pragma once
+
+#include "./DynamicEntities.h"
+#include "./Integrators.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Contacts
+// Descr: Ground plane and pen-pen contact for spinning pens.
+// Each pen is a capsule along its body z axis. After every
+// step, contacts are found and resolved with frictionless
+// impulses on the velocities, plus a position correction
+// which removes penetration. Pen pairs are found through a
+// uniform grid, hashed on cell coordinates, so detection
+// scales with the number of pens near each other rather
+// than with N^2.
+//////////////////////////////////////////////////////////
+
+namespace Contacts
+{
+
+using Vec3 = std::array<double, 3>;
+
+inline Vec3 Add(const Vec3& a, const Vec3& b) { return Vec3{a[0] + b[0], a[1] + b[1], a[2] + b[2]}; }
+inline Vec3 Sub(const Vec3& a, const Vec3& b) { return Vec3{a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+inline Vec3 Scale(const Vec3& a, double s) { return Vec3{s * a[0], s * a[1], s * a[2]}; }
+inline double Dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+inline Vec3 Cross(const Vec3& a, const Vec3& b)
+{
+    return Vec3{a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+struct Config
+{
+    double m_Radius = 0.005;                // in m, of the capsule.
+    double m_HalfLength = 0.07;             // in m, center to cap center along body z.
+    double m_Mass = 0.02;                   // in kg. GetInertia() is then in kg m^2.
+    double m_Restitution = 0.3;             // 0 is plastic, 1 elastic.
+    double m_GroundHeight = 0.0;            // in m, plane z = m_GroundHeight.
+    double m_CellSize = 0.0;                // in m, 0 picks the pen's length.
+    bool m_UseBroadphase = true;            // false tests all pairs, for reference.
+};
+
+// Counts from the last Resolve().
+struct Stats
+{
+    uint64_t m_CandidatePairs = 0;          // Pairs sharing a grid cell.
+    uint64_t m_PairHits = 0;                // Candidate pairs actually touching.
+    uint64_t m_GroundHits = 0;              // Pen ends touching the ground.
+};
+
+// Closest points of segments p1-q1 and p2-q2, as parameters s and t
+// along each. Ericson, Real-Time Collision Detection, 5.1.9, except
+// parallel segments meet in the middle of their overlap. Segments of
+// zero length, eg of pens with m_HalfLength 0, are points.
+inline std::pair<double, double> ClosestSegmentParams(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2)
+{
+    constexpr double Epsilon = 1.0e-18;     // in m^2, squared length of a point.
+
+    const Vec3 d1 = Sub(q1, p1);
+    const Vec3 d2 = Sub(q2, p2);
+    const Vec3 r = Sub(p1, p2);
+    const double a = Dot(d1, d1);
+    const double e = Dot(d2, d2);
+    const double f = Dot(d2, r);
+
+    if (a <= Epsilon && e <= Epsilon)
+    {
+        return {0.0, 0.0};
+    }
+    if (a <= Epsilon)
+    {
+        return {0.0, std::clamp(f / e, 0.0, 1.0)};
+    }
+
+    const double c = Dot(d1, r);
+    if (e <= Epsilon)
+    {
+        return {std::clamp(-c / a, 0.0, 1.0), 0.0};
+    }
+
+    const double b = Dot(d1, d2);
+    const double denom = a * e - b * b;
+
+    double s;
+    if (denom > 1.0e-12 * a * e)
+    {
+        s = std::clamp((b * f - c * e) / denom, 0.0, 1.0);
+    }
+    else
+    {
+        // Projections of p2 and q2 onto segment 1.
+        const double sP2 = std::clamp(-c / a, 0.0, 1.0);
+        const double sQ2 = std::clamp((b - c) / a, 0.0, 1.0);
+        s = 0.5 * (sP2 + sQ2);
+    }
+
+    double t = (b * s + f) / e;
+    if (t < 0.0)
+    {
+        t = 0.0;
+        s = std::clamp(-c / a, 0.0, 1.0);
+    }
+    else if (t > 1.0)
+    {
+        t = 1.0;
+        s = std::clamp((b - c) / a, 0.0, 1.0);
+    }
+
+    return {s, t};
+}
+
+class Solver
+{
+public:
+
+    explicit Solver(const Config& config = Config{})
+    : m_Config(config)
+    {}
+
+    const Config& GetConfig() const
+    {
+        return m_Config;
+    }
+
+    // Finds and resolves all contacts between pens and with the ground.
+    const Stats& Resolve(std::vector<QuaternionSpinningPen>& pens)
+    {
+        m_Stats = Stats{};
+
+        FindCandidatePairs(pens);
+        m_Stats.m_CandidatePairs = m_Pairs.size();
+
+        for (const std::pair<uint32_t, uint32_t>& pair : m_Pairs)
+        {
+            if (ResolvePair(pens[pair.first], pens[pair.second]))
+            {
+                ++m_Stats.m_PairHits;
+            }
+        }
+
+        for (QuaternionSpinningPen& pen : pens)
+        {
+            m_Stats.m_GroundHits += ResolveGround(pen);
+        }
+
+        return m_Stats;
+    }
+
+    const Stats& GetStats() const
+    {
+        return m_Stats;
+    }
+
+private:
+
+    static constexpr size_t GroundIterations = 16;
+
+    static Vec3 Position(const QuaternionSpinningPen& pen)
+    {
+        return Vec3{pen.m_State[0], pen.m_State[1], pen.m_State[2]};
+    }
+
+    // Ends of the capsule's core segment.
+    std::pair<Vec3, Vec3> Segment(const QuaternionSpinningPen& pen) const
+    {
+        const Vec3 axis = pen.BodyToWorld(Vec3{0.0, 0.0, m_Config.m_HalfLength});
+        return {Sub(Position(pen), axis), Add(Position(pen), axis)};
+    }
+
+    // Velocity of the material point at lever arm r from the center.
+    static Vec3 PointVelocity(const QuaternionSpinningPen& pen, const Vec3& r)
+    {
+        const Vec3 vel{pen.m_State[7], pen.m_State[8], pen.m_State[9]};
+        const Vec3 omega = pen.BodyToWorld(Vec3{pen.m_State[10], pen.m_State[11], pen.m_State[12]});
+        return Add(vel, Cross(omega, r));
+    }
+
+    // n . ((I^-1 (r x n)) x r), the rotational part of the inverse
+    // effective mass along n.
+    static double AngularInverseMass(const QuaternionSpinningPen& pen, const Vec3& r, const Vec3& n)
+    {
+        const Vec3 b = pen.WorldToBody(Cross(r, n));
+        const std::array<double, 3>& inertia = pen.GetInertia();
+        return b[0] * b[0] / inertia[0] + b[1] * b[1] / inertia[1] + b[2] * b[2] / inertia[2];
+    }
+
+    void ApplyImpulse(QuaternionSpinningPen& pen, const Vec3& r, const Vec3& impulse) const
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            pen.m_State[7 + i] += impulse[i] / m_Config.m_Mass;
+        }
+
+        const Vec3 angular = pen.WorldToBody(Cross(r, impulse));
+        const std::array<double, 3>& inertia = pen.GetInertia();
+        for (size_t i = 0; i < 3; ++i)
+        {
+            pen.m_State[10 + i] += angular[i] / inertia[i];
+        }
+    }
+
+    static void Translate(QuaternionSpinningPen& pen, const Vec3& offset)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            pen.m_State[i] += offset[i];
+        }
+    }
+
+    // Grid cell key, 21 bits per coordinate.
+    static uint64_t CellKey(int64_t ix, int64_t iy, int64_t iz)
+    {
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        return ((uint64_t(ix) & mask) << 42) | ((uint64_t(iy) & mask) << 21) | (uint64_t(iz) & mask);
+    }
+
+    // Unique pairs i < j, sorted, which may touch.
+    void FindCandidatePairs(const std::vector<QuaternionSpinningPen>& pens)
+    {
+        m_Pairs.clear();
+
+        if (!m_Config.m_UseBroadphase)
+        {
+            for (uint32_t i = 0; i < pens.size(); ++i)
+            {
+                for (uint32_t j = i + 1; j < pens.size(); ++j)
+                {
+                    m_Pairs.emplace_back(i, j);
+                }
+            }
+            return;
+        }
+
+        // Bin every pen into each cell its bounding box overlaps, sort by
+        // cell, and pair up pens within each run of equal cells.
+        const double cellSize = m_Config.m_CellSize > 0.0 ? m_Config.m_CellSize
+            : 2.0 * (m_Config.m_HalfLength + m_Config.m_Radius);
+
+        m_CellEntries.clear();
+        for (uint32_t idx = 0; idx < pens.size(); ++idx)
+        {
+            const std::pair<Vec3, Vec3> segment = Segment(pens[idx]);
+            std::array<int64_t, 3> lower;
+            std::array<int64_t, 3> upper;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                lower[i] = static_cast<int64_t>(std::floor((std::min(segment.first[i], segment.second[i]) - m_Config.m_Radius) / cellSize));
+                upper[i] = static_cast<int64_t>(std::floor((std::max(segment.first[i], segment.second[i]) + m_Config.m_Radius) / cellSize));
+            }
+
+            for (int64_t ix = lower[0]; ix <= upper[0]; ++ix)
+            {
+                for (int64_t iy = lower[1]; iy <= upper[1]; ++iy)
+                {
+                    for (int64_t iz = lower[2]; iz <= upper[2]; ++iz)
+                    {
+                        m_CellEntries.emplace_back(CellKey(ix, iy, iz), idx);
+                    }
+                }
+            }
+        }
+
+        std::sort(m_CellEntries.begin(), m_CellEntries.end());
+
+        for (size_t begin = 0; begin < m_CellEntries.size(); )
+        {
+            size_t end = begin + 1;
+            while (end < m_CellEntries.size() && m_CellEntries[end].first == m_CellEntries[begin].first)
+            {
+                ++end;
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (size_t j = i + 1; j < end; ++j)
+                {
+                    m_Pairs.emplace_back(m_CellEntries[i].second, m_CellEntries[j].second);
+                }
+            }
+            begin = end;
+        }
+
+        // Pens sharing several cells are paired once.
+        std::sort(m_Pairs.begin(), m_Pairs.end());
+        m_Pairs.erase(std::unique(m_Pairs.begin(), m_Pairs.end()), m_Pairs.end());
+    }
+
+    bool ResolvePair(QuaternionSpinningPen& pen1, QuaternionSpinningPen& pen2) const
+    {
+        const std::pair<Vec3, Vec3> segment1 = Segment(pen1);
+        const std::pair<Vec3, Vec3> segment2 = Segment(pen2);
+        const std::pair<double, double> params = ClosestSegmentParams(segment1.first, segment1.second, segment2.first, segment2.second);
+
+        const Vec3 closest1 = Add(segment1.first, Scale(Sub(segment1.second, segment1.first), params.first));
+        const Vec3 closest2 = Add(segment2.first, Scale(Sub(segment2.second, segment2.first), params.second));
+        const Vec3 delta = Sub(closest2, closest1);
+        const double distance = std::sqrt(Dot(delta, delta));
+        const double penetration = 2.0 * m_Config.m_Radius - distance;
+
+        if (penetration <= 0.0 || distance == 0.0)
+        {
+            return false;
+        }
+
+        // Normal from pen 1 to pen 2, contact point halfway through the overlap.
+        const Vec3 normal = Scale(delta, 1.0 / distance);
+        const Vec3 contact = Add(closest1, Scale(normal, 0.5 * distance));
+        const Vec3 r1 = Sub(contact, Position(pen1));
+        const Vec3 r2 = Sub(contact, Position(pen2));
+
+        const double approach = Dot(Sub(PointVelocity(pen2, r2), PointVelocity(pen1, r1)), normal);
+        if (approach < 0.0)
+        {
+            const double inverseMass = 2.0 / m_Config.m_Mass +
+                AngularInverseMass(pen1, r1, normal) + AngularInverseMass(pen2, r2, normal);
+            const double magnitude = -(1.0 + m_Config.m_Restitution) * approach / inverseMass;
+            ApplyImpulse(pen1, r1, Scale(normal, -magnitude));
+            ApplyImpulse(pen2, r2, Scale(normal, magnitude));
+        }
+
+        Translate(pen1, Scale(normal, -0.5 * penetration));
+        Translate(pen2, Scale(normal, 0.5 * penetration));
+        return true;
+    }
+
+    // Returns the number of capsule ends touching the ground.
+    uint64_t ResolveGround(QuaternionSpinningPen& pen) const
+    {
+        const Vec3 normal{0.0, 0.0, 1.0};
+        const std::pair<Vec3, Vec3> segment = Segment(pen);
+
+        // Touching ends, with their lever arms and the separation speed
+        // restitution asks for.
+        std::array<Vec3, 2> arms;
+        std::array<double, 2> targets;
+        std::array<double, 2> accumulated = {0.0, 0.0};
+        uint64_t hits = 0;
+        double maxPenetration = 0.0;
+        for (const Vec3& end : {segment.first, segment.second})
+        {
+            const double penetration = m_Config.m_GroundHeight - (end[2] - m_Config.m_Radius);
+            if (penetration <= 0.0)
+            {
+                continue;
+            }
+
+            arms[hits] = Sub(Vec3{end[0], end[1], end[2] - m_Config.m_Radius}, Position(pen));
+            targets[hits] = -m_Config.m_Restitution * std::min(Dot(PointVelocity(pen, arms[hits]), normal), 0.0);
+            maxPenetration = std::max(maxPenetration, penetration);
+            ++hits;
+        }
+
+        // A pen landing on both ends at once needs both impulses together,
+        // or it is kicked into a spin. Iterate them to convergence,
+        // keeping each end's total impulse non negative.
+        const size_t iterations = hits > 1 ? GroundIterations : 1;
+        for (size_t iteration = 0; iteration < iterations; ++iteration)
+        {
+            for (size_t hit = 0; hit < hits; ++hit)
+            {
+                const double approach = Dot(PointVelocity(pen, arms[hit]), normal);
+                const double inverseMass = 1.0 / m_Config.m_Mass + AngularInverseMass(pen, arms[hit], normal);
+                const double total = std::max(accumulated[hit] + (targets[hit] - approach) / inverseMass, 0.0);
+                ApplyImpulse(pen, arms[hit], Scale(normal, total - accumulated[hit]));
+                accumulated[hit] = total;
+            }
+        }
+
+        pen.m_State[2] += maxPenetration;
+        return hits;
+    }
+
+private:
+    Config m_Config;
+    Stats m_Stats;
+
+    // Reused between calls.
+    std::vector<std::pair<uint64_t, uint32_t>> m_CellEntries;
+    std::vector<std::pair<uint32_t, uint32_t>> m_Pairs;
+};
+
+} // namespace Contacts
+
+// Pens under gravity with ground and pen-pen contact. Each Step()
+// integrates every pen with Integrator, then resolves contacts.
+template <template <typename> class Integrator = Integrators::RK4>
+class PenContactScene
+{
+public:
+
+    explicit PenContactScene(const Contacts::Config& config = Contacts::Config{})
+    : m_Solver(config)
+    {}
+
+    void Add(const QuaternionSpinningPen& pen)
+    {
+        m_Pens.push_back(pen);
+    }
+
+    std::vector<QuaternionSpinningPen>& GetPens()
+    {
+        return m_Pens;
+    }
+
+    const std::vector<QuaternionSpinningPen>& GetPens() const
+    {
+        return m_Pens;
+    }
+
+    void Step(double deltaT)
+    {
+        for (QuaternionSpinningPen& pen : m_Pens)
+        {
+            m_Integrator.Step(pen, deltaT);
+        }
+
+        const Contacts::Stats& stats = m_Solver.Resolve(m_Pens);
+        m_TotalStats.m_CandidatePairs += stats.m_CandidatePairs;
+        m_TotalStats.m_PairHits += stats.m_PairHits;
+        m_TotalStats.m_GroundHits += stats.m_GroundHits;
+        m_ElapsedTime += deltaT;
+    }
+
+    // Steps until duration, like Simulation::Run().
+    void Run(double duration, double deltaT)
+    {
+        while (m_ElapsedTime < duration)
+        {
+            Step(deltaT);
+        }
+    }
+
+    double GetElapsedTime() const
+    {
+        return m_ElapsedTime;
+    }
+
+    // Broadphase and narrowphase counts of the last step.
+    const Contacts::Stats& GetContactStats() const
+    {
+        return m_Solver.GetStats();
+    }
+
+    // The same counts summed over all steps.
+    const Contacts::Stats& GetTotalContactStats() const
+    {
+        return m_TotalStats;
+    }
+
+private:
+    std::vector<QuaternionSpinningPen> m_Pens;
+    Integrator<QuaternionSpinningPen> m_Integrator;
+    Contacts::Solver m_Solver;
+    Contacts::Stats m_TotalStats;
+    double m_ElapsedTime = 0.0;     // in seconds.
+};
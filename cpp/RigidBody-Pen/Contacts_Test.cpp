@@ -0,0 +1,159 @@
+#include "./Contacts.h"
+#include "./DynamicEntities.h"
+#include "./TestUtils.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Contacts Unit Tests
+//////////////////////////////////////////////////////////
+
+// Pen lying along world x, at rest unless given a velocity.
+static QuaternionSpinningPen FlatPen(double x, double z, double velX)
+{
+    const std::array<double, 4> q = QuaternionSpinningPen::QuaternionFromEulerAngles(0.0, M_PI / 2.0, 0.0);
+    const Contacts::Config config;
+    const double transverse = config.m_Mass * 4.0 * config.m_HalfLength * config.m_HalfLength / 12.0;
+    const double axial = 0.5 * config.m_Mass * config.m_Radius * config.m_Radius;
+
+    return QuaternionSpinningPen(QuaternionSpinningPen::State{
+        x, 0.0, z, q[0], q[1], q[2], q[3], velX, 0.0, 0.0, 0.0, 0.0, 0.0}, {transverse, transverse, axial});
+}
+
+int main(void)
+{
+    //////////////////////////////////////////////////////////
+    // Test closest points of crossing and parallel segments.
+    {
+        const auto crossing = Contacts::ClosestSegmentParams({-1.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.5, -1.0, 1.0}, {0.5, 3.0, 1.0});
+        const auto parallel = Contacts::ClosestSegmentParams({0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {3.0, 1.0, 0.0});
+
+        const bool closestEq =
+            std::abs(crossing.first - 0.75) < 1e-12 && std::abs(crossing.second - 0.25) < 1e-12 &&
+            std::abs(parallel.first - 0.75) < 1e-12 && std::abs(parallel.second - 0.25) < 1e-12;
+        TestUtils::ReportResults(closestEq, "Contacts Test: Closest Segment Points");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test zero length segments, eg of pens with no half length,
+    // are treated as points.
+    {
+        const Contacts::Vec3 point{0.5, 1.0, 0.0};
+        const auto pointSegment = Contacts::ClosestSegmentParams(point, point, {0.0, 0.0, 0.0}, {2.0, 0.0, 0.0});
+        const auto segmentPoint = Contacts::ClosestSegmentParams({0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, point, point);
+        const auto pointPoint = Contacts::ClosestSegmentParams(point, point, {3.0, 0.0, 0.0}, {3.0, 0.0, 0.0});
+
+        const bool pointsEq =
+            pointSegment.first == 0.0 && std::abs(pointSegment.second - 0.25) < 1e-12 &&
+            std::abs(segmentPoint.first - 0.25) < 1e-12 && segmentPoint.second == 0.0 &&
+            pointPoint.first == 0.0 && pointPoint.second == 0.0;
+        TestUtils::ReportResults(pointsEq, "Contacts Test: Zero Length Segments");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test an elastic head on collision of pens with zero half
+    // length, ie spheres, swaps their velocities.
+    {
+        Contacts::Config config;
+        config.m_HalfLength = 0.0;
+        config.m_Restitution = 1.0;
+        const double sphere = 0.4 * config.m_Mass * config.m_Radius * config.m_Radius;
+        PenContactScene<> scene(config);
+        scene.Add(QuaternionSpinningPen(QuaternionSpinningPen::State{
+            -0.05, 0.0, 10.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0}, {sphere, sphere, sphere}));
+        scene.Add(QuaternionSpinningPen(QuaternionSpinningPen::State{
+            0.05, 0.0, 10.0, 1.0, 0.0, 0.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 0.0}, {sphere, sphere, sphere}));
+        scene.Run(0.1, .001);
+
+        const std::vector<QuaternionSpinningPen>& pens = scene.GetPens();
+        const bool sphereEq =
+            std::abs(pens[0].m_State[7] + 1.0) < 1e-9 &&
+            std::abs(pens[1].m_State[7] - 1.0) < 1e-9 &&
+            std::isfinite(pens[0].m_State[0]) && std::isfinite(pens[1].m_State[0]) &&
+            scene.GetTotalContactStats().m_PairHits >= 1;
+        TestUtils::ReportResults(sphereEq, "Contacts Test: Zero Half Length Pens");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a flat pen dropped with no restitution comes to rest
+    // on the ground, level.
+    {
+        Contacts::Config config;
+        config.m_Restitution = 0.0;
+        PenContactScene<> scene(config);
+        scene.Add(FlatPen(0.0, 0.5, 0.0));
+        scene.Run(1.0, .001);
+
+        const QuaternionSpinningPen& pen = scene.GetPens()[0];
+        const bool restEq =
+            std::abs(pen.m_State[2] - config.m_Radius) < 1e-3 &&
+            std::abs(pen.m_State[9]) < 0.02 &&
+            std::abs(pen.GetEulerAngles()[1] - M_PI / 2.0) < 1e-6 &&
+            scene.GetContactStats().m_GroundHits == 2;
+        TestUtils::ReportResults(restEq, "Contacts Test: Ground Rest");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test an elastic head on collision of end caps swaps the
+    // pens' velocities without spinning them up.
+    {
+        Contacts::Config config;
+        config.m_Restitution = 1.0;
+        PenContactScene<> scene(config);
+        scene.Add(FlatPen(-0.2, 10.0, 1.0));
+        scene.Add(FlatPen(0.2, 10.0, -1.0));
+        scene.Run(0.3, .001);
+
+        const std::vector<QuaternionSpinningPen>& pens = scene.GetPens();
+        const bool swapEq =
+            std::abs(pens[0].m_State[7] + 1.0) < 1e-9 &&
+            std::abs(pens[1].m_State[7] - 1.0) < 1e-9 &&
+            std::abs(pens[0].m_State[11]) < 1e-9 &&
+            scene.GetTotalContactStats().m_PairHits >= 1 &&
+            scene.GetContactStats().m_PairHits == 0;
+        TestUtils::ReportResults(swapEq, "Contacts Test: Elastic Head On");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test the broadphase finds every contact all pairs does,
+    // from far fewer candidates.
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> position(0.0, 1.0);
+        std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+
+        std::vector<QuaternionSpinningPen> pens;
+        for (int i = 0; i < 1000; ++i)
+        {
+            const std::array<double, 4> q = QuaternionSpinningPen::QuaternionFromEulerAngles(angle(rng), angle(rng) / 2.0, angle(rng));
+            pens.push_back(QuaternionSpinningPen(QuaternionSpinningPen::State{
+                position(rng), position(rng), position(rng), q[0], q[1], q[2], q[3],
+                position(rng) - 0.5, position(rng) - 0.5, position(rng) - 0.5, 0.0, 0.0, 0.0}, {3.3e-5, 3.3e-5, 2.5e-7}));
+        }
+        std::vector<QuaternionSpinningPen> bruteForcePens = pens;
+
+        Contacts::Solver broadphase;
+        Contacts::Config bruteForceConfig;
+        bruteForceConfig.m_UseBroadphase = false;
+        Contacts::Solver bruteForce(bruteForceConfig);
+
+        const Contacts::Stats broadStats = broadphase.Resolve(pens);
+        const Contacts::Stats bruteStats = bruteForce.Resolve(bruteForcePens);
+
+        bool broadphaseEq =
+            broadStats.m_PairHits > 0 &&
+            broadStats.m_PairHits == bruteStats.m_PairHits &&
+            broadStats.m_GroundHits == bruteStats.m_GroundHits &&
+            bruteStats.m_CandidatePairs == 1000 * 999 / 2 &&
+            broadStats.m_CandidatePairs < bruteStats.m_CandidatePairs / 20;
+        for (size_t i = 0; i < pens.size(); ++i)
+        {
+            broadphaseEq = broadphaseEq && pens[i].m_State == bruteForcePens[i].m_State;
+        }
+        TestUtils::ReportResults(broadphaseEq, "Contacts Test: Broadphase Matches All Pairs");
+    }
+
+    return 0;
+}
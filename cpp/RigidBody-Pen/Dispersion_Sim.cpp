@@ -0,0 +1,196 @@
+#include "./DynamicEntities.h"
+#include "./EnsembleRunner.h"
+#include "./OnlineStats.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Dispersion_Sim
+// Descr: Monte Carlo dispersion of the spinning pen. Streams
+// initial conditions in, runs them across all cores and
+// writes only summary statistics of the final states, as
+// JSON, so memory stays flat however many samples there are.
+// Usage: ./Dispersion_Sim <input|-> [duration] [dt] [--binary]
+// Input is one pen per CSV row, the 12 CrudeSpinningPen state
+// fields optionally followed by the 3 inertia components, or
+// with --binary (or a .bin file) 15 raw doubles per pen. Rows
+// which are not numbers, eg a header, are skipped.
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+using Runner = EnsembleRunner<CrudeSpinningPen, Integrators::RK4>;
+
+const std::array<double, 3> DefaultInertia = {10.0, 10.0, 1.0};
+const size_t BatchSize = 1 << 16;
+
+bool ParseCsvRow(const std::string& line, CrudeSpinningPen& outPen)
+{
+    std::vector<double> values;
+    std::stringstream row(line);
+    std::string cell;
+    while (std::getline(row, cell, ','))
+    {
+        try
+        {
+            values.push_back(std::stod(cell));
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    if (values.size() != 12 && values.size() != 15)
+    {
+        return false;
+    }
+
+    CrudeSpinningPen::State state;
+    std::copy(values.begin(), values.begin() + 12, state.begin());
+    std::array<double, 3> inertia = DefaultInertia;
+    if (values.size() == 15)
+    {
+        std::copy(values.begin() + 12, values.end(), inertia.begin());
+    }
+
+    outPen = CrudeSpinningPen(state, inertia);
+    return true;
+}
+
+// Reads up to BatchSize scenarios. Returns false at end of input.
+bool ReadBatch(std::istream& in, bool binary, double duration, double deltaT, std::vector<Runner::Scenario>& outScenarios)
+{
+    outScenarios.clear();
+    CrudeSpinningPen pen(CrudeSpinningPen::State{}, DefaultInertia);
+
+    while (outScenarios.size() < BatchSize)
+    {
+        if (binary)
+        {
+            std::array<double, 15> record;
+            if (!in.read(reinterpret_cast<char*>(record.data()), sizeof(record)))
+            {
+                break;
+            }
+
+            CrudeSpinningPen::State state;
+            std::copy(record.begin(), record.begin() + 12, state.begin());
+            pen = CrudeSpinningPen(state, {record[12], record[13], record[14]});
+        }
+        else
+        {
+            std::string line;
+            if (!std::getline(in, line))
+            {
+                break;
+            }
+            if (!ParseCsvRow(line, pen))
+            {
+                continue;
+            }
+        }
+
+        outScenarios.push_back(Runner::Scenario{duration, deltaT, pen});
+    }
+
+    return !outScenarios.empty();
+}
+
+void WriteSummary(std::ostream& out, const StateStatistics<CrudeSpinningPen::State>& stats, uint64_t numInvalid)
+{
+    const std::array<double, 5> quantiles = {0.01, 0.05, 0.5, 0.95, 0.99};
+    const size_t numFields = CrudeSpinningPen::FieldNames.size();
+
+    out << "{\n  \"entity\": \"" << CrudeSpinningPen::Name << "\",\n"
+        << "  \"count\": " << stats.Count() << ",\n"
+        << "  \"invalid\": " << numInvalid << ",\n"
+        << "  \"fields\": {\n";
+    for (size_t field = 0; field < numFields; ++field)
+    {
+        out << "    \"" << CrudeSpinningPen::FieldNames[field] << "\": {"
+            << "\"mean\": " << stats.GetMean()[field]
+            << ", \"std\": " << std::sqrt(stats.GetVariance(field))
+            << ", \"min\": " << stats.GetMin()[field]
+            << ", \"max\": " << stats.GetMax()[field];
+        for (double q : quantiles)
+        {
+            out << ", \"p" << static_cast<int>(q * 100.0 + 0.5) << "\": " << stats.GetQuantile(field, q);
+        }
+        out << "}" << (field + 1 < numFields ? ",\n" : "\n");
+    }
+
+    out << "  },\n  \"covariance\": [\n";
+    for (size_t i = 0; i < numFields; ++i)
+    {
+        out << "    [";
+        for (size_t j = 0; j < numFields; ++j)
+        {
+            out << stats.GetCovariance(i, j) << (j + 1 < numFields ? ", " : "");
+        }
+        out << "]" << (i + 1 < numFields ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: ./Dispersion_Sim <input|-> [duration] [dt] [--binary]\n";
+        return 1;
+    }
+
+    const std::string path = argv[1];
+    double duration = 2.04;
+    double deltaT = .01;
+    bool binary = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+    for (int arg = 2, positional = 0; arg < argc; ++arg)
+    {
+        const std::string value = argv[arg];
+        if (value == "--binary")
+        {
+            binary = true;
+        }
+        else if (positional++ == 0)
+        {
+            duration = std::stod(value);
+        }
+        else
+        {
+            deltaT = std::stod(value);
+        }
+    }
+
+    std::ifstream file;
+    if (path != "-")
+    {
+        file.open(path, binary ? std::ios::binary : std::ios::in);
+        if (!file)
+        {
+            std::cout << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = (path == "-") ? std::cin : file;
+
+    Runner runner;
+    StateStatistics<CrudeSpinningPen::State> stats;
+    uint64_t numInvalid = 0;
+
+    std::vector<Runner::Scenario> scenarios;
+    while (ReadBatch(in, binary, duration, deltaT, scenarios))
+    {
+        numInvalid += runner.Accumulate(scenarios.begin(), scenarios.end(), stats);
+    }
+
+    WriteSummary(std::cout, stats, numInvalid);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////
+// Dual
+// Descr: Scalar types for entities and integrators. Dual
+// numbers carry the gradient of a value with respect to N
+// seeded inputs through every arithmetic operation, ie
+// forward mode automatic differentiation, so a simulation
+// over Dual scalars yields exact derivatives of its final
+// state in the same pass.
+//////////////////////////////////////////////////////////
+
+template <size_t N>
+class Dual
+{
+public:
+
+    Dual() = default;
+
+    Dual(double value)
+    : m_Value(value)
+    {}
+
+    Dual(double value, const std::array<double, N>& grad)
+    : m_Value(value)
+    , m_Grad(grad)
+    {}
+
+    // Input number index, ie d(value)/d(input index) = 1.
+    static Dual Variable(double value, size_t index)
+    {
+        Dual variable(value);
+        variable.m_Grad[index] = 1.0;
+        return variable;
+    }
+
+    explicit operator double() const
+    {
+        return m_Value;
+    }
+
+    Dual& operator+=(const Dual& other)
+    {
+        m_Value += other.m_Value;
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_Grad[i] += other.m_Grad[i];
+        }
+        return *this;
+    }
+
+    Dual& operator-=(const Dual& other)
+    {
+        m_Value -= other.m_Value;
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_Grad[i] -= other.m_Grad[i];
+        }
+        return *this;
+    }
+
+    Dual& operator*=(const Dual& other)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_Grad[i] = m_Grad[i] * other.m_Value + m_Value * other.m_Grad[i];
+        }
+        m_Value *= other.m_Value;
+        return *this;
+    }
+
+    Dual& operator/=(const Dual& other)
+    {
+        m_Value /= other.m_Value;
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_Grad[i] = (m_Grad[i] - m_Value * other.m_Grad[i]) / other.m_Value;
+        }
+        return *this;
+    }
+
+    // Plain doubles only scale the gradient. Values are computed
+    // exactly as for double, so a Dual run reproduces a double one.
+    Dual& operator*=(double scale)
+    {
+        m_Value *= scale;
+        for (double& grad : m_Grad)
+        {
+            grad *= scale;
+        }
+        return *this;
+    }
+
+    Dual& operator/=(double scale)
+    {
+        m_Value /= scale;
+        for (double& grad : m_Grad)
+        {
+            grad /= scale;
+        }
+        return *this;
+    }
+
+    friend Dual operator-(Dual a)
+    {
+        return a *= -1.0;
+    }
+
+    friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+    friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+    friend Dual operator*(Dual a, const Dual& b) { return a *= b; }
+    friend Dual operator/(Dual a, const Dual& b) { return a /= b; }
+    friend Dual operator*(Dual a, double b) { return a *= b; }
+    friend Dual operator*(double a, Dual b) { return b *= a; }
+    friend Dual operator/(Dual a, double b) { return a /= b; }
+
+    // Identical value and gradient, eg for caching on a state.
+    friend bool operator==(const Dual& a, const Dual& b) { return a.m_Value == b.m_Value && a.m_Grad == b.m_Grad; }
+    friend bool operator!=(const Dual& a, const Dual& b) { return !(a == b); }
+
+    // Ordering is by value only.
+    friend bool operator<(const Dual& a, const Dual& b) { return a.m_Value < b.m_Value; }
+    friend bool operator>(const Dual& a, const Dual& b) { return a.m_Value > b.m_Value; }
+    friend bool operator<=(const Dual& a, const Dual& b) { return a.m_Value <= b.m_Value; }
+    friend bool operator>=(const Dual& a, const Dual& b) { return a.m_Value >= b.m_Value; }
+
+    // Found by argument dependent lookup, so generic code calls
+    // them unqualified after using std::sqrt and so on.
+    friend Dual sqrt(const Dual& a)
+    {
+        const double value = std::sqrt(a.m_Value);
+        return Chain(a, value, 0.5 / value);
+    }
+
+    friend Dual sin(const Dual& a)
+    {
+        return Chain(a, std::sin(a.m_Value), std::cos(a.m_Value));
+    }
+
+    friend Dual cos(const Dual& a)
+    {
+        return Chain(a, std::cos(a.m_Value), -std::sin(a.m_Value));
+    }
+
+    friend Dual exp(const Dual& a)
+    {
+        const double value = std::exp(a.m_Value);
+        return Chain(a, value, value);
+    }
+
+    friend Dual abs(const Dual& a)
+    {
+        return a.m_Value < 0.0 ? -a : a;
+    }
+
+    double m_Value = 0.0;
+    std::array<double, N> m_Grad{};    // d(m_Value)/d(input i).
+
+private:
+
+    // f(a) given f(a.m_Value) and f'(a.m_Value).
+    static Dual Chain(const Dual& a, double value, double slope)
+    {
+        Dual result(value);
+        for (size_t i = 0; i < N; ++i)
+        {
+            result.m_Grad[i] = slope * a.m_Grad[i];
+        }
+        return result;
+    }
+};
+
+// Plain value of any scalar, eg for error norms, step size control
+// and reporting, which are not differentiated.
+template <typename Scalar>
+double ScalarValue(const Scalar& value)
+{
+    return static_cast<double>(value);
+}
@@ -1,92 +1,192 @@
 # pragma once
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <ostream>
+#include <stddef.h>
+
+#include "./Dual.h"
+#include "./StateVector.h"
 
 //////////////////////////////////////////////////////////
 // DynamicEntities
 // Descr: Different entities which may be used with 
-// Simulation
+// Simulation. Each is a template over its scalar type, eg
+// float or Dual, with the double version under the plain
+// name. Params are the constant parameters of the dynamics
+// and Rebind the same entity over another scalar, which
+// Sensitivity.h uses to seed derivatives.
 //////////////////////////////////////////////////////////
 
 // Represents particle moving with a constant velocity.
-class ConstantVelParticle
+template <typename Scalar = double>
+class ConstantVelParticleT
 {
 public:
-    using State = std::array<double, 2>;
+    using State = StateVector<Scalar, 2>;
+
+    static constexpr size_t NumParams = 0;
+    using Params = std::array<Scalar, NumParams>;
+
+    template <typename OtherScalar>
+    using Rebind = ConstantVelParticleT<OtherScalar>;
+
+    // Entity and state field names, eg for trajectory files and text output.
+    static constexpr const char* Name = "ConstantVelParticle";
+    static constexpr const char* ShortName = "CVP";
+    static constexpr std::array<const char*, 2> FieldNames{"x", "vel_x"};
+
+    static constexpr bool HasPositionOnlyAccelerations = true;     // See Integrators::SupportsVelocityVerlet.
+
+    ConstantVelParticleT(const State& initialState)
+    : m_State(initialState)
+    {}
 
-    ConstantVelParticle(const State& initialState)
+    ConstantVelParticleT(const State& initialState, const Params&)
     : m_State(initialState)
     {}
 
+    Params GetParams() const
+    {
+        return Params{};
+    }
+
     State CalcDerivs() const
     {
-        return State{ m_State[1], 0.0};
+        return CalcDerivs(m_State);
     }
 
-    const std::string ReportState() const
+    // Derivatives at an arbitrary state, eg an integrator stage.
+    State CalcDerivs(const State& state) const
     {
-        std::string out = 
-            "CVP: x = " + 
-            std::to_string(m_State[0]) + 
-            ", vel_x = " +
-            std::to_string(m_State[1]) + "\n";
+        return State{ state[1], 0.0};
+    }
 
-        return out;
+    // Analytic Jacobian of CalcDerivs, for implicit integrators.
+    std::array<State, 2> CalcJacobian(const State&) const
+    {
+        return {State{0.0, 1.0}, State{0.0, 0.0}};
     }
 
     State m_State; 
 };
 
+using ConstantVelParticle = ConstantVelParticleT<double>;
+
 // Simple harmonic motion.
-class SimpleSpringMotion
+template <typename Scalar = double>
+class SimpleSpringMotionT
 {
 public:
-    using State = std::array<double, 2>;
+    using State = StateVector<Scalar, 2>;
+
+    // Spring constant over mass.
+    static constexpr size_t NumParams = 1;
+    using Params = std::array<Scalar, NumParams>;
+
+    template <typename OtherScalar>
+    using Rebind = SimpleSpringMotionT<OtherScalar>;
 
-    SimpleSpringMotion(const State& initialState, double kOverM)
+    // Entity and state field names, eg for trajectory files and text output.
+    static constexpr const char* Name = "SimpleSpringMotion";
+    static constexpr const char* ShortName = "SHO";
+    static constexpr std::array<const char*, 2> FieldNames{"x", "vel_x"};
+
+    static constexpr bool HasPositionOnlyAccelerations = true;     // See Integrators::SupportsVelocityVerlet.
+
+    SimpleSpringMotionT(const State& initialState, Scalar kOverM)
     : m_State(initialState), m_KOverM(kOverM)
     {}
 
+    SimpleSpringMotionT(const State& initialState, const Params& params)
+    : m_State(initialState), m_KOverM(params[0])
+    {}
+
+    Params GetParams() const
+    {
+        return Params{m_KOverM};
+    }
+
     State CalcDerivs() const
     {
-        return State{ m_State[1], -m_KOverM*m_State[0]};
+        return CalcDerivs(m_State);
     }
 
-    const std::string ReportState() const
+    // Derivatives at an arbitrary state, eg an integrator stage.
+    State CalcDerivs(const State& state) const
     {
-       std::string out = 
-            "SHO: x = " + 
-            std::to_string(m_State[0]) + 
-            ", vel_x = " +
-            std::to_string(m_State[1]) + "\n";
+        return State{ state[1], -m_KOverM*state[0]};
+    }
 
-        return out;
+    // Analytic Jacobian of CalcDerivs, for implicit integrators.
+    std::array<State, 2> CalcJacobian(const State&) const
+    {
+        return {State{0.0, 1.0}, State{-m_KOverM, 0.0}};
+    }
+
+    // Quantities the exact dynamics conserve, for drift monitoring,
+    // see Invariants.h. Kinetic plus potential energy, over mass.
+    static constexpr std::array<const char*, 1> ConservedNames{"energy"};
+
+    std::array<Scalar, 1> ConservedQuantities() const
+    {
+        return ConservedQuantities(m_State);
+    }
+
+    std::array<Scalar, 1> ConservedQuantities(const State& state) const
+    {
+        return {(state[1]*state[1] + m_KOverM*state[0]*state[0]) / 2};
     }
 
     State m_State;
 
 private:
-    double m_KOverM;
+    Scalar m_KOverM;
 };
 
+using SimpleSpringMotion = SimpleSpringMotionT<double>;
+
 // Pen class implementation. Encapsulates dynamics of a spinning pen,
 // crudely, as name suggests. Dynamics are that of a freely spinning 
 // rigid body under gravity only. All other forces are neglected.  
 // Rotational motion described by Euler's equations. Clients specify 
 // intertia tensor as a diagonal in principle axis frame. Angular rotations 
 // are represented by Tait Bryan angles.
-class CrudeSpinningPen
+template <typename Scalar = double>
+class CrudeSpinningPenT
 {
 public:
-   using State = std::array<double, 12>;
+    using State = StateVector<Scalar, 12>;
+
+    // Principal moments of inertia.
+    static constexpr size_t NumParams = 3;
+    using Params = std::array<Scalar, NumParams>;
+
+    template <typename OtherScalar>
+    using Rebind = CrudeSpinningPenT<OtherScalar>;
 
-    CrudeSpinningPen(const State initialState, const std::array<double, 3> inertiaTensor)
+    // Entity and state field names, eg for trajectory files and text output.
+    static constexpr const char* Name = "CrudeSpinningPen";
+    static constexpr const char* ShortName = "CSP";
+    static constexpr std::array<const char*, 12> FieldNames{
+        "x", "y", "z",
+        "theta", "phi", "psi",
+        "vel_x", "vel_y", "vel_z",
+        "theta_dot", "phi_dot", "psi_dot"};
+
+    CrudeSpinningPenT(const State initialState, const std::array<Scalar, 3> inertiaTensor)
         : m_State(initialState)
         , m_Inertia(inertiaTensor)
         {}
 
     State CalcDerivs() const
+    {
+        return CalcDerivs(m_State);
+    }
+
+    // Derivatives at an arbitrary state, eg an integrator stage.
+    State CalcDerivs(const State& state) const
     {
         State derivs;
 
@@ -94,7 +194,7 @@ public:
         // Eg, dx/dt = V_x, and so on.
         for(uint8_t i = 0; i < 6; ++i)
         {
-            derivs[i] = m_State[i+6];
+            derivs[i] = state[i+6];
         }
 
         // Derivatives of center of mass coords.
@@ -108,46 +208,235 @@ public:
         // to rigid body motion - these are Euler's equations
         // of Rigid body dynamics - see 
         // https://en.wikipedia.org/wiki/Euler%27s_equations_(rigid_body_dynamics)
-        derivs[9] = m_State[10]*m_State[11]*(m_Inertia[1] - m_Inertia[2])/m_Inertia[0]; 
-        derivs[10] = m_State[11]*m_State[9]*(m_Inertia[2] - m_Inertia[0])/m_Inertia[1];
-        derivs[11] = m_State[9]*m_State[10]*(m_Inertia[0] - m_Inertia[1])/m_Inertia[2];
+        derivs[9] = state[10]*state[11]*(m_Inertia[1] - m_Inertia[2])/m_Inertia[0]; 
+        derivs[10] = state[11]*state[9]*(m_Inertia[2] - m_Inertia[0])/m_Inertia[1];
+        derivs[11] = state[9]*state[10]*(m_Inertia[0] - m_Inertia[1])/m_Inertia[2];
+
+        return derivs;
+    }
+
+    // Quantities the exact dynamics conserve, for drift monitoring,
+    // see Invariants.h. Rotational energy and the magnitude of the
+    // body frame angular momentum, from m_Inertia, then translational
+    // energy and horizontal momentum, over mass.
+    static constexpr std::array<const char*, 5> ConservedNames{
+        "rot_energy", "ang_momentum", "trans_energy", "momentum_x", "momentum_y"};
+
+    std::array<Scalar, 5> ConservedQuantities() const
+    {
+        return ConservedQuantities(m_State);
+    }
+
+    std::array<Scalar, 5> ConservedQuantities(const State& state) const
+    {
+        using std::sqrt;
+        const Scalar lx = m_Inertia[0]*state[9], ly = m_Inertia[1]*state[10], lz = m_Inertia[2]*state[11];
+
+        return std::array<Scalar, 5>{
+            (lx*state[9] + ly*state[10] + lz*state[11]) / 2,
+            sqrt(lx*lx + ly*ly + lz*lz),
+            (state[6]*state[6] + state[7]*state[7] + state[8]*state[8]) / 2 + static_cast<Scalar>(9.8)*state[2],
+            state[6],
+            state[7]};
+    }
+
+    const std::array<Scalar, 3>& GetInertia() const
+    {
+        return m_Inertia;
+    }
+
+    Params GetParams() const
+    {
+        return m_Inertia;
+    }
+
+    State m_State;
+
+private:
+    std::array<Scalar, 3> m_Inertia;
+};
+
+using CrudeSpinningPen = CrudeSpinningPenT<double>;
+
+// Spinning pen with orientation stored as a unit quaternion, the
+// body to world rotation. Same dynamics as CrudeSpinningPen, ie
+// free rigid body under gravity, but the orientation kinematics are
+// exact for any rotation and have no gimbal lock singularity, which
+// allows much larger time steps. Angular velocity is in the body
+// (principal axis) frame. Euler angles only exist for reporting.
+template <typename Scalar = double>
+class QuaternionSpinningPenT
+{
+public:
+    using State = StateVector<Scalar, 13>;
+
+    // Principal moments of inertia.
+    static constexpr size_t NumParams = 3;
+    using Params = std::array<Scalar, NumParams>;
+
+    template <typename OtherScalar>
+    using Rebind = QuaternionSpinningPenT<OtherScalar>;
+
+    // Entity and state field names, eg for trajectory files and text output.
+    static constexpr const char* Name = "QuaternionSpinningPen";
+    static constexpr const char* ShortName = "QSP";
+    static constexpr std::array<const char*, 13> FieldNames{
+        "x", "y", "z",
+        "q_w", "q_x", "q_y", "q_z",
+        "vel_x", "vel_y", "vel_z",
+        "omega_x", "omega_y", "omega_z"};
+
+    QuaternionSpinningPenT(const State initialState, const std::array<Scalar, 3> inertiaTensor)
+        : m_State(initialState)
+        , m_Inertia(inertiaTensor)
+        {
+            ProjectState(m_State);
+        }
+
+    State CalcDerivs() const
+    {
+        return CalcDerivs(m_State);
+    }
+
+    // Derivatives at an arbitrary state, eg an integrator stage.
+    State CalcDerivs(const State& state) const
+    {
+        State derivs;
+
+        // Center of mass, dx/dt = V_x, and so on.
+        derivs[0] = state[7];
+        derivs[1] = state[8];
+        derivs[2] = state[9];
+
+        // Quaternion kinematics, dq/dt = 1/2 q * (0, omega).
+        const Scalar qw = state[3], qx = state[4], qy = state[5], qz = state[6];
+        const Scalar wx = state[10], wy = state[11], wz = state[12];
+        derivs[3] = 0.5*(-qx*wx - qy*wy - qz*wz);
+        derivs[4] = 0.5*( qw*wx + qy*wz - qz*wy);
+        derivs[5] = 0.5*( qw*wy + qz*wx - qx*wz);
+        derivs[6] = 0.5*( qw*wz + qx*wy - qy*wx);
+
+        // Gravity only.
+        derivs[7] = 0;      // m/s/s
+        derivs[8] = 0;      // m/s/s
+        derivs[9] = -9.8;   // m/s/s - acceleration due to gravity
+
+        // Euler's equations, as in CrudeSpinningPen.
+        derivs[10] = wy*wz*(m_Inertia[1] - m_Inertia[2])/m_Inertia[0];
+        derivs[11] = wz*wx*(m_Inertia[2] - m_Inertia[0])/m_Inertia[1];
+        derivs[12] = wx*wy*(m_Inertia[0] - m_Inertia[1])/m_Inertia[2];
 
         return derivs;
     }
 
-    const std::string ReportState() const
-    {
-       std::string out = 
-            "CSP: x = " + 
-            std::to_string(m_State[0]) + 
-            ", y = " + 
-            std::to_string(m_State[1]) + 
-            ", z = " + 
-            std::to_string(m_State[2]) + 
-            ",\n theta = " + 
-            std::to_string(m_State[3]) + 
-            ", phi = " + 
-            std::to_string(m_State[4]) + 
-            ", psi = " + 
-            std::to_string(m_State[5]) + 
-            ",\n vel_x = " +
-            std::to_string(m_State[6]) +
-            ", vel_y = " +
-            std::to_string(m_State[7]) + 
-            ", vel_z = " +
-            std::to_string(m_State[8]) + 
-            ",\n theta_dot = " +
-            std::to_string(m_State[9]) +
-            ", phi_dot = " +
-            std::to_string(m_State[10]) + 
-            ", psi_dot = " +
-            std::to_string(m_State[11]) + "\n";
-
-        return out;
+    // Quantities the exact dynamics conserve, as for CrudeSpinningPen.
+    static constexpr std::array<const char*, 5> ConservedNames{
+        "rot_energy", "ang_momentum", "trans_energy", "momentum_x", "momentum_y"};
+
+    std::array<Scalar, 5> ConservedQuantities() const
+    {
+        return ConservedQuantities(m_State);
+    }
+
+    std::array<Scalar, 5> ConservedQuantities(const State& state) const
+    {
+        using std::sqrt;
+        const Scalar lx = m_Inertia[0]*state[10], ly = m_Inertia[1]*state[11], lz = m_Inertia[2]*state[12];
+
+        return std::array<Scalar, 5>{
+            (lx*state[10] + ly*state[11] + lz*state[12]) / 2,
+            sqrt(lx*lx + ly*ly + lz*lz),
+            (state[7]*state[7] + state[8]*state[8] + state[9]*state[9]) / 2 + static_cast<Scalar>(9.8)*state[2],
+            state[7],
+            state[8]};
+    }
+
+    // Integrators call this after each step to pull the quaternion
+    // back onto the unit sphere.
+    void ProjectState(State& state) const
+    {
+        using std::sqrt;
+        const Scalar norm = sqrt(state[3]*state[3] + state[4]*state[4] + state[5]*state[5] + state[6]*state[6]);
+        for (size_t i = 3; i < 7; ++i)
+        {
+            state[i] /= norm;
+        }
+    }
+
+    // Tait Bryan angles {theta, phi, psi}, ie rotations about body x, y
+    // and z applied in z-y-x order, matching CrudeSpinningPen's names.
+    std::array<double, 3> GetEulerAngles() const
+    {
+        const double qw = ScalarValue(m_State[3]), qx = ScalarValue(m_State[4]), qy = ScalarValue(m_State[5]), qz = ScalarValue(m_State[6]);
+        const double sinPhi = std::clamp(2.0*(qw*qy - qz*qx), -1.0, 1.0);
+
+        return std::array<double, 3>{
+            std::atan2(2.0*(qw*qx + qy*qz), 1.0 - 2.0*(qx*qx + qy*qy)),
+            std::asin(sinPhi),
+            std::atan2(2.0*(qw*qz + qx*qy), 1.0 - 2.0*(qy*qy + qz*qz))};
+    }
+
+    // Unit quaternion {w, x, y, z} for Tait Bryan angles as returned by
+    // GetEulerAngles, eg to build an initial state.
+    static std::array<double, 4> QuaternionFromEulerAngles(double theta, double phi, double psi)
+    {
+        const double cx = std::cos(0.5*theta), sx = std::sin(0.5*theta);
+        const double cy = std::cos(0.5*phi), sy = std::sin(0.5*phi);
+        const double cz = std::cos(0.5*psi), sz = std::sin(0.5*psi);
+
+        return std::array<double, 4>{
+            cz*cy*cx + sz*sy*sx,
+            cz*cy*sx - sz*sy*cx,
+            cz*sy*cx + sz*cy*sx,
+            sz*cy*cx - cz*sy*sx};
+    }
+
+    // Rotates a body frame vector into the world frame.
+    std::array<Scalar, 3> BodyToWorld(const std::array<Scalar, 3>& v) const
+    {
+        const Scalar qw = m_State[3], qx = m_State[4], qy = m_State[5], qz = m_State[6];
+
+        // v + 2 q_v x (q_v x v + qw v)
+        const Scalar tx = qy*v[2] - qz*v[1] + qw*v[0];
+        const Scalar ty = qz*v[0] - qx*v[2] + qw*v[1];
+        const Scalar tz = qx*v[1] - qy*v[0] + qw*v[2];
+
+        return std::array<Scalar, 3>{
+            v[0] + 2*(qy*tz - qz*ty),
+            v[1] + 2*(qz*tx - qx*tz),
+            v[2] + 2*(qx*ty - qy*tx)};
+    }
+
+    // Rotates a world frame vector into the body frame.
+    std::array<Scalar, 3> WorldToBody(const std::array<Scalar, 3>& v) const
+    {
+        const Scalar qw = m_State[3], qx = -m_State[4], qy = -m_State[5], qz = -m_State[6];
+
+        // As BodyToWorld, with the conjugate quaternion.
+        const Scalar tx = qy*v[2] - qz*v[1] + qw*v[0];
+        const Scalar ty = qz*v[0] - qx*v[2] + qw*v[1];
+        const Scalar tz = qx*v[1] - qy*v[0] + qw*v[2];
+
+        return std::array<Scalar, 3>{
+            v[0] + 2*(qy*tz - qz*ty),
+            v[1] + 2*(qz*tx - qx*tz),
+            v[2] + 2*(qx*ty - qy*tx)};
+    }
+
+    const std::array<Scalar, 3>& GetInertia() const
+    {
+        return m_Inertia;
+    }
+
+    Params GetParams() const
+    {
+        return m_Inertia;
     }
 
     State m_State;
 
 private:
-    std::array<double, 3> m_Inertia;
-};
\ No newline at end of file
+    std::array<Scalar, 3> m_Inertia;
+};
+
+using QuaternionSpinningPen = QuaternionSpinningPenT<double>;
@@ -16,5 +16,42 @@ int main(void)
         TestUtils::ReportResults(testSpringDerivs, "Test: Spring Derivatives");
     }
 
+    //////////////////////////////////////////////////////////
+    // Test CalcDerivs at a given state uses that state, not m_State.
+    {
+        SimpleSpringMotion spring(SimpleSpringMotion::State{-1.0, 0.0}, 4);
+        SimpleSpringMotion::State springDerivs = spring.CalcDerivs(SimpleSpringMotion::State{2.0, 3.0});
+        bool testSpringDerivs = TestUtils::FloatEquals(SimpleSpringMotion::State{3.0, -8.0}, springDerivs, 1.0e-6);
+        TestUtils::ReportResults(testSpringDerivs, "Test: Spring Derivatives At State");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test CalcDerivs for quaternion pen spinning about body z.
+    {
+        QuaternionSpinningPen pen(QuaternionSpinningPen::State{
+            0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 2.0, 3.0, 0.0, 0.0, 4.0}, {10.0, 10.0, 1.0});
+        const QuaternionSpinningPen::State penDerivs = pen.CalcDerivs();
+        const QuaternionSpinningPen::State expected{
+            1.0, 2.0, 3.0, 0.0, 0.0, 0.0, 2.0, 0.0, 0.0, -9.8, 0.0, 0.0, 0.0};
+        bool testPenDerivs = TestUtils::FloatEquals(expected, penDerivs, 1.0e-12);
+        TestUtils::ReportResults(testPenDerivs, "Test: Quaternion Pen Derivatives");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test quaternion pen Euler angle round trip and rotation.
+    {
+        const std::array<double, 4> q = QuaternionSpinningPen::QuaternionFromEulerAngles(0.3, -0.4, 1.2);
+        QuaternionSpinningPen pen(QuaternionSpinningPen::State{
+            0.0, 0.0, 0.0, q[0], q[1], q[2], q[3], 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}, {10.0, 10.0, 1.0});
+        bool testAngles = TestUtils::FloatEquals(pen.GetEulerAngles(), std::array<double, 3>{0.3, -0.4, 1.2}, 1.0e-12);
+        TestUtils::ReportResults(testAngles, "Test: Quaternion Pen Euler Angles");
+
+        // Pure yaw of 90 degrees takes body x to world y.
+        const std::array<double, 4> yaw = QuaternionSpinningPen::QuaternionFromEulerAngles(0.0, 0.0, 0.5 * M_PI);
+        pen.m_State[3] = yaw[0]; pen.m_State[4] = yaw[1]; pen.m_State[5] = yaw[2]; pen.m_State[6] = yaw[3];
+        bool testRotate = TestUtils::FloatEquals(pen.BodyToWorld({1.0, 0.0, 0.0}), std::array<double, 3>{0.0, 1.0, 0.0}, 1.0e-12);
+        TestUtils::ReportResults(testRotate, "Test: Quaternion Pen Body To World");
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+# pragma once
+
+#include "./DynamicEntities.h"
+
+#include <algorithm>
+#include <array>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//////////////////////////////////////////////////////////
+// DynamicEntityBatches
+// Descr: Batched (structure of arrays) versions of
+// DynamicEntities. A batch advances many independent
+// instances of an entity per integrator step, so the
+// derivative kernels can use the full SIMD width.
+//////////////////////////////////////////////////////////
+
+// Primary template, specialized for each entity which has a
+// batched implementation. Batches are stepped by the EntityBatch
+// overloads of Integrators::EulerStep and Integrators::MidPointStep.
+template <typename DynamicEntity>
+class EntityBatch;
+
+// Batch of CrudeSpinningPen. State is stored column wise, ie
+// m_State[field][pen], so each state field of all pens is
+// contiguous in memory. Pens may have different inertia tensors.
+// Columns hold the pen's scalar type, a float batch fits twice
+// as many pens in each SIMD register as a double one.
+template <typename Scalar>
+class EntityBatch<CrudeSpinningPenT<Scalar>>
+{
+public:
+    using Pen = CrudeSpinningPenT<Scalar>;
+
+    static constexpr size_t NumFields = std::tuple_size<typename Pen::State>::value;
+
+    using Column = std::vector<Scalar>;
+    using State = std::array<Column, NumFields>;
+
+    explicit EntityBatch(const std::vector<Pen>& pens)
+    {
+        const size_t numPens = pens.size();
+
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_State[field].resize(numPens);
+            m_Derivs[field].resize(numPens);
+            m_Stage[field].resize(numPens);
+        }
+
+        for (Column& coeffs : m_EulerCoeffs)
+        {
+            coeffs.resize(numPens);
+        }
+
+        for (size_t pen = 0; pen < numPens; ++pen)
+        {
+            SetState(pen, pens[pen].m_State);
+
+            // Precompute the inertia ratios of Euler's equations so the
+            // kernel is multiply only.
+            const std::array<Scalar, 3>& inertia = pens[pen].GetInertia();
+            m_EulerCoeffs[0][pen] = (inertia[1] - inertia[2])/inertia[0];
+            m_EulerCoeffs[1][pen] = (inertia[2] - inertia[0])/inertia[1];
+            m_EulerCoeffs[2][pen] = (inertia[0] - inertia[1])/inertia[2];
+        }
+    }
+
+    size_t Size() const
+    {
+        return m_State[0].size();
+    }
+
+    // Same equations as CrudeSpinningPen::CalcDerivs, evaluated
+    // for every pen in the batch.
+    void CalcDerivs(const State& state, State& outDerivs) const
+    {
+        // Velocities, eg dx/dt = V_x, and so on.
+        for (size_t i = 0; i < 6; ++i)
+        {
+            std::copy(state[i+6].begin(), state[i+6].end(), outDerivs[i].begin());
+        }
+
+        // Gravity only.
+        std::fill(outDerivs[6].begin(), outDerivs[6].end(), Scalar(0.0));
+        std::fill(outDerivs[7].begin(), outDerivs[7].end(), Scalar(0.0));
+        std::fill(outDerivs[8].begin(), outDerivs[8].end(), Scalar(-9.8));
+
+        CalcEulerDerivs(state, outDerivs);
+    }
+
+    typename Pen::State GetState(size_t pen) const
+    {
+        typename Pen::State out;
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            out[field] = m_State[field][pen];
+        }
+
+        return out;
+    }
+
+    void SetState(size_t pen, const typename Pen::State& state)
+    {
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_State[field][pen] = state[field];
+        }
+    }
+
+    State m_State;
+
+    // Integrator workspace, sized like m_State and reused
+    // every step so stepping a batch never allocates.
+    State m_Derivs;
+    State m_Stage;
+
+private:
+
+    // Euler's equations of rigid body dynamics for all pens. Vectorized
+    // with AVX-512 or AVX2 when the compiler targets them, for double and
+    // float columns, the scalar loop handles the remainder and all other
+    // targets and scalar types.
+    void CalcEulerDerivs(const State& state, State& outDerivs) const
+    {
+        const Scalar* w0 = state[9].data();
+        const Scalar* w1 = state[10].data();
+        const Scalar* w2 = state[11].data();
+        const Scalar* c0 = m_EulerCoeffs[0].data();
+        const Scalar* c1 = m_EulerCoeffs[1].data();
+        const Scalar* c2 = m_EulerCoeffs[2].data();
+        Scalar* d0 = outDerivs[9].data();
+        Scalar* d1 = outDerivs[10].data();
+        Scalar* d2 = outDerivs[11].data();
+
+        const size_t numPens = Size();
+        size_t pen = 0;
+
+        if constexpr (std::is_same<Scalar, double>::value)
+        {
+            pen = CalcEulerDerivsDouble(w0, w1, w2, c0, c1, c2, d0, d1, d2, numPens);
+        }
+        else if constexpr (std::is_same<Scalar, float>::value)
+        {
+            pen = CalcEulerDerivsFloat(w0, w1, w2, c0, c1, c2, d0, d1, d2, numPens);
+        }
+
+        for (; pen < numPens; ++pen)
+        {
+            d0[pen] = w1[pen]*w2[pen]*c0[pen];
+            d1[pen] = w2[pen]*w0[pen]*c1[pen];
+            d2[pen] = w0[pen]*w1[pen]*c2[pen];
+        }
+    }
+
+    // SIMD part of CalcEulerDerivs for double columns. Returns the
+    // number of pens done.
+    static size_t CalcEulerDerivsDouble(const double* w0, const double* w1, const double* w2,
+        const double* c0, const double* c1, const double* c2,
+        double* d0, double* d1, double* d2, size_t numPens)
+    {
+        size_t pen = 0;
+
+#if defined(__AVX512F__)
+        for (; pen + 8 <= numPens; pen += 8)
+        {
+            const __m512d vw0 = _mm512_loadu_pd(w0 + pen);
+            const __m512d vw1 = _mm512_loadu_pd(w1 + pen);
+            const __m512d vw2 = _mm512_loadu_pd(w2 + pen);
+            _mm512_storeu_pd(d0 + pen, _mm512_mul_pd(_mm512_mul_pd(vw1, vw2), _mm512_loadu_pd(c0 + pen)));
+            _mm512_storeu_pd(d1 + pen, _mm512_mul_pd(_mm512_mul_pd(vw2, vw0), _mm512_loadu_pd(c1 + pen)));
+            _mm512_storeu_pd(d2 + pen, _mm512_mul_pd(_mm512_mul_pd(vw0, vw1), _mm512_loadu_pd(c2 + pen)));
+        }
+#endif
+
+#if defined(__AVX2__)
+        for (; pen + 4 <= numPens; pen += 4)
+        {
+            const __m256d vw0 = _mm256_loadu_pd(w0 + pen);
+            const __m256d vw1 = _mm256_loadu_pd(w1 + pen);
+            const __m256d vw2 = _mm256_loadu_pd(w2 + pen);
+            _mm256_storeu_pd(d0 + pen, _mm256_mul_pd(_mm256_mul_pd(vw1, vw2), _mm256_loadu_pd(c0 + pen)));
+            _mm256_storeu_pd(d1 + pen, _mm256_mul_pd(_mm256_mul_pd(vw2, vw0), _mm256_loadu_pd(c1 + pen)));
+            _mm256_storeu_pd(d2 + pen, _mm256_mul_pd(_mm256_mul_pd(vw0, vw1), _mm256_loadu_pd(c2 + pen)));
+        }
+#endif
+
+        return pen;
+    }
+
+    // As CalcEulerDerivsDouble, twice the lanes.
+    static size_t CalcEulerDerivsFloat(const float* w0, const float* w1, const float* w2,
+        const float* c0, const float* c1, const float* c2,
+        float* d0, float* d1, float* d2, size_t numPens)
+    {
+        size_t pen = 0;
+
+#if defined(__AVX512F__)
+        for (; pen + 16 <= numPens; pen += 16)
+        {
+            const __m512 vw0 = _mm512_loadu_ps(w0 + pen);
+            const __m512 vw1 = _mm512_loadu_ps(w1 + pen);
+            const __m512 vw2 = _mm512_loadu_ps(w2 + pen);
+            _mm512_storeu_ps(d0 + pen, _mm512_mul_ps(_mm512_mul_ps(vw1, vw2), _mm512_loadu_ps(c0 + pen)));
+            _mm512_storeu_ps(d1 + pen, _mm512_mul_ps(_mm512_mul_ps(vw2, vw0), _mm512_loadu_ps(c1 + pen)));
+            _mm512_storeu_ps(d2 + pen, _mm512_mul_ps(_mm512_mul_ps(vw0, vw1), _mm512_loadu_ps(c2 + pen)));
+        }
+#endif
+
+#if defined(__AVX2__)
+        for (; pen + 8 <= numPens; pen += 8)
+        {
+            const __m256 vw0 = _mm256_loadu_ps(w0 + pen);
+            const __m256 vw1 = _mm256_loadu_ps(w1 + pen);
+            const __m256 vw2 = _mm256_loadu_ps(w2 + pen);
+            _mm256_storeu_ps(d0 + pen, _mm256_mul_ps(_mm256_mul_ps(vw1, vw2), _mm256_loadu_ps(c0 + pen)));
+            _mm256_storeu_ps(d1 + pen, _mm256_mul_ps(_mm256_mul_ps(vw2, vw0), _mm256_loadu_ps(c1 + pen)));
+            _mm256_storeu_ps(d2 + pen, _mm256_mul_ps(_mm256_mul_ps(vw0, vw1), _mm256_loadu_ps(c2 + pen)));
+        }
+#endif
+
+        return pen;
+    }
+
+    // Per pen inertia ratios, eg (I1 - I2)/I0.
+    std::array<Column, 3> m_EulerCoeffs;
+};
+
+using CrudeSpinningPenBatch = EntityBatch<CrudeSpinningPen>;
+using CrudeSpinningPenBatchF = EntityBatch<CrudeSpinningPenT<float>>;
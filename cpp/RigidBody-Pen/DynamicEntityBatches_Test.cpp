@@ -0,0 +1,145 @@
+#include "./DynamicEntityBatches.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <array>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// DynamicEntityBatches Unit Tests
+//////////////////////////////////////////////////////////
+
+int main(void)
+{
+    // Launch states of the pen scenarios in Simulation_Test.cpp:
+    // no spin, z-spin, flat spin and torque free precession,
+    // followed by a handful of tumbling pens so the batch size
+    // is not a multiple of any SIMD width.
+    std::vector<CrudeSpinningPen::State> launchStates{
+        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 0.0},
+        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 10.0},
+        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 0.0},
+        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0}
+    };
+
+    for (int i = 0; i < 7; ++i)
+    {
+        const double s = 0.1 * (i + 1);
+        launchStates.push_back(CrudeSpinningPen::State{
+            s, -s, 1.0 + s, 0.5*s, 0.6*s, 0.7*s, 5.0*s, -3.0*s, 10.0 - s, 10.0*s, 3.0 - s, 2.0 + 8.0*s});
+    }
+
+    std::vector<CrudeSpinningPen> pens;
+    for (size_t i = 0; i < launchStates.size(); ++i)
+    {
+        // Mix in a non symmetric body for every other pen.
+        const std::array<double, 3> inertia = (i % 2 == 0) ?
+            std::array<double, 3>{10.0, 10.0, 1.0} : std::array<double, 3>{3.0, 7.0, 2.0};
+        pens.push_back(CrudeSpinningPen(launchStates[i], inertia));
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test batch derivatives match the scalar entity.
+    {
+        CrudeSpinningPenBatch batch(pens);
+        batch.CalcDerivs(batch.m_State, batch.m_Derivs);
+
+        bool derivsEq = true;
+        for (size_t pen = 0; pen < pens.size(); ++pen)
+        {
+            const CrudeSpinningPen::State expected = pens[pen].CalcDerivs();
+            CrudeSpinningPen::State actual;
+            for (size_t field = 0; field < actual.size(); ++field)
+            {
+                actual[field] = batch.m_Derivs[field][pen];
+            }
+            derivsEq = derivsEq && TestUtils::FloatEquals(actual, expected, 1.0e-12);
+        }
+        TestUtils::ReportResults(derivsEq, "Pen Batch: Derivatives");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test batch Euler step matches the scalar step.
+    {
+        CrudeSpinningPenBatch batch(pens);
+        Integrators::EulerStep(batch, 0.01);
+
+        bool statesEq = true;
+        for (size_t pen = 0; pen < pens.size(); ++pen)
+        {
+            CrudeSpinningPen expected = pens[pen];
+            Integrators::EulerStep(expected, 0.01);
+            statesEq = statesEq && TestUtils::FloatEquals(batch.GetState(pen), expected.m_State, 1.0e-12);
+        }
+        TestUtils::ReportResults(statesEq, "Pen Batch: Euler Step");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a full batched flight matches per pen Simulations.
+    {
+        const double duration = 2.04;
+        const double deltaT = 0.01;
+
+        CrudeSpinningPenBatch batch(pens);
+
+        // Same stepping as Simulation::Run.
+        double elapsedTime = 0.0;
+        while(elapsedTime < duration)
+        {
+            Integrators::MidPointStep(batch, deltaT);
+            elapsedTime += deltaT;
+        }
+
+        bool statesEq = true;
+        for (size_t pen = 0; pen < pens.size(); ++pen)
+        {
+            Simulation sim(duration, deltaT, false, pens[pen]);
+            statesEq = statesEq && sim.Run();
+            statesEq = statesEq && TestUtils::FloatEquals(batch.GetState(pen), sim.GetOutput(), 1.0e-9);
+        }
+        TestUtils::ReportResults(statesEq, "Pen Batch: MidPoint Flight Matches Simulation");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a float batch flight matches per pen float
+    // Simulations, and stays close to double.
+    {
+        const double duration = 2.04;
+        const double deltaT = 0.01;
+
+        std::vector<CrudeSpinningPenT<float>> floatPens;
+        for (const CrudeSpinningPen& pen : pens)
+        {
+            CrudeSpinningPenT<float>::State state;
+            std::copy(pen.m_State.begin(), pen.m_State.end(), state.begin());
+            const std::array<double, 3>& inertia = pen.GetInertia();
+            floatPens.push_back(CrudeSpinningPenT<float>(state,
+                {float(inertia[0]), float(inertia[1]), float(inertia[2])}));
+        }
+
+        CrudeSpinningPenBatchF batch(floatPens);
+        double elapsedTime = 0.0;
+        while(elapsedTime < duration)
+        {
+            Integrators::MidPointStep(batch, deltaT);
+            elapsedTime += deltaT;
+        }
+
+        bool statesEq = true;
+        for (size_t pen = 0; pen < pens.size(); ++pen)
+        {
+            Simulation simFloat(duration, deltaT, false, floatPens[pen]);
+            Simulation simDouble(duration, deltaT, false, pens[pen]);
+            statesEq = statesEq && simFloat.Run() && simDouble.Run();
+            const CrudeSpinningPenT<float>::State floatOutput = simFloat.GetOutput();
+            statesEq = statesEq && TestUtils::FloatEquals(batch.GetState(pen), floatOutput, 1.0e-4);
+
+            CrudeSpinningPen::State widened;
+            std::copy(floatOutput.begin(), floatOutput.end(), widened.begin());
+            statesEq = statesEq && TestUtils::FloatEquals(widened, simDouble.GetOutput(), 1.0e-3);
+        }
+        TestUtils::ReportResults(statesEq, "Pen Batch: Float Flight Matches Simulation");
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "./OnlineStats.h"
+#include "./Simulation.h"
+#include "./ThreadPool.h"
+
+#include <iterator>
+#include <stdint.h>
+#include <stddef.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// EnsembleRunner
+// Descr: Runs many independent Simulations, eg a Monte
+// Carlo sweep of launch conditions, across all cores.
+//////////////////////////////////////////////////////////
+
+template <typename DynamicEntityType, template <typename> class Integrator = Integrators::MidPoint>
+class EnsembleRunner
+{
+public:
+
+    using SimulationType = Simulation<DynamicEntityType, Integrator>;
+    using SimulationOutputType = typename SimulationType::SimulationOutputType;
+
+    // One ensemble member. Entity parameters, eg inertia, are part
+    // of the entity itself.
+    struct Scenario
+    {
+        double m_Duration;                  // in seconds.
+        double m_DeltaT;                    // in seconds.
+        DynamicEntityType m_DynEntity;      // Initial state and parameters.
+    };
+
+    struct Result
+    {
+        bool m_IsValid;
+        SimulationOutputType m_Output;
+    };
+
+    // numThreads of zero uses every hardware thread. chunkSize is the
+    // number of scenarios handed to a worker at once, zero picks one
+    // automatically. Small chunks balance better, large ones have less
+    // scheduling overhead.
+    explicit EnsembleRunner(size_t numThreads = 0, size_t chunkSize = 0)
+    : m_Pool(numThreads == 0 ? std::thread::hardware_concurrency() : numThreads)
+    , m_ChunkSize(chunkSize)
+    {}
+
+    size_t NumThreads() const
+    {
+        return m_Pool.NumThreads();
+    }
+
+    // Runs every scenario in [first, last). Results are in input order.
+    template <typename ScenarioIt>
+    std::vector<Result> Run(ScenarioIt first, ScenarioIt last)
+    {
+        static_assert(IsRandomAccess<ScenarioIt>, "Workers index scenarios directly, see IsRandomAccess");
+        const size_t count = static_cast<size_t>(std::distance(first, last));
+        std::vector<Result> results(count);
+
+        m_Pool.ParallelFor(count, m_ChunkSize, [&](size_t idx, size_t)
+        {
+            const Scenario& scenario = first[idx];
+
+            SimulationType sim(scenario.m_Duration, scenario.m_DeltaT, false, scenario.m_DynEntity);
+            results[idx].m_IsValid = sim.Run();
+            results[idx].m_Output = sim.GetOutput();
+        });
+
+        return results;
+    }
+
+    std::vector<Result> Run(const std::vector<Scenario>& scenarios)
+    {
+        return Run(scenarios.begin(), scenarios.end());
+    }
+
+    // Convenience for sweeps sharing one duration and time step.
+    std::vector<Result> Run(const std::vector<DynamicEntityType>& dynEntities, double duration, double deltaT)
+    {
+        std::vector<Scenario> scenarios;
+        scenarios.reserve(dynEntities.size());
+        for (const DynamicEntityType& dynEntity : dynEntities)
+        {
+            scenarios.push_back(Scenario{duration, deltaT, dynEntity});
+        }
+
+        return Run(scenarios);
+    }
+
+    // Runs every scenario in [first, last) and folds the outputs into
+    // inOutStats instead of keeping them, so memory does not grow with
+    // the number of scenarios. Each worker accumulates its own
+    // statistics, merged at the end. Returns the number of invalid
+    // runs, which are left out.
+    template <typename ScenarioIt>
+    uint64_t Accumulate(ScenarioIt first, ScenarioIt last, StateStatistics<SimulationOutputType>& inOutStats)
+    {
+        static_assert(IsRandomAccess<ScenarioIt>, "Workers index scenarios directly, see IsRandomAccess");
+        const size_t count = static_cast<size_t>(std::distance(first, last));
+        std::vector<StateStatistics<SimulationOutputType>> workerStats(m_Pool.NumThreads());
+        std::vector<uint64_t> workerInvalid(m_Pool.NumThreads(), 0);
+
+        m_Pool.ParallelFor(count, m_ChunkSize, [&](size_t idx, size_t workerIdx)
+        {
+            const Scenario& scenario = first[idx];
+
+            SimulationType sim(scenario.m_Duration, scenario.m_DeltaT, false, scenario.m_DynEntity);
+            if (sim.Run())
+            {
+                workerStats[workerIdx].Add(sim.GetOutput());
+            }
+            else
+            {
+                ++workerInvalid[workerIdx];
+            }
+        });
+
+        uint64_t numInvalid = 0;
+        for (size_t workerIdx = 0; workerIdx < m_Pool.NumThreads(); ++workerIdx)
+        {
+            inOutStats.Merge(workerStats[workerIdx]);
+            numInvalid += workerInvalid[workerIdx];
+        }
+
+        return numInvalid;
+    }
+
+    // Access to the pool, eg to reduce results with per thread state.
+    WorkStealingPool& GetPool()
+    {
+        return m_Pool;
+    }
+
+private:
+    // Workers pick up scenarios by index in any order, which is
+    // O(n) per scenario on anything but random access iterators.
+    template <typename ScenarioIt>
+    static constexpr bool IsRandomAccess = std::is_base_of<std::random_access_iterator_tag,
+        typename std::iterator_traits<ScenarioIt>::iterator_category>::value;
+
+    WorkStealingPool m_Pool;
+    const size_t m_ChunkSize;
+};
@@ -0,0 +1,68 @@
+#include "./EnsembleRunner.h"
+#include "./DynamicEntities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// EnsembleRunner_Bench
+// Descr: Scaling of EnsembleRunner from 1 to N threads on
+// a Monte Carlo sweep of pen launches.
+// Usage: ./EnsembleRunner_Bench [numScenarios] [maxThreads]
+//////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    const size_t numScenarios = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+    const size_t maxThreads = argc > 2 ? strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+
+    using Runner = EnsembleRunner<CrudeSpinningPen>;
+
+    std::vector<Runner::Scenario> scenarios;
+    scenarios.reserve(numScenarios);
+    for (size_t i = 0; i < numScenarios; ++i)
+    {
+        const double s = static_cast<double>(i) / numScenarios;
+        const CrudeSpinningPen::State launchState{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 5.0*s, 5.0 - s, 10.0, 10.0*s, 1.0, 10.0};
+        const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+        scenarios.push_back(Runner::Scenario{2.04, 0.001, CrudeSpinningPen(launchState, inertia)});
+    }
+
+    std::cout << "scenarios = " << numScenarios << "\n";
+
+    // Powers of two below maxThreads, then maxThreads itself.
+    std::vector<size_t> threadCounts;
+    for (size_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+    {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(std::max<size_t>(maxThreads, 1));
+
+    double serialSeconds = 0.0;
+    for (size_t numThreads : threadCounts)
+    {
+        Runner runner(numThreads);
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<Runner::Result> results = runner.Run(scenarios);
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(stop - start).count();
+        if (numThreads == 1)
+        {
+            serialSeconds = seconds;
+        }
+
+        std::cout << "threads = " << numThreads
+            << ", seconds = " << seconds
+            << ", sims/s = " << numScenarios / seconds
+            << ", speedup = " << serialSeconds / seconds << "\n";
+    }
+
+    return 0;
+}
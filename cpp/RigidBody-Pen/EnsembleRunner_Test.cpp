@@ -0,0 +1,90 @@
+#include "./EnsembleRunner.h"
+#include "./DynamicEntities.h"
+#include "./TestUtils.h"
+
+#include <atomic>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// EnsembleRunner Unit Tests
+//////////////////////////////////////////////////////////
+
+int main(void)
+{
+    //////////////////////////////////////////////////////////
+    // Test pool visits every index exactly once.
+    {
+        WorkStealingPool pool(4);
+        std::vector<std::atomic<int>> visits(1000);
+
+        bool allOnce = true;
+        for (size_t chunkSize : {size_t(0), size_t(1), size_t(7), size_t(5000)})
+        {
+            for (std::atomic<int>& visit : visits)
+            {
+                visit.store(0);
+            }
+
+            pool.ParallelFor(visits.size(), chunkSize, [&](size_t idx, size_t)
+            {
+                ++visits[idx];
+            });
+
+            for (const std::atomic<int>& visit : visits)
+            {
+                allOnce = allOnce && visit.load() == 1;
+            }
+        }
+        TestUtils::ReportResults(allOnce, "Pool: Every Index Once");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test ensemble results match serial runs, in input order.
+    {
+        using Runner = EnsembleRunner<CrudeSpinningPen>;
+
+        std::vector<Runner::Scenario> scenarios;
+        for (int i = 0; i < 50; ++i)
+        {
+            const double s = 0.1 * i;
+            const CrudeSpinningPen::State launchState{
+                0.0, 0.0, 0.0, 0.0, 0.0, 0.0, s, -s, 10.0, 10.0 - s, 0.5*s, 10.0};
+            const std::array<double, 3> inertia = {10.0, 10.0, 1.0 + s};
+            scenarios.push_back(Runner::Scenario{1.0 + 0.01*i, 0.01, CrudeSpinningPen(launchState, inertia)});
+        }
+
+        bool resultsEq = true;
+        for (size_t numThreads : {size_t(1), size_t(3), size_t(8)})
+        {
+            Runner runner(numThreads, 2);
+            const std::vector<Runner::Result> results = runner.Run(scenarios);
+
+            resultsEq = resultsEq && results.size() == scenarios.size();
+            for (size_t idx = 0; idx < scenarios.size(); ++idx)
+            {
+                Simulation<CrudeSpinningPen> sim(scenarios[idx].m_Duration, scenarios[idx].m_DeltaT, false, scenarios[idx].m_DynEntity);
+                const bool isValid = sim.Run();
+                resultsEq = resultsEq && results[idx].m_IsValid == isValid;
+                resultsEq = resultsEq && TestUtils::FloatEquals(results[idx].m_Output, sim.GetOutput(), 0.0);
+            }
+        }
+        TestUtils::ReportResults(resultsEq, "Ensemble: Matches Serial Runs");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test invalid scenarios are reported, not dropped.
+    {
+        EnsembleRunner<SimpleSpringMotion> runner(2);
+        const std::vector<SimpleSpringMotion> springs(5, SimpleSpringMotion{SimpleSpringMotion::State{1.0, 0.0}, 4.0});
+
+        const auto results = runner.Run(springs, 1.0, 2.0);
+        bool allInvalid = results.size() == springs.size();
+        for (const auto& result : results)
+        {
+            allInvalid = allInvalid && !result.m_IsValid;
+        }
+        TestUtils::ReportResults(allInvalid, "Ensemble: Invalid Scenarios Reported");
+    }
+
+    return 0;
+}
@@ -1,14 +1,24 @@
 #include "./DynamicEntities.h"
-#include "./Simulation.h"
+#include "./IntegratorSelection.h"
+
+#include <iostream>
 
 //////////////////////////////////////////////////////////
 // Example_Sim
 // Descr: Demonstration of how to instantiate and run an 
 // example simulation
+// Usage: ./Example_Sim [integrator], eg RK4. Defaults to MidPoint.
 //////////////////////////////////////////////////////////
 
-int main(void) 
+int main(int argc, char** argv) 
 {
+    IntegratorKind integrator = IntegratorKind::MidPoint;
+    if (argc > 1 && !ParseIntegratorKind(argv[1], integrator))
+    {
+        std::cout << "Unknown integrator " << argv[1] << "\n";
+        return 1;
+    }
+
     // Initialize and Run Pen Simulation
     {        
             const CrudeSpinningPen::State penStateInput{
@@ -34,8 +44,7 @@ int main(void)
             const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
             CrudeSpinningPen csp(penStateInput, inertia);
 
-            Simulation simCsp(2.04, .01, true, csp);
-            const bool isValidCsp = simCsp.Run();        
+            const bool isValidCsp = RunSimulation(integrator, 2.04, .01, true, csp).m_IsValid;
         }
 
     return 0;
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Instrumentation
+// Descr: Opt in profiling policies for Simulation. Disabled
+// is the default and compiles to nothing. Enabled counts
+// steps and derivative evaluations, accumulates steady_clock
+// time per phase of Run(), and can record a timeline of the
+// run for chrome://tracing or Perfetto.
+//////////////////////////////////////////////////////////
+
+namespace Instrumentation
+{
+
+enum class Phase
+{
+    Step,       // A whole integrator step, derivatives included.
+    Derivs,     // CalcDerivs calls, inside Step, event location or dense output.
+    Events,     // Event checks and bisection.
+    Output,     // PrintStatus, output and checkpoint sinks.
+    NumPhases
+};
+
+inline const char* PhaseName(Phase phase)
+{
+    switch (phase)
+    {
+        case Phase::Step:       return "Step";
+        case Phase::Derivs:     return "Derivs";
+        case Phase::Events:     return "Events";
+        case Phase::Output:     return "Output";
+        case Phase::NumPhases:  break;
+    }
+
+    return "";
+}
+
+struct Report
+{
+    uint64_t m_Steps = 0;
+    uint64_t m_DerivEvals = 0;
+    double m_PhaseSeconds[static_cast<size_t>(Phase::NumPhases)] = {};
+    double m_StepDerivsSeconds = 0.0;   // The part of Derivs inside Step.
+
+    double GetSeconds(Phase phase) const
+    {
+        return m_PhaseSeconds[static_cast<size_t>(phase)];
+    }
+
+    // Integrator arithmetic, ie Step time outside CalcDerivs. Derivs
+    // outside any step, eg event bisection, are not part of Step.
+    double GetUpdateSeconds() const
+    {
+        return GetSeconds(Phase::Step) - m_StepDerivsSeconds;
+    }
+};
+
+// No op policy. Every call is empty and inlined away, and the
+// simulation steps the entity type itself.
+class Disabled
+{
+public:
+
+    static constexpr bool IsEnabled = false;
+
+    template <typename DynamicEntityType>
+    using Entity = DynamicEntityType;
+
+    struct Scope {};
+
+    void BeginRun() {}
+
+    template <typename DynamicEntityType>
+    void Attach(DynamicEntityType&) {}
+
+    Scope Time(Phase) { return Scope{}; }
+
+    void CountStep() {}
+};
+
+class Enabled;
+
+// Entity the simulation steps while instrumented: the entity itself
+// plus a timer around CalcDerivs. Converts to and from the plain
+// entity, so checkpoints and outputs are unchanged.
+template <typename DynamicEntityType>
+class TimedEntity : public DynamicEntityType
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+
+    TimedEntity(const DynamicEntityType& dynEntity)
+    : DynamicEntityType(dynEntity)
+    {}
+
+    State CalcDerivs() const
+    {
+        return CalcDerivs(this->m_State);
+    }
+
+    inline State CalcDerivs(const State& state) const;
+
+    Enabled* m_Recorder = nullptr;
+};
+
+class Enabled
+{
+public:
+
+    static constexpr bool IsEnabled = true;
+
+    template <typename DynamicEntityType>
+    using Entity = TimedEntity<DynamicEntityType>;
+
+    struct TraceEvent
+    {
+        Phase m_Phase;
+        double m_StartUs;               // in microseconds from BeginRun().
+        double m_DurationUs;            // in microseconds.
+    };
+
+    // Times one phase from construction to destruction.
+    class Scope
+    {
+    public:
+
+        Scope(Enabled& recorder, Phase phase)
+        : m_Recorder(recorder)
+        , m_Phase(phase)
+        , m_Start(std::chrono::steady_clock::now())
+        {
+            if (m_Phase == Phase::Step)
+            {
+                ++m_Recorder.m_StepDepth;
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            m_Recorder.Record(m_Phase, m_Start, std::chrono::steady_clock::now());
+            if (m_Phase == Phase::Step)
+            {
+                --m_Recorder.m_StepDepth;
+            }
+        }
+
+    private:
+        Enabled& m_Recorder;
+        const Phase m_Phase;
+        const std::chrono::steady_clock::time_point m_Start;
+    };
+
+    // Keeps the first maxTraceEvents phase timings of each run for
+    // WriteChromeTrace. 0, the default, only keeps the totals.
+    void SetTraceCapacity(size_t maxTraceEvents)
+    {
+        m_TraceCapacity = maxTraceEvents;
+        m_TraceEvents.reserve(maxTraceEvents);
+    }
+
+    // Called by Simulation::Run(), clears everything recorded so far.
+    void BeginRun()
+    {
+        m_Report = Report{};
+        m_TraceEvents.clear();
+        m_TraceEventsDropped = 0;
+        m_RunStart = std::chrono::steady_clock::now();
+    }
+
+    template <typename DynamicEntityType>
+    void Attach(TimedEntity<DynamicEntityType>& dynEntity)
+    {
+        dynEntity.m_Recorder = this;
+    }
+
+    Scope Time(Phase phase)
+    {
+        return Scope(*this, phase);
+    }
+
+    void CountStep()
+    {
+        ++m_Report.m_Steps;
+    }
+
+    void CountDerivEval()
+    {
+        ++m_Report.m_DerivEvals;
+    }
+
+    const Report& GetReport() const
+    {
+        return m_Report;
+    }
+
+    const std::vector<TraceEvent>& GetTraceEvents() const
+    {
+        return m_TraceEvents;
+    }
+
+    // Phase timings which did not fit in the trace capacity.
+    uint64_t GetTraceEventsDropped() const
+    {
+        return m_TraceEventsDropped;
+    }
+
+    // Writes the recorded timings as Chrome trace event JSON, one
+    // complete ("X") event per timed phase.
+    bool WriteChromeTrace(std::ostream& out) const
+    {
+        out << "{\"traceEvents\":[";
+        for (size_t idx = 0; idx < m_TraceEvents.size(); ++idx)
+        {
+            const TraceEvent& event = m_TraceEvents[idx];
+            out << (idx == 0 ? "\n" : ",\n")
+                << "{\"name\":\"" << PhaseName(event.m_Phase) << "\",\"cat\":\"Simulation\",\"ph\":\"X\""
+                << ",\"ts\":" << event.m_StartUs << ",\"dur\":" << event.m_DurationUs
+                << ",\"pid\":0,\"tid\":0}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        return out.good();
+    }
+
+private:
+
+    void Record(Phase phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point stop)
+    {
+        const std::chrono::duration<double> duration = stop - start;
+        m_Report.m_PhaseSeconds[static_cast<size_t>(phase)] += duration.count();
+        if (phase == Phase::Derivs && m_StepDepth > 0)
+        {
+            m_Report.m_StepDerivsSeconds += duration.count();
+        }
+
+        if (m_TraceEvents.size() < m_TraceCapacity)
+        {
+            const std::chrono::duration<double, std::micro> startUs = start - m_RunStart;
+            m_TraceEvents.push_back(TraceEvent{phase, startUs.count(), 1.0e6 * duration.count()});
+        }
+        else if (m_TraceCapacity > 0)
+        {
+            ++m_TraceEventsDropped;
+        }
+    }
+
+private:
+    Report m_Report;
+    std::chrono::steady_clock::time_point m_RunStart;
+    size_t m_StepDepth = 0;             // Open Step scopes.
+
+    size_t m_TraceCapacity = 0;
+    std::vector<TraceEvent> m_TraceEvents;
+    uint64_t m_TraceEventsDropped = 0;
+};
+
+template <typename DynamicEntityType>
+typename TimedEntity<DynamicEntityType>::State TimedEntity<DynamicEntityType>::CalcDerivs(const State& state) const
+{
+    if (m_Recorder == nullptr)
+    {
+        return DynamicEntityType::CalcDerivs(state);
+    }
+
+    m_Recorder->CountDerivEval();
+    const Enabled::Scope scope(*m_Recorder, Phase::Derivs);
+    return DynamicEntityType::CalcDerivs(state);
+}
+
+} // namespace Instrumentation
@@ -0,0 +1,107 @@
+#include "./DynamicEntities.h"
+#include "./Instrumentation.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <sstream>
+#include <string>
+
+//////////////////////////////////////////////////////////
+// Instrumentation Unit Tests
+//////////////////////////////////////////////////////////
+
+static size_t CountOccurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+
+int main(void)
+{
+    const CrudeSpinningPen::State penState{
+        0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+    const CrudeSpinningPen pen(penState, {10.0, 10.0, 1.0});
+
+    //////////////////////////////////////////////////////////
+    // Test instrumentation leaves the trajectory bit exact and
+    // counts every step and derivative evaluation.
+    {
+        Simulation<CrudeSpinningPen, Integrators::RK4> plainSim(1.0 - .005, .01, false, pen);
+        Simulation<CrudeSpinningPen, Integrators::RK4, Instrumentation::Enabled> timedSim(1.0 - .005, .01, false, pen);
+        const bool runsValid = plainSim.Run() && timedSim.Run();
+
+        const Instrumentation::Report& report = timedSim.GetInstrumentation().GetReport();
+        const bool countsEq = runsValid &&
+            plainSim.GetOutput() == timedSim.GetOutput() &&
+            report.m_Steps == 100 &&
+            report.m_DerivEvals == 4 * 100 &&
+            report.m_DerivEvals == timedSim.GetStepStats().m_DerivEvals;
+        TestUtils::ReportResults(countsEq, "Instrumentation Test: Step and Deriv Counts");
+
+        const bool timesValid =
+            report.GetSeconds(Instrumentation::Phase::Step) > 0.0 &&
+            report.GetSeconds(Instrumentation::Phase::Derivs) > 0.0 &&
+            report.GetSeconds(Instrumentation::Phase::Output) > 0.0 &&
+            report.GetSeconds(Instrumentation::Phase::Events) == 0.0 &&
+            report.GetUpdateSeconds() > 0.0;
+        TestUtils::ReportResults(timesValid, "Instrumentation Test: Phase Timings");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test event location is counted and timed, its derivatives
+    // are kept out of Step's, and the report is reset by every
+    // Run().
+    {
+        const ConstantVelParticle particle(ConstantVelParticle::State{-1.0, 1.0});
+        using TimedSimulation = Simulation<ConstantVelParticle, Integrators::Euler, Instrumentation::Enabled>;
+        TimedSimulation sim(2.0, .1, false, particle);
+        sim.AddEvent([](const ConstantVelParticle::State& state){ return state[0]; },
+            TimedSimulation::EventDirection::Rising, TimedSimulation::EventAction::Record);
+
+        sim.Run();
+        const Instrumentation::Report first = sim.GetInstrumentation().GetReport();
+        const bool firstValid =
+            first.GetSeconds(Instrumentation::Phase::Events) > 0.0 &&
+            first.m_DerivEvals > first.m_Steps &&
+            first.m_DerivEvals == sim.GetStepStats().m_DerivEvals &&
+            first.m_StepDerivsSeconds < first.GetSeconds(Instrumentation::Phase::Derivs) &&
+            first.GetUpdateSeconds() >= 0.0;
+
+        // Continues from x = 1, so nothing to locate this time.
+        sim.Run();
+        const Instrumentation::Report& second = sim.GetInstrumentation().GetReport();
+
+        const bool eventsValid = firstValid &&
+            second.m_Steps == first.m_Steps &&
+            second.m_DerivEvals == second.m_Steps;
+        TestUtils::ReportResults(eventsValid, "Instrumentation Test: Events and Reset");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test Chrome trace export, up to the trace capacity.
+    {
+        Simulation<CrudeSpinningPen, Integrators::MidPoint, Instrumentation::Enabled> sim(1.0 - .005, .01, false, pen);
+        sim.GetInstrumentation().SetTraceCapacity(50);
+        sim.Run();
+
+        std::ostringstream trace;
+        const Instrumentation::Enabled& instrumentation = sim.GetInstrumentation();
+        const bool writeValid = instrumentation.WriteChromeTrace(trace);
+        const std::string text = trace.str();
+
+        // 101 outputs, 100 steps and 200 derivative evaluations.
+        const bool traceValid = writeValid &&
+            text.rfind("{\"traceEvents\":[", 0) == 0 &&
+            CountOccurrences(text, "\"ph\":\"X\"") == 50 &&
+            instrumentation.GetTraceEvents().size() == 50 &&
+            instrumentation.GetTraceEventsDropped() == 401 - 50 &&
+            CountOccurrences(text, "\"name\":\"Derivs\"") > 0;
+        TestUtils::ReportResults(traceValid, "Instrumentation Test: Chrome Trace Export");
+    }
+
+    return 0;
+}
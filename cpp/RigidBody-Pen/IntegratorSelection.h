@@ -0,0 +1,146 @@
+#pragma once
+
+#include "./Simulation.h"
+
+#include <functional>
+#include <iostream>
+#include <string>
+
+//////////////////////////////////////////////////////////
+// IntegratorSelection
+// Descr: Runtime front end to the compile time integrator
+// policies of Simulation, for tools which pick the
+// integrator from the command line.
+//////////////////////////////////////////////////////////
+
+enum class IntegratorKind
+{
+    Euler,
+    MidPoint,
+    RK4,
+    VelocityVerlet,
+    DormandPrince,  // Adaptive, see Simulation::SetTolerances.
+    BackwardEuler,  // Implicit, for stiff entities.
+    Trapezoidal     // Implicit, for stiff entities.
+};
+
+inline const char* IntegratorName(IntegratorKind kind)
+{
+    switch (kind)
+    {
+        case IntegratorKind::Euler:             return "Euler";
+        case IntegratorKind::MidPoint:          return "MidPoint";
+        case IntegratorKind::RK4:               return "RK4";
+        case IntegratorKind::VelocityVerlet:    return "VelocityVerlet";
+        case IntegratorKind::DormandPrince:     return "DormandPrince";
+        case IntegratorKind::BackwardEuler:     return "BackwardEuler";
+        case IntegratorKind::Trapezoidal:       return "Trapezoidal";
+    }
+
+    return "Unknown";
+}
+
+// Parses an integrator name as returned by IntegratorName, case sensitive.
+// Returns false, leaving outKind unchanged, for unknown names.
+inline bool ParseIntegratorKind(const std::string& name, IntegratorKind& outKind)
+{
+    for (IntegratorKind kind : {IntegratorKind::Euler,
+                                IntegratorKind::MidPoint,
+                                IntegratorKind::RK4,
+                                IntegratorKind::VelocityVerlet,
+                                IntegratorKind::DormandPrince,
+                                IntegratorKind::BackwardEuler,
+                                IntegratorKind::Trapezoidal})
+    {
+        if (name == IntegratorName(kind))
+        {
+            outKind = kind;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Result of a runtime selected simulation run.
+template <typename DynamicEntityType>
+struct SelectedRunResult
+{
+    bool m_IsValid = false;
+    typename DynamicEntityType::State m_Output{};
+    double m_ElapsedTime = 0.0;     // in seconds, simulation time reached.
+    Integrators::StepStats m_StepStats;
+};
+
+// Receives the state after every step of a runtime selected run, see
+// Simulation::SetOutputSink.
+template <typename DynamicEntityType>
+using SelectedOutputSink = std::function<void(double, const typename DynamicEntityType::State&)>;
+
+template <typename DynamicEntityType, template <typename> class Integrator>
+SelectedRunResult<DynamicEntityType> RunWithIntegrator(double duration,
+    double deltaT,
+    bool printStatus,
+    const DynamicEntityType& dynEntity,
+    const Integrators::AdaptiveTolerances* tolerances = nullptr,
+    const SelectedOutputSink<DynamicEntityType>& outputSink = SelectedOutputSink<DynamicEntityType>{})
+{
+    Simulation<DynamicEntityType, Integrator> sim(duration, deltaT, printStatus, dynEntity);
+    if constexpr (Simulation<DynamicEntityType, Integrator>::Adaptive)
+    {
+        if (tolerances)
+        {
+            sim.SetTolerances(*tolerances);
+        }
+    }
+    sim.SetOutputSink(outputSink);
+
+    SelectedRunResult<DynamicEntityType> result;
+    result.m_IsValid = sim.Run();
+    result.m_Output = sim.GetOutput();
+    result.m_ElapsedTime = sim.GetElapsedTime();
+    result.m_StepStats = sim.GetStepStats();
+    return result;
+}
+
+// Runs a Simulation with the integrator picked at runtime. Every
+// integrator is instantiated for DynamicEntityType here, so the
+// switch is the only dispatch and each stepping loop is fully
+// specialized.
+template <typename DynamicEntityType>
+SelectedRunResult<DynamicEntityType> RunSimulation(IntegratorKind kind,
+    double duration,
+    double deltaT,
+    bool printStatus,
+    const DynamicEntityType& dynEntity,
+    const Integrators::AdaptiveTolerances& tolerances = Integrators::AdaptiveTolerances{},
+    const SelectedOutputSink<DynamicEntityType>& outputSink = SelectedOutputSink<DynamicEntityType>{})
+{
+    switch (kind)
+    {
+        case IntegratorKind::Euler:
+            return RunWithIntegrator<DynamicEntityType, Integrators::Euler>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+        case IntegratorKind::MidPoint:
+            return RunWithIntegrator<DynamicEntityType, Integrators::MidPoint>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+        case IntegratorKind::RK4:
+            return RunWithIntegrator<DynamicEntityType, Integrators::RK4>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+        case IntegratorKind::VelocityVerlet:
+            if constexpr (Integrators::SupportsVelocityVerlet<DynamicEntityType>)
+            {
+                return RunWithIntegrator<DynamicEntityType, Integrators::VelocityVerlet>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+            }
+            else
+            {
+                std::cout << "VelocityVerlet does not support " << DynamicEntityType::Name << "\n";
+                return SelectedRunResult<DynamicEntityType>{};
+            }
+        case IntegratorKind::DormandPrince:
+            return RunWithIntegrator<DynamicEntityType, Integrators::DormandPrince>(duration, deltaT, printStatus, dynEntity, &tolerances, outputSink);
+        case IntegratorKind::BackwardEuler:
+            return RunWithIntegrator<DynamicEntityType, Integrators::BackwardEuler>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+        case IntegratorKind::Trapezoidal:
+            return RunWithIntegrator<DynamicEntityType, Integrators::Trapezoidal>(duration, deltaT, printStatus, dynEntity, nullptr, outputSink);
+    }
+
+    return SelectedRunResult<DynamicEntityType>{};
+}
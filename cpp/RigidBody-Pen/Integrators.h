@@ -1,36 +1,800 @@
 #pragma once 
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "./Dual.h"
+#include "./StateVector.h"
 
 //////////////////////////////////////////////////////////
 // Integrators.
 // Descr: Functions for computing update for DynamicEntities
+// States are StateVectors, so each stage update below is
+// one fused pass over the state, see StateVector.h.
 //////////////////////////////////////////////////////////
 
+// Batched entities, see DynamicEntityBatches.h
+template<typename DynamicEntity>
+class EntityBatch;
+
 namespace Integrators{
 
+// Scalar type of an entity's state, eg double, float or Dual.
+template<typename DynamicEntity>
+using ScalarOf = typename DynamicEntity::State::value_type;
+
+// Type the fixed step integrators scale derivatives in. The state's
+// own type for floating point states, so that float states are
+// stepped in float at full SIMD width, otherwise double.
+template<typename DynamicEntity>
+using StepScalar = std::conditional_t<std::is_floating_point<ScalarOf<DynamicEntity>>::value, ScalarOf<DynamicEntity>, double>;
+
+// Entities with constrained states, eg QuaternionSpinningPen's unit
+// quaternion, provide void ProjectState(State&) const. Integrators
+// apply it to the state after every step.
+template<typename DynamicEntity, typename = void>
+struct HasProjectState : std::false_type {};
+
+template<typename DynamicEntity>
+struct HasProjectState<DynamicEntity,
+	std::void_t<decltype(std::declval<const DynamicEntity&>().ProjectState(std::declval<typename DynamicEntity::State&>()))>>
+	: std::true_type {};
+
+template<typename DynamicEntity>
+void ProjectState(DynamicEntity& inOutDynEntity)
+{
+	if constexpr (HasProjectState<DynamicEntity>::value)
+	{
+		inOutDynEntity.ProjectState(inOutDynEntity.m_State);
+	}
+}
+
 template<typename DynamicEntity>
 void EulerStep(DynamicEntity& inOutDynEntity, double deltaT)
 {
-	typename DynamicEntity::State currDerivs = inOutDynEntity.CalcDerivs();
+	const StepScalar<DynamicEntity> h = static_cast<StepScalar<DynamicEntity>>(deltaT);
+	const typename DynamicEntity::State currDerivs = inOutDynEntity.CalcDerivs();
+
+	inOutDynEntity.m_State += h * currDerivs;
+	ProjectState(inOutDynEntity);
+}
+
+template<typename DynamicEntity>
+void MidPointStep(DynamicEntity& inOutDynEntity, double deltaT)
+{
+	using State = typename DynamicEntity::State;
+	const StepScalar<DynamicEntity> h = static_cast<StepScalar<DynamicEntity>>(deltaT);
+
+	const State currDerivs = inOutDynEntity.CalcDerivs();
+
+	State midState;
+	midState = inOutDynEntity.m_State + h / 2 * currDerivs;
+
+	const State midDerivs = inOutDynEntity.CalcDerivs(midState);
+
+	inOutDynEntity.m_State += h * midDerivs;
+	ProjectState(inOutDynEntity);
+}
+
+////////////////////////////////////////////////////////////
+// Scratch based steps. Stages are evaluated with
+// CalcDerivs(state) on caller owned buffers, the entity
+// itself is never copied. Reuse one scratch across steps.
+
+// Stage buffers for RK4Step.
+template<typename DynamicEntity>
+struct RK4Scratch
+{
+	typename DynamicEntity::State m_K1;
+	typename DynamicEntity::State m_K2;
+	typename DynamicEntity::State m_K3;
+	typename DynamicEntity::State m_K4;
+	typename DynamicEntity::State m_Stage;
+};
+
+// Classic 4th order Runge-Kutta.
+template<typename DynamicEntity>
+void RK4Step(DynamicEntity& inOutDynEntity, double deltaT, RK4Scratch<DynamicEntity>& scratch)
+{
+	typename DynamicEntity::State& state = inOutDynEntity.m_State;
+	const StepScalar<DynamicEntity> h = static_cast<StepScalar<DynamicEntity>>(deltaT);
+
+	scratch.m_K1 = inOutDynEntity.CalcDerivs(state);
+	scratch.m_Stage = state + h / 2 * scratch.m_K1;
+
+	scratch.m_K2 = inOutDynEntity.CalcDerivs(scratch.m_Stage);
+	scratch.m_Stage = state + h / 2 * scratch.m_K2;
+
+	scratch.m_K3 = inOutDynEntity.CalcDerivs(scratch.m_Stage);
+	scratch.m_Stage = state + h * scratch.m_K3;
+
+	// All four stages combined and added in a single pass.
+	scratch.m_K4 = inOutDynEntity.CalcDerivs(scratch.m_Stage);
+	state += h / 6 * (scratch.m_K1 + 2 * scratch.m_K2 + 2 * scratch.m_K3 + scratch.m_K4);
+	ProjectState(inOutDynEntity);
+}
+
+template<typename DynamicEntity>
+void RK4Step(DynamicEntity& inOutDynEntity, double deltaT)
+{
+	RK4Scratch<DynamicEntity> scratch;
+	RK4Step(inOutDynEntity, deltaT, scratch);
+}
+
+// Buffers for VelocityVerletStep. Caches the derivatives at the end
+// of the last step, so a step costs one derivative evaluation unless
+// the state was modified in between.
+template<typename DynamicEntity>
+struct VerletScratch
+{
+	typename DynamicEntity::State m_Derivs;
+	typename DynamicEntity::State m_DerivsState;	// State m_Derivs was evaluated at.
+	bool m_HasDerivs = false;
+};
+
+// Entities opt in to velocity Verlet by declaring
+// static constexpr bool HasPositionOnlyAccelerations = true.
+template<typename DynamicEntity, typename = void>
+struct HasPositionOnlyAccelerations : std::false_type {};
+
+template<typename DynamicEntity>
+struct HasPositionOnlyAccelerations<DynamicEntity, std::void_t<decltype(DynamicEntity::HasPositionOnlyAccelerations)>>
+	: std::bool_constant<DynamicEntity::HasPositionOnlyAccelerations> {};
+
+// Velocity Verlet expects the state to be laid out as coordinates
+// followed by their velocities, so that the second half of the
+// derivatives are accelerations, and accelerations which depend on the
+// coordinates only, eg SimpleSpringMotion. Then it is second order and
+// symplectic, so keeps energy drift bounded. With velocity dependent
+// accelerations, eg the spinning pens' Euler equations, it drops to
+// first order, so those entities do not opt in.
+template<typename DynamicEntity>
+constexpr bool SupportsVelocityVerlet = HasPositionOnlyAccelerations<DynamicEntity>::value &&
+	std::tuple_size<typename DynamicEntity::State>::value % 2 == 0;
+
+// Velocity Verlet, ie kick-drift-kick leapfrog, see SupportsVelocityVerlet.
+// Returns the number of derivative evaluations, one or two.
+template<typename DynamicEntity>
+size_t VelocityVerletStep(DynamicEntity& inOutDynEntity, double deltaT, VerletScratch<DynamicEntity>& scratch)
+{
+	static_assert(SupportsVelocityVerlet<DynamicEntity>,
+		"VelocityVerletStep expects coordinates followed by velocities, and position only accelerations");
+
+	typename DynamicEntity::State& state = inOutDynEntity.m_State;
+	const size_t half = state.size() / 2;
+	const StepScalar<DynamicEntity> h = static_cast<StepScalar<DynamicEntity>>(deltaT);
+
+	size_t derivEvals = 1;
+	if (!scratch.m_HasDerivs || scratch.m_DerivsState != state)
+	{
+		scratch.m_Derivs = inOutDynEntity.CalcDerivs(state);
+		++derivEvals;
+	}
+
+	// Kick, velocities to the half step.
+	for (size_t idx = half; idx < state.size(); ++idx)
+	{
+		state[idx] += h / 2 * scratch.m_Derivs[idx];
+	}
+
+	// Drift, coordinates a full step with half step velocities.
+	for (size_t idx = 0; idx < half; ++idx)
+	{
+		state[idx] += h * state[idx + half];
+	}
+	ProjectState(inOutDynEntity);
 
-	for (size_t idx = 0; idx < currDerivs.size(); ++idx)
+	// Kick, velocities to the full step with the new accelerations.
+	scratch.m_Derivs = inOutDynEntity.CalcDerivs(state);
+	for (size_t idx = half; idx < state.size(); ++idx)
 	{
-		inOutDynEntity.m_State[idx] += deltaT * currDerivs[idx];
+		state[idx] += h / 2 * scratch.m_Derivs[idx];
 	}
+
+	scratch.m_DerivsState = state;
+	scratch.m_HasDerivs = true;
+
+	return derivEvals;
 }
 
 template<typename DynamicEntity>
-void MidPointStep(DynamicEntity& inOutDynEntity, double deltaT)
+size_t VelocityVerletStep(DynamicEntity& inOutDynEntity, double deltaT)
+{
+	VerletScratch<DynamicEntity> scratch;
+	return VelocityVerletStep(inOutDynEntity, deltaT, scratch);
+}
+
+////////////////////////////////////////////////////////////
+// Fixed step integrator policies, used as the Integrator
+// parameter of Simulation, eg Simulation<SimpleSpringMotion,
+// Integrators::RK4>. A policy object lives for the whole run
+// and owns the step's scratch. Step() advances the entity
+// and returns the number of derivative evaluations it made.
+
+template<typename DynamicEntity>
+class Euler
+{
+public:
+	static constexpr const char* Name = "Euler";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		EulerStep(inOutDynEntity, deltaT);
+		return 1;
+	}
+};
+
+template<typename DynamicEntity>
+class MidPoint
+{
+public:
+	static constexpr const char* Name = "MidPoint";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		MidPointStep(inOutDynEntity, deltaT);
+		return 2;
+	}
+};
+
+template<typename DynamicEntity>
+class RK4
+{
+public:
+	static constexpr const char* Name = "RK4";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		RK4Step(inOutDynEntity, deltaT, m_Scratch);
+		return 4;
+	}
+
+private:
+	RK4Scratch<DynamicEntity> m_Scratch;
+};
+
+template<typename DynamicEntity>
+class VelocityVerlet
 {
-	DynamicEntity midDynEntity = inOutDynEntity;
-	EulerStep(midDynEntity, 0.5 * deltaT);
+public:
+	static constexpr const char* Name = "VelocityVerlet";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		return VelocityVerletStep(inOutDynEntity, deltaT, m_Scratch);
+	}
+
+private:
+	VerletScratch<DynamicEntity> m_Scratch;
+};
+
+////////////////////////////////////////////////////////////
+// Implicit stepping, for stiff entities. Each step solves
+// y = y0 + dt * ((1 - theta) f(y0) + theta f(y)) for y with
+// Newton's method, so step size is limited by accuracy rather
+// than stability. theta = 1 is backward Euler, 0.5 trapezoidal.
+
+// Jacobian of the derivatives, row i holds d(derivs[i])/d(state).
+template<typename DynamicEntity>
+using Jacobian = std::array<typename DynamicEntity::State, std::tuple_size<typename DynamicEntity::State>::value>;
+
+// Entities may provide an analytic Jacobian CalcJacobian(const
+// State&) const. Otherwise it is found by finite differences.
+template<typename DynamicEntity, typename = void>
+struct HasJacobian : std::false_type {};
+
+template<typename DynamicEntity>
+struct HasJacobian<DynamicEntity,
+	std::void_t<decltype(std::declval<const DynamicEntity&>().CalcJacobian(std::declval<const typename DynamicEntity::State&>()))>>
+	: std::true_type {};
+
+// Forward difference Jacobian at state, given derivs there. Costs one
+// derivative evaluation per state component. Steps by the square root
+// of the state scalar's epsilon, so float columns are not lost to
+// rounding, and divides by the step as stored.
+template<typename DynamicEntity>
+Jacobian<DynamicEntity> FiniteDifferenceJacobian(const DynamicEntity& dynEntity,
+	const typename DynamicEntity::State& state,
+	const typename DynamicEntity::State& derivs)
+{
+	using State = typename DynamicEntity::State;
+	const double sqrtEpsilon = std::sqrt(static_cast<double>(std::numeric_limits<StepScalar<DynamicEntity>>::epsilon()));
+
+	Jacobian<DynamicEntity> jacobian;
+	State perturbed = state;
+	for (size_t col = 0; col < state.size(); ++col)
+	{
+		perturbed[col] = state[col] + sqrtEpsilon * std::max(1.0, std::abs(ScalarValue(state[col])));
+		const double step = ScalarValue(perturbed[col]) - ScalarValue(state[col]);
+		const State perturbedDerivs = dynEntity.CalcDerivs(perturbed);
+		perturbed[col] = state[col];
+
+		for (size_t row = 0; row < state.size(); ++row)
+		{
+			jacobian[row][col] = (perturbedDerivs[row] - derivs[row]) / step;
+		}
+	}
+
+	return jacobian;
+}
+
+// Solves a x = b by Gaussian elimination with partial pivoting,
+// leaving x in inOutB. Returns false if a is singular.
+template<typename Matrix, typename Vector>
+bool SolveLinear(Matrix& a, Vector& inOutB)
+{
+	const size_t size = inOutB.size();
+	for (size_t pivot = 0; pivot < size; ++pivot)
+	{
+		size_t best = pivot;
+		for (size_t row = pivot + 1; row < size; ++row)
+		{
+			if (std::abs(ScalarValue(a[row][pivot])) > std::abs(ScalarValue(a[best][pivot])))
+			{
+				best = row;
+			}
+		}
+
+		if (ScalarValue(a[best][pivot]) == 0.0)
+		{
+			return false;
+		}
+
+		std::swap(a[pivot], a[best]);
+		std::swap(inOutB[pivot], inOutB[best]);
+
+		for (size_t row = pivot + 1; row < size; ++row)
+		{
+			const auto factor = a[row][pivot] / a[pivot][pivot];
+			for (size_t col = pivot; col < size; ++col)
+			{
+				a[row][col] -= factor * a[pivot][col];
+			}
+			inOutB[row] -= factor * inOutB[pivot];
+		}
+	}
+
+	for (size_t row = size; row-- > 0; )
+	{
+		for (size_t col = row + 1; col < size; ++col)
+		{
+			inOutB[row] -= a[row][col] * inOutB[col];
+		}
+		inOutB[row] /= a[row][row];
+	}
+
+	return true;
+}
+
+// Newton iteration settings. Iteration stops once the update is
+// within m_Tolerance * (1 + |y|) in every component.
+struct NewtonSettings
+{
+	double m_Tolerance = 1.0e-10;
+	size_t m_MaxIterations = 10;
+};
+
+// Defaults for an entity's scalar type. Float states cannot get within
+// 1e-10, so the tolerance is kept at least a hundred epsilons.
+template<typename DynamicEntity>
+NewtonSettings DefaultNewtonSettings()
+{
+	NewtonSettings settings;
+	settings.m_Tolerance = std::max(settings.m_Tolerance,
+		100.0 * static_cast<double>(std::numeric_limits<StepScalar<DynamicEntity>>::epsilon()));
+	return settings;
+}
+
+// One theta method step, see above. Returns the number of derivative
+// evaluations, finite difference Jacobians included. outConverged is
+// false if Newton ran out of iterations or met a singular matrix, the
+// step then ends at the last iterate.
+template<typename DynamicEntity>
+size_t ThetaStep(DynamicEntity& inOutDynEntity, double deltaT, double theta, const NewtonSettings& settings, bool& outConverged)
+{
+	using State = typename DynamicEntity::State;
+	const size_t size = std::tuple_size<State>::value;
+
+	const State start = inOutDynEntity.m_State;
+	const State startDerivs = inOutDynEntity.CalcDerivs(start);
+	size_t derivEvals = 1;
+
+	// Fixed part of the residual, y0 + dt * (1 - theta) * f(y0).
+	State base;
+	base = start + deltaT * (1.0 - theta) * startDerivs;
+
+	State& y = inOutDynEntity.m_State;
+	State derivs = startDerivs;
+	outConverged = false;
+	for (size_t iteration = 0; iteration < settings.m_MaxIterations; ++iteration)
+	{
+		if (iteration > 0)
+		{
+			derivs = inOutDynEntity.CalcDerivs(y);
+			++derivEvals;
+		}
+
+		Jacobian<DynamicEntity> jacobian;
+		if constexpr (HasJacobian<DynamicEntity>::value)
+		{
+			jacobian = inOutDynEntity.CalcJacobian(y);
+		}
+		else
+		{
+			jacobian = FiniteDifferenceJacobian(inOutDynEntity, y, derivs);
+			derivEvals += size;
+		}
+
+		// Newton update for G(y) = y - base - dt * theta * f(y),
+		// dG/dy = I - dt * theta * J.
+		State update;
+		for (size_t row = 0; row < size; ++row)
+		{
+			update[row] = -(y[row] - base[row] - deltaT * theta * derivs[row]);
+			for (size_t col = 0; col < size; ++col)
+			{
+				jacobian[row][col] = (row == col ? 1.0 : 0.0) - deltaT * theta * jacobian[row][col];
+			}
+		}
+
+		if (!SolveLinear(jacobian, update))
+		{
+			break;
+		}
+
+		bool converged = true;
+		for (size_t idx = 0; idx < size; ++idx)
+		{
+			y[idx] += update[idx];
+			converged = converged && std::abs(ScalarValue(update[idx])) <= settings.m_Tolerance * (1.0 + std::abs(ScalarValue(y[idx])));
+		}
+
+		if (converged)
+		{
+			outConverged = true;
+			break;
+		}
+	}
+
+	ProjectState(inOutDynEntity);
+	return derivEvals;
+}
+
+// First order, L-stable. Damps stiff modes, and also some of the
+// physical oscillation at large steps.
+template<typename DynamicEntity>
+class BackwardEuler
+{
+public:
+	static constexpr const char* Name = "BackwardEuler";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		return ThetaStep(inOutDynEntity, deltaT, 1.0, m_Settings, m_Converged);
+	}
+
+	bool LastStepFailed() const
+	{
+		return !m_Converged;
+	}
+
+	NewtonSettings m_Settings = DefaultNewtonSettings<DynamicEntity>();
+
+private:
+	bool m_Converged = true;
+};
+
+// Second order, A-stable. Keeps the amplitude of linear oscillators
+// at any step size, but does not damp stiff modes.
+template<typename DynamicEntity>
+class Trapezoidal
+{
+public:
+	static constexpr const char* Name = "Trapezoidal";
+
+	size_t Step(DynamicEntity& inOutDynEntity, double deltaT)
+	{
+		return ThetaStep(inOutDynEntity, deltaT, 0.5, m_Settings, m_Converged);
+	}
+
+	bool LastStepFailed() const
+	{
+		return !m_Converged;
+	}
+
+	NewtonSettings m_Settings = DefaultNewtonSettings<DynamicEntity>();
+
+private:
+	bool m_Converged = true;
+};
+
+// Policies whose steps can fail, eg when Newton does not converge,
+// provide bool LastStepFailed() const. Simulation counts those steps
+// in StepStats::m_FailedSteps.
+template<typename Integrator, typename = void>
+struct CanFailStep : std::false_type {};
+
+template<typename Integrator>
+struct CanFailStep<Integrator, std::void_t<decltype(std::declval<const Integrator&>().LastStepFailed())>>
+	: std::true_type {};
+
+////////////////////////////////////////////////////////////
+// Adaptive stepping.
+
+// Error control settings for adaptive integrators. A step is
+// accepted when every state component's error estimate is
+// within m_AbsTol + m_RelTol * |state|, in the RMS sense.
+struct AdaptiveTolerances
+{
+	double m_AbsTol = 1.0e-6;
+	double m_RelTol = 1.0e-6;
+	double m_MinDeltaT = 1.0e-12;	// in seconds. Steps are never rejected below this.
+	double m_MaxDeltaT = std::numeric_limits<double>::infinity(); // in seconds.
+};
+
+// Work counters, eg for comparing adaptive against fixed stepping.
+struct StepStats
+{
+	size_t m_AcceptedSteps = 0;
+	size_t m_RejectedSteps = 0;
+	size_t m_DerivEvals = 0;
+	size_t m_FailedSteps = 0;	// Taken without meeting their error or convergence test.
+};
+
+// State carried from one adaptive step to the next.
+template<typename DynamicEntity>
+struct AdaptiveStepState
+{
+	typename DynamicEntity::State m_Derivs{};	// Derivatives at the current state (first same as last).
+	bool m_HasDerivs = false;
+	double m_DeltaT = 0.0;						// Next step size to try, zero to start from maxDeltaT.
+};
+
+// Dormand-Prince 5(4) embedded Runge-Kutta step with error control.
+// Retries with smaller steps until the error estimate is within
+// tolerance, then advances the entity by the 5th order solution.
+// Never steps further than maxDeltaT. Returns the step size taken.
+// A non-finite error estimate, eg from an overflowing or NaN state,
+// no smaller step can fix, so the step is taken and counted in
+// m_FailedSteps.
+template<typename DynamicEntity>
+double DormandPrinceStep(DynamicEntity& inOutDynEntity,
+	double maxDeltaT,
+	const AdaptiveTolerances& tolerances,
+	AdaptiveStepState<DynamicEntity>& inOutStepState,
+	StepStats& inOutStats)
+{
+	using State = typename DynamicEntity::State;
+
+	// Butcher tableau.
+	constexpr double a21 = 1.0/5.0;
+	constexpr double a31 = 3.0/40.0, a32 = 9.0/40.0;
+	constexpr double a41 = 44.0/45.0, a42 = -56.0/15.0, a43 = 32.0/9.0;
+	constexpr double a51 = 19372.0/6561.0, a52 = -25360.0/2187.0, a53 = 64448.0/6561.0, a54 = -212.0/729.0;
+	constexpr double a61 = 9017.0/3168.0, a62 = -355.0/33.0, a63 = 46732.0/5247.0, a64 = 49.0/176.0, a65 = -5103.0/18656.0;
+	constexpr double b1 = 35.0/384.0, b3 = 500.0/1113.0, b4 = 125.0/192.0, b5 = -2187.0/6784.0, b6 = 11.0/84.0;
+
+	// Difference between 5th and 4th order weights.
+	constexpr double e1 = 71.0/57600.0, e3 = -71.0/16695.0, e4 = 71.0/1920.0, e5 = -17253.0/339200.0, e6 = 22.0/525.0, e7 = -1.0/40.0;
+
+	const State& y = inOutDynEntity.m_State;
+
+	if (!inOutStepState.m_HasDerivs)
+	{
+		inOutStepState.m_Derivs = inOutDynEntity.CalcDerivs();
+		inOutStepState.m_HasDerivs = true;
+		++inOutStats.m_DerivEvals;
+	}
+	const State& k1 = inOutStepState.m_Derivs;
+
+	double deltaT = (inOutStepState.m_DeltaT > 0.0) ? inOutStepState.m_DeltaT : maxDeltaT;
+	State stage;
+
+	while (true)
+	{
+		deltaT = std::min({deltaT, maxDeltaT, tolerances.m_MaxDeltaT});
+		const double h = deltaT;
+
+		stage = y + h * a21 * k1;
+		const State k2 = inOutDynEntity.CalcDerivs(stage);
+
+		stage = y + h * (a31 * k1 + a32 * k2);
+		const State k3 = inOutDynEntity.CalcDerivs(stage);
+
+		stage = y + h * (a41 * k1 + a42 * k2 + a43 * k3);
+		const State k4 = inOutDynEntity.CalcDerivs(stage);
+
+		stage = y + h * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4);
+		const State k5 = inOutDynEntity.CalcDerivs(stage);
+
+		stage = y + h * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5);
+		const State k6 = inOutDynEntity.CalcDerivs(stage);
+
+		// 5th order solution, k7 is evaluated there and reused as k1 of
+		// the next step.
+		stage = y + h * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+		const State k7 = inOutDynEntity.CalcDerivs(stage);
+		inOutStats.m_DerivEvals += 6;
+
+		// RMS of the scaled error estimate, evaluated element by
+		// element in the norm's own pass.
+		const auto errEstimate = e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7;
+		double errSq = 0.0;
+		for (size_t idx = 0; idx < y.size(); ++idx)
+		{
+			const double err = h * ScalarValue(errEstimate[idx]);
+			const double scale = tolerances.m_AbsTol + tolerances.m_RelTol * std::max(std::abs(ScalarValue(y[idx])), std::abs(ScalarValue(stage[idx])));
+			errSq += (err / scale) * (err / scale);
+		}
+		const double errNorm = std::sqrt(errSq / y.size());
+		if (!std::isfinite(errNorm))
+		{
+			inOutDynEntity.m_State = stage;
+			inOutStepState.m_Derivs = k7;
+			++inOutStats.m_FailedSteps;
+			return h;
+		}
+
+		// Standard step size controller, with safety factor and limits
+		// on how fast the step may grow or shrink.
+		const double factor = (errNorm == 0.0) ? 5.0 : std::clamp(0.9 * std::pow(errNorm, -0.2), 0.2, 5.0);
+
+		if (errNorm <= 1.0 || h <= tolerances.m_MinDeltaT)
+		{
+			inOutDynEntity.m_State = stage;
+			ProjectState(inOutDynEntity);
+			inOutStepState.m_Derivs = k7;
+			inOutStepState.m_DeltaT = std::max(h * factor, tolerances.m_MinDeltaT);
+			++inOutStats.m_AcceptedSteps;
+			return h;
+		}
+
+		++inOutStats.m_RejectedSteps;
+		deltaT = std::max(h * factor, tolerances.m_MinDeltaT);
+	}
+}
+
+// Adaptive integrator policy, used as the Integrator parameter of
+// Simulation like the fixed step ones, eg Simulation<CrudeSpinningPen,
+// Integrators::DormandPrince>. Step() takes one Dormand-Prince step
+// of at most maxDeltaT and returns the step size taken. The policy
+// owns the error control state and the derivatives reused from one
+// step to the next, so it is checkpointed with the run.
+template<typename DynamicEntity>
+class DormandPrince
+{
+public:
+	static constexpr const char* Name = "DormandPrince";
+	static constexpr bool IsAdaptive = true;
+
+	double Step(DynamicEntity& inOutDynEntity, double maxDeltaT, StepStats& inOutStats)
+	{
+		return DormandPrinceStep(inOutDynEntity, maxDeltaT, m_Tolerances, m_StepState, inOutStats);
+	}
+
+	const AdaptiveTolerances& GetTolerances() const
+	{
+		return m_Tolerances;
+	}
+
+	void SetTolerances(const AdaptiveTolerances& tolerances)
+	{
+		m_Tolerances = tolerances;
+	}
+
+	// Size of the next step to try, zero to start from maxDeltaT.
+	void SetDeltaT(double deltaT)
+	{
+		m_StepState.m_DeltaT = deltaT;
+	}
+
+	// Derivatives at the entity's state after the last Step(), if any.
+	bool HasDerivs() const
+	{
+		return m_StepState.m_HasDerivs;
+	}
+
+	const typename DynamicEntity::State& GetDerivs() const
+	{
+		return m_StepState.m_Derivs;
+	}
+
+	// Call when the entity's state was changed outside Step().
+	void ResetDerivs()
+	{
+		m_StepState.m_HasDerivs = false;
+	}
+
+private:
+	AdaptiveTolerances m_Tolerances;
+	AdaptiveStepState<DynamicEntity> m_StepState;
+};
+
+// True for policies stepping by error control, which Simulation
+// drives with Step(entity, maxDeltaT, stats).
+template<typename Integrator, typename = void>
+struct IsAdaptive : std::false_type {};
+
+template<typename Integrator>
+struct IsAdaptive<Integrator, std::void_t<decltype(Integrator::IsAdaptive)>>
+	: std::bool_constant<Integrator::IsAdaptive> {};
+
+////////////////////////////////////////////////////////////
+// Dense output. Inside a step the state is approximated by
+// the cubic Hermite interpolant of the states and derivatives
+// at both ends. Locally 4th order, so it keeps up with RK4
+// and matches the order of Dormand-Prince's own continuous
+// extension, and it needs nothing from the integrator.
+
+// State at fraction theta, in [0, 1], of a step of size h from y0
+// to y1, with derivatives f0 and f1 there.
+template<typename State>
+State HermiteInterpolate(const State& y0, const State& f0, const State& y1, const State& f1, double h, double theta)
+{
+	const double theta2 = theta * theta;
+	const double theta3 = theta2 * theta;
+	const double h00 = 2.0 * theta3 - 3.0 * theta2 + 1.0;
+	const double h10 = (theta3 - 2.0 * theta2 + theta) * h;
+	const double h01 = 3.0 * theta2 - 2.0 * theta3;
+	const double h11 = (theta3 - theta2) * h;
+
+	State out;
+	out = h00 * y0 + h10 * f0 + h01 * y1 + h11 * f1;
+	return out;
+}
+
+////////////////////////////////////////////////////////////
+// EntityBatch overloads. Each state field of a batch is a
+// contiguous column, so every update below is a single
+// streaming pass the compiler can vectorize. Derivatives
+// and stage states live in the batch's own workspace.
+
+// outColumn = baseColumn + scale * derivColumn, in the column's
+// own type, eg float.
+template<typename Column>
+void AxpyColumn(Column& outColumn, const Column& baseColumn, double scale, const Column& derivColumn)
+{
+	using Value = typename Column::value_type;
+	const Value columnScale = static_cast<Value>(scale);
+	const size_t count = outColumn.size();
+	for (size_t idx = 0; idx < count; ++idx)
+	{
+		outColumn[idx] = baseColumn[idx] + columnScale * derivColumn[idx];
+	}
+}
+
+template<typename DynamicEntity>
+void EulerStep(EntityBatch<DynamicEntity>& inOutBatch, double deltaT)
+{
+	inOutBatch.CalcDerivs(inOutBatch.m_State, inOutBatch.m_Derivs);
+
+	for (size_t field = 0; field < inOutBatch.m_State.size(); ++field)
+	{
+		AxpyColumn(inOutBatch.m_State[field], inOutBatch.m_State[field], deltaT, inOutBatch.m_Derivs[field]);
+	}
+}
+
+template<typename DynamicEntity>
+void MidPointStep(EntityBatch<DynamicEntity>& inOutBatch, double deltaT)
+{
+	inOutBatch.CalcDerivs(inOutBatch.m_State, inOutBatch.m_Derivs);
+
+	for (size_t field = 0; field < inOutBatch.m_State.size(); ++field)
+	{
+		AxpyColumn(inOutBatch.m_Stage[field], inOutBatch.m_State[field], 0.5 * deltaT, inOutBatch.m_Derivs[field]);
+	}
+
+	inOutBatch.CalcDerivs(inOutBatch.m_Stage, inOutBatch.m_Derivs);
 
-	typename DynamicEntity::State midDerivs = midDynEntity.CalcDerivs();
-    
-	for (size_t idx = 0; idx < midDerivs.size(); ++idx)
+	for (size_t field = 0; field < inOutBatch.m_State.size(); ++field)
 	{
-		inOutDynEntity.m_State[idx] += deltaT * midDerivs[idx];
+		AxpyColumn(inOutBatch.m_State[field], inOutBatch.m_State[field], deltaT, inOutBatch.m_Derivs[field]);
 	}
 }
 
@@ -0,0 +1,182 @@
+#include "./DynamicEntities.h"
+#include "./DynamicEntityBatches.h"
+#include "./Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Integrators_Bench
+// Descr: Times every entity in DynamicEntities.h under every
+// integrator in Integrators.h, across step sizes, and the
+// batched pen, in double and float, across batch sizes.
+// Entities with conserved quantities are also run with the
+// invariant monitor on, for its overhead. Writes JSON, one result per combination, to stdout or to
+// the given file.
+// Usage: ./Integrators_Bench [output.json]
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+struct BenchResult
+{
+    std::string m_Entity;
+    std::string m_Integrator;
+    double m_DeltaT;
+    size_t m_BatchSize;
+    size_t m_Steps;
+    size_t m_DerivEvals;        // Summed over the batch.
+    double m_Seconds;
+};
+
+const std::vector<double> DeltaTs{1.0e-2, 1.0e-3, 1.0e-4};
+const size_t StepsPerRun = 200000;
+
+// Keeps the optimizer from discarding the benchmarked work.
+volatile double g_Sink = 0.0;
+
+template <typename DynamicEntityType, template <typename> class Integrator>
+void BenchSimulation(const DynamicEntityType& dynEntity, const std::string& integratorName, size_t stepsPerDriftCheck, std::vector<BenchResult>& outResults)
+{
+    using SimulationType = Simulation<DynamicEntityType, Integrator>;
+
+    for (double deltaT : DeltaTs)
+    {
+        SimulationType sim(StepsPerRun * deltaT, deltaT, false, dynEntity);
+        if constexpr (Invariants::HasConservedQuantities<DynamicEntityType>::value)
+        {
+            // Never over budget, so every check is paid for. Zero is no monitor.
+            if (stepsPerDriftCheck > 0)
+            {
+                sim.SetInvariantMonitor(std::numeric_limits<double>::infinity(), SimulationType::EventAction::Record,
+                    typename SimulationType::DriftAlarm{}, stepsPerDriftCheck);
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        sim.Run();
+        const auto stop = std::chrono::steady_clock::now();
+
+        g_Sink = g_Sink + sim.GetOutput()[0];
+        const Integrators::StepStats& stats = sim.GetStepStats();
+        outResults.push_back(BenchResult{DynamicEntityType::Name, integratorName, deltaT, 1,
+            stats.m_AcceptedSteps + stats.m_RejectedSteps, stats.m_DerivEvals,
+            std::chrono::duration<double>(stop - start).count()});
+    }
+}
+
+template <typename DynamicEntityType>
+void BenchEntity(const DynamicEntityType& dynEntity, std::vector<BenchResult>& outResults)
+{
+    BenchSimulation<DynamicEntityType, Integrators::Euler>(dynEntity, "Euler", 0, outResults);
+    BenchSimulation<DynamicEntityType, Integrators::MidPoint>(dynEntity, "MidPoint", 0, outResults);
+    BenchSimulation<DynamicEntityType, Integrators::RK4>(dynEntity, "RK4", 0, outResults);
+    if constexpr (Integrators::SupportsVelocityVerlet<DynamicEntityType>)
+    {
+        BenchSimulation<DynamicEntityType, Integrators::VelocityVerlet>(dynEntity, "VelocityVerlet", 0, outResults);
+    }
+    BenchSimulation<DynamicEntityType, Integrators::DormandPrince>(dynEntity, "DormandPrince", 0, outResults);
+    BenchSimulation<DynamicEntityType, Integrators::BackwardEuler>(dynEntity, "BackwardEuler", 0, outResults);
+    BenchSimulation<DynamicEntityType, Integrators::Trapezoidal>(dynEntity, "Trapezoidal", 0, outResults);
+
+    if constexpr (Invariants::HasConservedQuantities<DynamicEntityType>::value)
+    {
+        BenchSimulation<DynamicEntityType, Integrators::Euler>(dynEntity, "Euler+Invariants", 1, outResults);
+        BenchSimulation<DynamicEntityType, Integrators::RK4>(dynEntity, "RK4+Invariants", 1, outResults);
+        BenchSimulation<DynamicEntityType, Integrators::RK4>(dynEntity, "RK4+Invariants/10", 10, outResults);
+    }
+}
+
+template <typename Batch, typename StepFunction>
+void BenchBatch(const std::string& batchName, const std::vector<typename Batch::Pen>& pens, const std::string& integratorName, size_t derivEvalsPerStep, StepFunction step, std::vector<BenchResult>& outResults)
+{
+    for (double deltaT : DeltaTs)
+    {
+        Batch batch(pens);
+        const size_t steps = std::max<size_t>(StepsPerRun / pens.size(), 100);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t idx = 0; idx < steps; ++idx)
+        {
+            step(batch, deltaT);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+
+        g_Sink = g_Sink + batch.m_State[0][0];
+        outResults.push_back(BenchResult{batchName, integratorName, deltaT, pens.size(),
+            steps, steps * derivEvalsPerStep * pens.size(),
+            std::chrono::duration<double>(stop - start).count()});
+    }
+}
+
+void WriteJson(std::ostream& out, const std::vector<BenchResult>& results)
+{
+    out << "{\n  \"benchmark\": \"Integrators_Bench\",\n  \"results\": [\n";
+    for (size_t idx = 0; idx < results.size(); ++idx)
+    {
+        const BenchResult& result = results[idx];
+        const double nsPerStep = 1.0e9 * result.m_Seconds / result.m_Steps;
+
+        out << "    {\"entity\": \"" << result.m_Entity << "\""
+            << ", \"integrator\": \"" << result.m_Integrator << "\""
+            << ", \"dt\": " << result.m_DeltaT
+            << ", \"batch_size\": " << result.m_BatchSize
+            << ", \"steps\": " << result.m_Steps
+            << ", \"deriv_evals\": " << result.m_DerivEvals
+            << ", \"seconds\": " << result.m_Seconds
+            << ", \"ns_per_step\": " << nsPerStep
+            << ", \"ns_per_entity_step\": " << nsPerStep / result.m_BatchSize
+            << ", \"deriv_evals_per_s\": " << result.m_DerivEvals / result.m_Seconds
+            << "}" << (idx + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<BenchResult> results;
+
+    const CrudeSpinningPen::State penState{
+        0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+    const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+
+    BenchEntity(ConstantVelParticle{ConstantVelParticle::State{0.0, 1.0}}, results);
+    BenchEntity(SimpleSpringMotion{SimpleSpringMotion::State{1.0, 0.0}, 4.0}, results);
+    BenchEntity(CrudeSpinningPen{penState, inertia}, results);
+    BenchEntity(QuaternionSpinningPen{QuaternionSpinningPen::State{
+        0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0}, inertia}, results);
+
+    for (size_t batchSize : {1, 16, 256, 4096})
+    {
+        const std::vector<CrudeSpinningPen> pens(batchSize, CrudeSpinningPen{penState, inertia});
+        BenchBatch<CrudeSpinningPenBatch>("CrudeSpinningPenBatch", pens, "Euler", 1, [](CrudeSpinningPenBatch& batch, double deltaT){ Integrators::EulerStep(batch, deltaT); }, results);
+        BenchBatch<CrudeSpinningPenBatch>("CrudeSpinningPenBatch", pens, "MidPoint", 2, [](CrudeSpinningPenBatch& batch, double deltaT){ Integrators::MidPointStep(batch, deltaT); }, results);
+
+        // Same pens in float, half the bytes per pen.
+        CrudeSpinningPenT<float>::State floatState;
+        std::copy(penState.begin(), penState.end(), floatState.begin());
+        const std::vector<CrudeSpinningPenT<float>> floatPens(batchSize, CrudeSpinningPenT<float>{floatState, {10.0f, 10.0f, 1.0f}});
+        BenchBatch<CrudeSpinningPenBatchF>("CrudeSpinningPenBatchF", floatPens, "Euler", 1, [](CrudeSpinningPenBatchF& batch, double deltaT){ Integrators::EulerStep(batch, deltaT); }, results);
+        BenchBatch<CrudeSpinningPenBatchF>("CrudeSpinningPenBatchF", floatPens, "MidPoint", 2, [](CrudeSpinningPenBatchF& batch, double deltaT){ Integrators::MidPointStep(batch, deltaT); }, results);
+    }
+
+    if (argc > 1)
+    {
+        std::ofstream file(argv[1]);
+        WriteJson(file, results);
+    }
+    else
+    {
+        WriteJson(std::cout, results);
+    }
+
+    return 0;
+}
@@ -2,7 +2,9 @@
 #include "./DynamicEntities.h"
 #include "./TestUtils.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iostream>
 
 //////////////////////////////////////////////////////////
@@ -30,5 +32,264 @@ int main(void)
         const bool testCvpMid = TestUtils::FloatEquals(cvpMid.m_State,ConstantVelParticle::State{0.1, 1.0}, 1.0e-6);
         TestUtils::ReportResults(testCvpMid, "MidPoint Step: Constant Velocity");
     }
+
+    ////////////////////////////////////////////////////////////
+    // Test RK4 step.
+    {
+        ConstantVelParticle cvpRK4{ConstantVelParticle::State{0, 1.0}};
+        Integrators::RK4Step(cvpRK4, 0.1);
+
+        const bool testCvpRK4 = TestUtils::FloatEquals(cvpRK4.m_State, ConstantVelParticle::State{0.1, 1.0}, 1.0e-6);
+        TestUtils::ReportResults(testCvpRK4, "RK4 Step: Constant Velocity");
+
+        // One step of the spring, x = cos(2t), is accurate to 5th order.
+        SimpleSpringMotion shoRK4{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        Integrators::RK4Scratch<SimpleSpringMotion> scratch;
+        Integrators::RK4Step(shoRK4, 0.1, scratch);
+
+        const SimpleSpringMotion::State expected{std::cos(0.2), -2.0 * std::sin(0.2)};
+        const bool testShoRK4 = TestUtils::FloatEquals(shoRK4.m_State, expected, 1.0e-5);
+        TestUtils::ReportResults(testShoRK4, "RK4 Step: Spring Matches Analytic");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test velocity Verlet step.
+    {
+        ConstantVelParticle cvpVerlet{ConstantVelParticle::State{0, 1.0}};
+        Integrators::VelocityVerletStep(cvpVerlet, 0.1);
+
+        const bool testCvpVerlet = TestUtils::FloatEquals(cvpVerlet.m_State, ConstantVelParticle::State{0.1, 1.0}, 1.0e-6);
+        TestUtils::ReportResults(testCvpVerlet, "Verlet Step: Constant Velocity");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test only entities with position only accelerations opt in
+    // to Verlet, the pens' rate dependent accelerations make it
+    // first order.
+    {
+        const bool optInEq = Integrators::SupportsVelocityVerlet<ConstantVelParticle> &&
+            Integrators::SupportsVelocityVerlet<SimpleSpringMotion> &&
+            !Integrators::SupportsVelocityVerlet<CrudeSpinningPen> &&
+            !Integrators::SupportsVelocityVerlet<QuaternionSpinningPen>;
+        TestUtils::ReportResults(optInEq, "Verlet Step: Opt In");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test long run spring energy drift. Verlet is symplectic, its
+    // energy error stays bounded, while midpoint's keeps growing.
+    {
+        const double kOverM = 1.0;
+        const double deltaT = 0.1;
+        const size_t numSteps = 100000;
+
+        auto energy = [=](const SimpleSpringMotion::State& state)
+        {
+            return 0.5 * state[1] * state[1] + 0.5 * kOverM * state[0] * state[0];
+        };
+
+        SimpleSpringMotion shoVerlet{SimpleSpringMotion::State{1.0, 0.0}, kOverM};
+        SimpleSpringMotion shoMid = shoVerlet;
+        const double initialEnergy = energy(shoVerlet.m_State);
+
+        Integrators::VerletScratch<SimpleSpringMotion> scratch;
+        double maxVerletDrift = 0.0;
+        for (size_t step = 0; step < numSteps; ++step)
+        {
+            Integrators::VelocityVerletStep(shoVerlet, deltaT, scratch);
+            Integrators::MidPointStep(shoMid, deltaT);
+            maxVerletDrift = std::max(maxVerletDrift, std::abs(energy(shoVerlet.m_State) - initialEnergy) / initialEnergy);
+        }
+        const double midDrift = std::abs(energy(shoMid.m_State) - initialEnergy) / initialEnergy;
+
+        TestUtils::ReportResults(maxVerletDrift < 0.01, "Verlet Step: Spring Energy Bounded");
+        TestUtils::ReportResults(midDrift > 10.0 * maxVerletDrift, "Verlet Step: Less Drift Than MidPoint");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test Dormand-Prince step on constant velocity, which it
+    // integrates exactly in one step.
+    {
+        ConstantVelParticle cvpDopri{ConstantVelParticle::State{0, 1.0}};
+        Integrators::AdaptiveStepState<ConstantVelParticle> stepState;
+        Integrators::StepStats stats;
+        const double stepTaken = Integrators::DormandPrinceStep(cvpDopri, 0.1, Integrators::AdaptiveTolerances{}, stepState, stats);
+
+        const bool testCvpDopri = TestUtils::FloatEquals(cvpDopri.m_State, ConstantVelParticle::State{0.1, 1.0}, 1.0e-12) &&
+            stepTaken == 0.1 && stats.m_AcceptedSteps == 1 && stats.m_RejectedSteps == 0 && stats.m_DerivEvals == 7;
+        TestUtils::ReportResults(testCvpDopri, "Dormand-Prince Step: Constant Velocity");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test Dormand-Prince step on a NaN state returns, counted as
+    // failed, instead of shrinking the step forever.
+    {
+        ConstantVelParticle cvpNan{ConstantVelParticle::State{std::nan(""), 1.0}};
+        Integrators::AdaptiveStepState<ConstantVelParticle> stepState;
+        Integrators::StepStats stats;
+        const double stepTaken = Integrators::DormandPrinceStep(cvpNan, 0.1, Integrators::AdaptiveTolerances{}, stepState, stats);
+
+        const bool testNanDopri = stepTaken == 0.1 && stats.m_FailedSteps == 1 && stepState.m_DeltaT == 0.0;
+        TestUtils::ReportResults(testNanDopri, "Dormand-Prince Step: Non-Finite State Fails");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test adaptive Dormand-Prince against the analytic spring
+    // solution x = cos(2t), starting from an oversized step.
+    {
+        SimpleSpringMotion shoDopri{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        Integrators::AdaptiveTolerances tolerances;
+        tolerances.m_AbsTol = 1.0e-9;
+        tolerances.m_RelTol = 1.0e-9;
+        Integrators::AdaptiveStepState<SimpleSpringMotion> stepState;
+        stepState.m_DeltaT = 1.0;
+        Integrators::StepStats stats;
+
+        const double duration = 5.0;
+        double elapsedTime = 0.0;
+        while (elapsedTime < duration)
+        {
+            elapsedTime += Integrators::DormandPrinceStep(shoDopri, duration - elapsedTime, tolerances, stepState, stats);
+        }
+
+        const SimpleSpringMotion::State expected{std::cos(2.0 * duration), -2.0 * std::sin(2.0 * duration)};
+        const bool testShoDopri = TestUtils::FloatEquals(shoDopri.m_State, expected, 1.0e-7);
+        TestUtils::ReportResults(testShoDopri, "Dormand-Prince Step: Spring Matches Analytic");
+        TestUtils::ReportResults(stats.m_RejectedSteps > 0, "Dormand-Prince Step: Rejects Oversized Step");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test finite difference Jacobian against the analytic one.
+    {
+        const SimpleSpringMotion sho{SimpleSpringMotion::State{0.3, -2.0}, 9.0};
+        const auto analytic = sho.CalcJacobian(sho.m_State);
+        const auto numeric = Integrators::FiniteDifferenceJacobian(sho, sho.m_State, sho.CalcDerivs());
+
+        const bool testJacobian = TestUtils::FloatEquals(numeric[0], analytic[0], 1.0e-6) &&
+            TestUtils::FloatEquals(numeric[1], analytic[1], 1.0e-6);
+        TestUtils::ReportResults(testJacobian, "Implicit Step: Finite Difference Jacobian");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test a stiff spring, omega * dt = 10. Midpoint blows up,
+    // backward Euler stays bounded and trapezoidal keeps the
+    // energy.
+    {
+        const double kOverM = 1.0e6;
+        const double deltaT = 0.01;
+        auto energy = [&](const SimpleSpringMotion::State& state)
+        {
+            return 0.5 * state[1] * state[1] + 0.5 * kOverM * state[0] * state[0];
+        };
+
+        SimpleSpringMotion shoMid{SimpleSpringMotion::State{1.0, 0.0}, kOverM};
+        SimpleSpringMotion shoBackward = shoMid;
+        SimpleSpringMotion shoTrapezoidal = shoMid;
+        const double initialEnergy = energy(shoMid.m_State);
+
+        Integrators::BackwardEuler<SimpleSpringMotion> backwardEuler;
+        Integrators::Trapezoidal<SimpleSpringMotion> trapezoidal;
+        size_t derivEvals = 0;
+        for (size_t step = 0; step < 100; ++step)
+        {
+            Integrators::MidPointStep(shoMid, deltaT);
+            backwardEuler.Step(shoBackward, deltaT);
+            derivEvals += trapezoidal.Step(shoTrapezoidal, deltaT);
+        }
+
+        TestUtils::ReportResults(energy(shoMid.m_State) > 1.0e6 * initialEnergy, "Implicit Step: Stiff Spring MidPoint Unstable");
+        TestUtils::ReportResults(energy(shoBackward.m_State) < initialEnergy, "Implicit Step: Stiff Spring Backward Euler Stable");
+
+        // Linear, so Newton converges on the second iteration.
+        const bool testTrapezoidal = std::abs(energy(shoTrapezoidal.m_State) - initialEnergy) < 1.0e-9 * initialEnergy &&
+            derivEvals == 2 * 100 && !trapezoidal.LastStepFailed() && !backwardEuler.LastStepFailed();
+        TestUtils::ReportResults(testTrapezoidal, "Implicit Step: Stiff Spring Trapezoidal Energy");
+
+        // One iteration cannot confirm convergence.
+        Integrators::Trapezoidal<SimpleSpringMotion> capped;
+        capped.m_Settings.m_MaxIterations = 1;
+        SimpleSpringMotion shoCapped{SimpleSpringMotion::State{1.0, 0.0}, kOverM};
+        capped.Step(shoCapped, deltaT);
+        TestUtils::ReportResults(capped.LastStepFailed(), "Implicit Step: Newton Not Converged Reported");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test trapezoidal accuracy, with an analytic and with a
+    // finite difference Jacobian.
+    {
+        SimpleSpringMotion shoTrapezoidal{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        Integrators::Trapezoidal<SimpleSpringMotion> trapezoidal;
+        for (size_t step = 0; step < 1000; ++step)
+        {
+            trapezoidal.Step(shoTrapezoidal, 0.001);
+        }
+
+        const SimpleSpringMotion::State expected{std::cos(2.0), -2.0 * std::sin(2.0)};
+        TestUtils::ReportResults(TestUtils::FloatEquals(shoTrapezoidal.m_State, expected, 1.0e-6), "Implicit Step: Trapezoidal Spring Matches Analytic");
+
+        const CrudeSpinningPen::State penState{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+        CrudeSpinningPen penTrapezoidal{penState, {10.0, 10.0, 1.0}};
+        CrudeSpinningPen penRK4 = penTrapezoidal;
+        Integrators::Trapezoidal<CrudeSpinningPen> penIntegrator;
+        for (size_t step = 0; step < 500; ++step)
+        {
+            penIntegrator.Step(penTrapezoidal, 0.001);
+        }
+        Integrators::RK4Scratch<CrudeSpinningPen> scratch;
+        for (size_t step = 0; step < 500; ++step)
+        {
+            Integrators::RK4Step(penRK4, 0.001, scratch);
+        }
+
+        TestUtils::ReportResults(TestUtils::FloatEquals(penTrapezoidal.m_State, penRK4.m_State, 1.0e-3), "Implicit Step: Trapezoidal Pen Without Jacobian");
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Test float states: finite differences must step by more than
+    // float rounding, and Newton must converge to float precision
+    // rather than run out of iterations.
+    {
+        using PenF = CrudeSpinningPenT<float>;
+        const CrudeSpinningPen::State penState{
+            0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+        PenF::State penStateF;
+        std::copy(penState.begin(), penState.end(), penStateF.begin());
+        const CrudeSpinningPen pen{penState, {10.0, 10.0, 1.0}};
+        PenF penF{penStateF, {10.0f, 10.0f, 1.0f}};
+
+        const auto jacobian = Integrators::FiniteDifferenceJacobian(pen, pen.m_State, pen.CalcDerivs());
+        const auto jacobianF = Integrators::FiniteDifferenceJacobian(penF, penF.m_State, penF.CalcDerivs());
+        double jacobianErr = 0.0;
+        double jacobianSum = 0.0;
+        for (size_t row = 0; row < jacobian.size(); ++row)
+        {
+            for (size_t col = 0; col < jacobian.size(); ++col)
+            {
+                jacobianErr += std::abs(jacobianF[row][col] - jacobian[row][col]);
+                jacobianSum += std::abs(jacobian[row][col]);
+            }
+        }
+        TestUtils::ReportResults(jacobianErr < 1.0e-2 * jacobianSum, "Implicit Step: Float Finite Difference Jacobian");
+
+        CrudeSpinningPen penTrapezoidal = pen;
+        Integrators::Trapezoidal<CrudeSpinningPen> integrator;
+        Integrators::Trapezoidal<PenF> integratorF;
+        const size_t numSteps = 100;
+        size_t derivEvalsF = 0;
+        for (size_t step = 0; step < numSteps; ++step)
+        {
+            integrator.Step(penTrapezoidal, 0.001);
+            derivEvalsF += integratorF.Step(penF, 0.001);
+        }
+
+        // Newton with finite differences costs 13 evaluations an
+        // iteration, all 10 iterations would be 130 a step.
+        CrudeSpinningPen::State widened;
+        std::copy(penF.m_State.begin(), penF.m_State.end(), widened.begin());
+        const bool testFloat = TestUtils::FloatEquals(widened, penTrapezoidal.m_State, 1.0e-3) &&
+            derivEvalsF <= numSteps * (1 + 4 * 13);
+        TestUtils::ReportResults(testFloat, "Implicit Step: Float Trapezoidal Pen Converges");
+    }
+
     return 0;
 }
\ No newline at end of file
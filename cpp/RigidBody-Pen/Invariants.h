@@ -0,0 +1,154 @@
+#pragma once
+
+#include "./Dual.h"
+
+#include <array>
+#include <cmath>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Invariants
+// Descr: Drift of the quantities an entity's exact dynamics
+// conserve, eg energy, as a run goes on. A growing drift is
+// the integrator losing accuracy, so watching it tells how
+// large a step the run can afford. Entities opt in with
+// ConservedNames and ConservedQuantities(state), see
+// DynamicEntities.h.
+//////////////////////////////////////////////////////////
+
+namespace Invariants
+{
+
+template <typename DynamicEntity, typename = void>
+struct HasConservedQuantities : std::false_type {};
+
+template <typename DynamicEntity>
+struct HasConservedQuantities<DynamicEntity,
+    std::void_t<decltype(std::declval<const DynamicEntity&>().ConservedQuantities(std::declval<const typename DynamicEntity::State&>()))>>
+    : std::true_type {};
+
+// Number of conserved quantities, zero for entities without any.
+template <typename DynamicEntity, typename = void>
+struct NumConserved : std::integral_constant<size_t, 0> {};
+
+template <typename DynamicEntity>
+struct NumConserved<DynamicEntity, std::enable_if_t<HasConservedQuantities<DynamicEntity>::value>>
+    : std::tuple_size<decltype(std::declval<const DynamicEntity&>().ConservedQuantities(std::declval<const typename DynamicEntity::State&>()))> {};
+
+// Relative drift of each conserved quantity from its value at
+// Begin(), |q - q0| / |q0|, or |q - q0| where q0 is zero. A check
+// only evaluates the quantities at the current state, so it costs a
+// few flops per step and no memory.
+template <typename DynamicEntity>
+class DriftMonitor
+{
+public:
+
+    static constexpr size_t NumQuantities = NumConserved<DynamicEntity>::value;
+    using Drifts = std::array<double, NumQuantities>;
+
+    void Begin(const DynamicEntity& dynEntity)
+    {
+        m_Reference = Values(dynEntity);
+        for (size_t idx = 0; idx < NumQuantities; ++idx)
+        {
+            const double reference = std::abs(m_Reference[idx]);
+            m_InverseScale[idx] = reference > 0.0 ? 1.0 / reference : 1.0;
+        }
+        m_Drift = Drifts{};
+        m_MaxDrift = Drifts{};
+        m_Exceeded = std::array<bool, NumQuantities>{};
+    }
+
+    // Updates the drifts at dynEntity's state. Calls
+    // onExceeded(quantityIdx, drift) for each quantity whose drift
+    // exceeds maxRelDrift for the first time since Begin(), and returns
+    // true if there was any.
+    template <typename OnExceeded>
+    bool Check(const DynamicEntity& dynEntity, double maxRelDrift, OnExceeded onExceeded)
+    {
+        const Drifts values = Values(dynEntity);
+
+        bool exceeded = false;
+        for (size_t idx = 0; idx < NumQuantities; ++idx)
+        {
+            m_Drift[idx] = std::abs(values[idx] - m_Reference[idx]) * m_InverseScale[idx];
+            m_MaxDrift[idx] = std::max(m_MaxDrift[idx], m_Drift[idx]);
+
+            if (m_Drift[idx] > maxRelDrift && !m_Exceeded[idx])
+            {
+                m_Exceeded[idx] = true;
+                exceeded = true;
+                onExceeded(idx, m_Drift[idx]);
+            }
+        }
+        return exceeded;
+    }
+
+    // Drifts at the last Check().
+    const Drifts& GetDrift() const
+    {
+        return m_Drift;
+    }
+
+    // Largest drifts since Begin().
+    const Drifts& GetMaxDrift() const
+    {
+        return m_MaxDrift;
+    }
+
+private:
+
+    static Drifts Values(const DynamicEntity& dynEntity)
+    {
+        Drifts values{};
+        if constexpr (NumQuantities > 0)
+        {
+            const auto quantities = dynEntity.ConservedQuantities(dynEntity.m_State);
+            for (size_t idx = 0; idx < NumQuantities; ++idx)
+            {
+                values[idx] = ScalarValue(quantities[idx]);
+            }
+        }
+        return values;
+    }
+
+private:
+    Drifts m_Reference{};
+    Drifts m_InverseScale{};                // 1 / |reference|, or 1.
+    Drifts m_Drift{};
+    Drifts m_MaxDrift{};
+    std::array<bool, NumQuantities> m_Exceeded{};
+};
+
+// Largest of deltaTs whose run of SimulationType, eg
+// Simulation<CrudeSpinningPen, Integrators::RK4>, keeps every
+// conserved quantity within maxRelDrift for duration. Runs stop at
+// the first quantity over budget, so rejected step sizes are cheap.
+// Returns zero if none is within budget.
+template <typename SimulationType, typename DynamicEntity>
+double LargestDeltaTWithinBudget(double duration, const DynamicEntity& dynEntity, double maxRelDrift, const std::vector<double>& deltaTs)
+{
+    double largest = 0.0;
+    for (double deltaT : deltaTs)
+    {
+        if (deltaT <= largest)
+        {
+            continue;
+        }
+
+        SimulationType sim(duration, deltaT, false, dynEntity);
+        sim.SetInvariantMonitor(maxRelDrift, SimulationType::EventAction::Terminate);
+        if (sim.Run() && !sim.WasTerminatedByDrift())
+        {
+            largest = deltaT;
+        }
+    }
+    return largest;
+}
+
+} // namespace Invariants
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// OnlineStats
+// Descr: Summary statistics of a stream of states in fixed
+// memory, eg the final states of a Monte Carlo sweep. Mean
+// and covariance are accumulated with Welford's method, and
+// quantiles with a KLL sketch. Accumulators are mergeable,
+// so every thread can keep its own and combine them at the
+// end.
+//////////////////////////////////////////////////////////
+
+// Mergeable quantile sketch (Karnin, Lang, Liberty 2016). Values
+// are kept in levels of compactors, a value at level h standing in
+// for 2^h inputs. A full level is sorted and every other value,
+// from a random offset, promoted to the next. Rank error is about
+// 1.7 / k of the count, memory is about 3k values.
+class QuantileSketch
+{
+public:
+
+    explicit QuantileSketch(size_t k = 200, uint64_t seed = 1)
+    : m_K(std::max<size_t>(k, 8))
+    , m_RandomState(seed | 1)
+    , m_Levels(1)
+    {
+        m_TotalCapacity = TotalCapacity();
+    }
+
+    void Add(double value)
+    {
+        m_Levels[0].push_back(value);
+        ++m_Count;
+        if (++m_NumRetained > m_TotalCapacity)
+        {
+            Compress();
+        }
+    }
+
+    void Merge(const QuantileSketch& other)
+    {
+        if (m_Levels.size() < other.m_Levels.size())
+        {
+            m_Levels.resize(other.m_Levels.size());
+            m_TotalCapacity = TotalCapacity();
+        }
+
+        for (size_t level = 0; level < other.m_Levels.size(); ++level)
+        {
+            m_Levels[level].insert(m_Levels[level].end(), other.m_Levels[level].begin(), other.m_Levels[level].end());
+        }
+
+        m_Count += other.m_Count;
+        m_NumRetained += other.m_NumRetained;
+        Compress();
+    }
+
+    uint64_t Count() const
+    {
+        return m_Count;
+    }
+
+    size_t NumRetained() const
+    {
+        return m_NumRetained;
+    }
+
+    // Approximate q quantile, q in [0, 1]. NaN if empty.
+    double Quantile(double q) const
+    {
+        if (m_Count == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        std::vector<std::pair<double, uint64_t>> weighted;
+        weighted.reserve(m_NumRetained);
+        for (size_t level = 0; level < m_Levels.size(); ++level)
+        {
+            for (double value : m_Levels[level])
+            {
+                weighted.emplace_back(value, uint64_t(1) << level);
+            }
+        }
+        std::sort(weighted.begin(), weighted.end());
+
+        uint64_t totalWeight = 0;
+        for (const std::pair<double, uint64_t>& item : weighted)
+        {
+            totalWeight += item.second;
+        }
+
+        const double targetRank = std::clamp(q, 0.0, 1.0) * totalWeight;
+        uint64_t rank = 0;
+        for (const std::pair<double, uint64_t>& item : weighted)
+        {
+            rank += item.second;
+            if (rank >= targetRank)
+            {
+                return item.first;
+            }
+        }
+
+        return weighted.back().first;
+    }
+
+private:
+
+    // Lower levels hold fewer values, shrinking by 2/3 per level.
+    size_t LevelCapacity(size_t level) const
+    {
+        const size_t depth = m_Levels.size() - 1 - level;
+        return std::max<size_t>(2, static_cast<size_t>(std::ceil(m_K * std::pow(2.0 / 3.0, depth))));
+    }
+
+    size_t TotalCapacity() const
+    {
+        size_t capacity = 0;
+        for (size_t level = 0; level < m_Levels.size(); ++level)
+        {
+            capacity += LevelCapacity(level);
+        }
+        return capacity;
+    }
+
+    // xorshift64, only picks compaction offsets.
+    bool RandomBit()
+    {
+        m_RandomState ^= m_RandomState << 13;
+        m_RandomState ^= m_RandomState >> 7;
+        m_RandomState ^= m_RandomState << 17;
+        return (m_RandomState >> 32) & 1;
+    }
+
+    void Compress()
+    {
+        while (m_NumRetained > m_TotalCapacity)
+        {
+            size_t level = 0;
+            while (m_Levels[level].size() < LevelCapacity(level))
+            {
+                ++level;
+            }
+
+            if (level + 1 == m_Levels.size())
+            {
+                m_Levels.emplace_back();
+                m_TotalCapacity = TotalCapacity();
+            }
+
+            std::vector<double>& values = m_Levels[level];
+            std::sort(values.begin(), values.end());
+
+            // An odd value out stays behind at this level.
+            const size_t numPaired = values.size() & ~size_t(1);
+            for (size_t idx = RandomBit() ? 1 : 0; idx < numPaired; idx += 2)
+            {
+                m_Levels[level + 1].push_back(values[idx]);
+            }
+            values.erase(values.begin(), values.begin() + numPaired);
+            m_NumRetained -= numPaired / 2;
+        }
+    }
+
+private:
+    size_t m_K;
+    uint64_t m_RandomState;
+    uint64_t m_Count = 0;
+    std::vector<std::vector<double>> m_Levels;
+    size_t m_NumRetained = 0;
+    size_t m_TotalCapacity = 0;     // Sum of LevelCapacity, cached.
+};
+
+// Count, mean, covariance, min, max and quantiles of every field of
+// State, a std::array of doubles, eg DynamicEntityType::State.
+template <typename State>
+class StateStatistics
+{
+public:
+
+    static constexpr size_t NumFields = std::tuple_size<State>::value;
+
+    explicit StateStatistics(size_t sketchK = 200)
+    {
+        m_Min.fill(std::numeric_limits<double>::infinity());
+        m_Max.fill(-std::numeric_limits<double>::infinity());
+        m_Mean.fill(0.0);
+        m_CoMoments.fill(0.0);
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_Sketches.emplace_back(sketchK, field + 1);
+        }
+    }
+
+    void Add(const State& state)
+    {
+        ++m_Count;
+
+        State delta;
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            delta[i] = state[i] - m_Mean[i];
+            m_Mean[i] += delta[i] / m_Count;
+        }
+
+        // Welford's update, co-moments use the old and new means.
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            for (size_t j = 0; j < NumFields; ++j)
+            {
+                m_CoMoments[i * NumFields + j] += delta[i] * (state[j] - m_Mean[j]);
+            }
+        }
+
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            m_Min[i] = std::min(m_Min[i], state[i]);
+            m_Max[i] = std::max(m_Max[i], state[i]);
+            m_Sketches[i].Add(state[i]);
+        }
+    }
+
+    // Combines other's samples into this, as if added here
+    // (Chan, Golub, LeVeque 1979).
+    void Merge(const StateStatistics& other)
+    {
+        if (other.m_Count == 0)
+        {
+            return;
+        }
+
+        const double count = static_cast<double>(m_Count + other.m_Count);
+        const double weight = static_cast<double>(m_Count) * other.m_Count / count;
+
+        State delta;
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            delta[i] = other.m_Mean[i] - m_Mean[i];
+        }
+
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            for (size_t j = 0; j < NumFields; ++j)
+            {
+                m_CoMoments[i * NumFields + j] += other.m_CoMoments[i * NumFields + j] + delta[i] * delta[j] * weight;
+            }
+        }
+
+        for (size_t i = 0; i < NumFields; ++i)
+        {
+            m_Mean[i] += delta[i] * other.m_Count / count;
+            m_Min[i] = std::min(m_Min[i], other.m_Min[i]);
+            m_Max[i] = std::max(m_Max[i], other.m_Max[i]);
+            m_Sketches[i].Merge(other.m_Sketches[i]);
+        }
+
+        m_Count += other.m_Count;
+    }
+
+    uint64_t Count() const
+    {
+        return m_Count;
+    }
+
+    const State& GetMean() const
+    {
+        return m_Mean;
+    }
+
+    // Sample covariance, n - 1 in the denominator.
+    double GetCovariance(size_t i, size_t j) const
+    {
+        return m_Count > 1 ? m_CoMoments[i * NumFields + j] / (m_Count - 1) : 0.0;
+    }
+
+    double GetVariance(size_t field) const
+    {
+        return GetCovariance(field, field);
+    }
+
+    const State& GetMin() const
+    {
+        return m_Min;
+    }
+
+    const State& GetMax() const
+    {
+        return m_Max;
+    }
+
+    // Approximate q quantile of one field. Exact at 0 and 1.
+    double GetQuantile(size_t field, double q) const
+    {
+        if (q <= 0.0)
+        {
+            return m_Min[field];
+        }
+        if (q >= 1.0)
+        {
+            return m_Max[field];
+        }
+        return m_Sketches[field].Quantile(q);
+    }
+
+private:
+    uint64_t m_Count = 0;
+    State m_Mean;
+    std::array<double, NumFields * NumFields> m_CoMoments;  // Sums of products of deviations.
+    State m_Min;
+    State m_Max;
+    std::vector<QuantileSketch> m_Sketches;                 // One per field.
+};
@@ -0,0 +1,147 @@
+#include "./DynamicEntities.h"
+#include "./EnsembleRunner.h"
+#include "./OnlineStats.h"
+#include "./TestUtils.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// OnlineStats Unit Tests
+//////////////////////////////////////////////////////////
+
+int main(void)
+{
+    using Pair = std::array<double, 2>;
+
+    std::mt19937 rng(11);
+    std::normal_distribution<double> normal(3.0, 2.0);
+    std::vector<Pair> samples;
+    for (int i = 0; i < 10000; ++i)
+    {
+        const double a = normal(rng);
+        samples.push_back(Pair{a, 0.5 * a + normal(rng)});
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test Welford mean and covariance against two passes.
+    {
+        StateStatistics<Pair> stats;
+        Pair mean{0.0, 0.0};
+        for (const Pair& sample : samples)
+        {
+            stats.Add(sample);
+            mean[0] += sample[0] / samples.size();
+            mean[1] += sample[1] / samples.size();
+        }
+
+        std::array<double, 3> coMoments{0.0, 0.0, 0.0};
+        for (const Pair& sample : samples)
+        {
+            coMoments[0] += (sample[0] - mean[0]) * (sample[0] - mean[0]);
+            coMoments[1] += (sample[0] - mean[0]) * (sample[1] - mean[1]);
+            coMoments[2] += (sample[1] - mean[1]) * (sample[1] - mean[1]);
+        }
+
+        const double n = samples.size() - 1.0;
+        const bool welfordEq = stats.Count() == samples.size() &&
+            TestUtils::FloatEquals(stats.GetMean(), mean, 1e-10) &&
+            std::abs(stats.GetVariance(0) - coMoments[0] / n) < 1e-9 &&
+            std::abs(stats.GetCovariance(0, 1) - coMoments[1] / n) < 1e-9 &&
+            std::abs(stats.GetCovariance(1, 0) - coMoments[1] / n) < 1e-9 &&
+            std::abs(stats.GetVariance(1) - coMoments[2] / n) < 1e-9;
+        TestUtils::ReportResults(welfordEq, "OnlineStats Test: Welford Mean and Covariance");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test merged partial statistics match one pass.
+    {
+        StateStatistics<Pair> whole;
+        std::vector<StateStatistics<Pair>> parts(7);
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            whole.Add(samples[i]);
+            parts[(i * i) % parts.size()].Add(samples[i]);
+        }
+
+        StateStatistics<Pair> merged;
+        for (const StateStatistics<Pair>& part : parts)
+        {
+            merged.Merge(part);
+        }
+
+        const bool mergeEq = merged.Count() == whole.Count() &&
+            TestUtils::FloatEquals(merged.GetMean(), whole.GetMean(), 1e-12) &&
+            std::abs(merged.GetCovariance(0, 1) - whole.GetCovariance(0, 1)) < 1e-9 &&
+            std::abs(merged.GetVariance(1) - whole.GetVariance(1)) < 1e-9 &&
+            merged.GetMin() == whole.GetMin() &&
+            merged.GetMax() == whole.GetMax();
+        TestUtils::ReportResults(mergeEq, "OnlineStats Test: Merge Matches One Pass");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test sketch quantiles stay within rank error in bounded
+    // memory, single and merged.
+    {
+        const size_t count = 1000000;
+        QuantileSketch single;
+        std::vector<QuantileSketch> parts(8, QuantileSketch());
+        for (size_t i = 0; i < count; ++i)
+        {
+            // A permutation of 0 .. count-1, so rank of v is v.
+            const double value = static_cast<double>((i * 7919) % count);
+            single.Add(value);
+            parts[i % parts.size()].Add(value);
+        }
+
+        QuantileSketch merged;
+        for (const QuantileSketch& part : parts)
+        {
+            merged.Merge(part);
+        }
+
+        bool sketchValid = single.Count() == count && merged.Count() == count &&
+            single.NumRetained() < 1000 && merged.NumRetained() < 1000;
+        for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99})
+        {
+            sketchValid = sketchValid &&
+                std::abs(single.Quantile(q) / count - q) < 0.02 &&
+                std::abs(merged.Quantile(q) / count - q) < 0.02;
+        }
+        TestUtils::ReportResults(sketchValid, "OnlineStats Test: Quantile Sketch");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test ensemble accumulation matches adding every output.
+    {
+        std::uniform_real_distribution<double> spread(-1.0, 1.0);
+        std::vector<EnsembleRunner<CrudeSpinningPen>::Scenario> scenarios;
+        for (int i = 0; i < 500; ++i)
+        {
+            const CrudeSpinningPen::State state{
+                0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0 + spread(rng), 10.0, 10.0, 10.0 + spread(rng), 0.0, 10.0};
+            scenarios.push_back({1.0, .01, CrudeSpinningPen(state, {10.0, 10.0, 1.0})});
+        }
+
+        EnsembleRunner<CrudeSpinningPen> runner(4, 16);
+        StateStatistics<CrudeSpinningPen::State> accumulated;
+        const uint64_t numInvalid = runner.Accumulate(scenarios.begin(), scenarios.end(), accumulated);
+
+        StateStatistics<CrudeSpinningPen::State> expected;
+        for (const auto& result : runner.Run(scenarios))
+        {
+            expected.Add(result.m_Output);
+        }
+
+        const bool accumulateEq = numInvalid == 0 &&
+            accumulated.Count() == 500 &&
+            TestUtils::FloatEquals(accumulated.GetMean(), expected.GetMean(), 1e-9) &&
+            std::abs(accumulated.GetVariance(6) - expected.GetVariance(6)) < 1e-9 &&
+            accumulated.GetMin() == expected.GetMin() &&
+            accumulated.GetMax() == expected.GetMax();
+        TestUtils::ReportResults(accumulateEq, "OnlineStats Test: Ensemble Accumulate");
+    }
+
+    return 0;
+}
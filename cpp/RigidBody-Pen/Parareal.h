@@ -0,0 +1,221 @@
+#pragma once
+
+#include "./Integrators.h"
+#include "./ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Parareal
+// Descr: Parallel in time integration of one long
+// trajectory (Lions, Maday, Turinici 2001). The run is cut
+// into time slices. A cheap coarse integrator predicts the
+// state at every slice boundary, the accurate fine
+// integrator refines all slices at once across cores, and
+// the coarse sweep corrects the boundaries, until they stop
+// changing. After k iterations the first k slices match the
+// serial fine solution, so it always converges, the question
+// is how much sooner.
+//////////////////////////////////////////////////////////
+
+template <typename DynamicEntityType,
+    template <typename> class FineIntegrator = Integrators::RK4,
+    template <typename> class CoarseIntegrator = Integrators::Euler>
+class PararealSolver
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+
+    struct Settings
+    {
+        size_t m_NumSlices = 0;             // Zero for one per thread.
+        double m_FineDeltaT = 1.0e-3;       // in seconds.
+        double m_CoarseDeltaT = 1.0e-1;     // in seconds, at most a slice.
+        double m_Tolerance = 1.0e-9;        // On boundary corrections, relative to max(1, |state|).
+        size_t m_MaxIterations = 0;         // Zero for m_NumSlices, which is exact.
+        bool m_MeasureSerial = false;       // Also time the serial fine run, for the speedup.
+    };
+
+    struct Stats
+    {
+        size_t m_NumSlices = 0;
+        size_t m_Iterations = 0;
+        bool m_Converged = false;
+        double m_MaxCorrection = 0.0;       // Of the last iteration.
+        size_t m_FineSteps = 0;             // Summed over slices and iterations.
+        double m_Seconds = 0.0;
+        double m_SerialSeconds = 0.0;       // If measured.
+        double m_Speedup = 0.0;             // m_SerialSeconds / m_Seconds, if measured.
+        double m_MaxSerialDeviation = 0.0;  // From the serial final state, if measured.
+    };
+
+    // numThreads of zero uses every hardware thread.
+    explicit PararealSolver(size_t numThreads = 0)
+    : m_Pool(numThreads == 0 ? std::thread::hardware_concurrency() : numThreads)
+    {}
+
+    // Integrates dynEntity over duration, which is rounded to a whole
+    // number of fine steps. Returns false if the settings are not
+    // self consistent.
+    bool Run(double duration, const DynamicEntityType& dynEntity, const Settings& settings)
+    {
+        const size_t numSlices = settings.m_NumSlices == 0 ? m_Pool.NumThreads() : settings.m_NumSlices;
+        if (duration <= 0.0 || settings.m_FineDeltaT <= 0.0 || settings.m_CoarseDeltaT <= 0.0 ||
+            settings.m_FineDeltaT >= duration || numSlices == 0)
+        {
+            std::cout << "Parareal Failed! Preconditions not met. \n";
+            return false;
+        }
+
+        m_Stats = Stats{};
+        m_Stats.m_NumSlices = numSlices;
+        const size_t maxIterations = settings.m_MaxIterations == 0 ? numSlices : std::min(settings.m_MaxIterations, numSlices);
+
+        // Fine steps are dealt to the slices as evenly as possible, so the
+        // slices together take exactly the serial run's steps.
+        const size_t totalFineSteps = static_cast<size_t>(std::llround(duration / settings.m_FineDeltaT));
+        std::vector<size_t> sliceSteps(numSlices);
+        for (size_t slice = 0; slice < numSlices; ++slice)
+        {
+            sliceSteps[slice] = (slice + 1) * totalFineSteps / numSlices - slice * totalFineSteps / numSlices;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // Initial prediction, one serial coarse sweep.
+        m_Boundaries.assign(numSlices + 1, dynEntity);
+        std::vector<State> coarse(numSlices);
+        std::vector<State> fine(numSlices);
+        for (size_t slice = 0; slice < numSlices; ++slice)
+        {
+            coarse[slice] = Coarse(m_Boundaries[slice], sliceSteps[slice] * settings.m_FineDeltaT, settings.m_CoarseDeltaT);
+            m_Boundaries[slice + 1].m_State = coarse[slice];
+        }
+
+        for (size_t iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            // Slices before iteration are converged, their start is exact.
+            m_Pool.ParallelFor(numSlices - iteration, 1, [&](size_t idx, size_t)
+            {
+                const size_t slice = iteration + idx;
+                DynamicEntityType sliceEntity = m_Boundaries[slice];
+                Fine(sliceEntity, sliceSteps[slice], settings.m_FineDeltaT);
+                fine[slice] = sliceEntity.m_State;
+            });
+            for (size_t slice = iteration; slice < numSlices; ++slice)
+            {
+                m_Stats.m_FineSteps += sliceSteps[slice];
+            }
+
+            // Serial correction, U(n+1) = F(U(n)) + G(U(n)) - G_old(U(n)).
+            // The coarse difference first, so that it is exactly zero
+            // where U(n) has not moved.
+            double maxCorrection = 0.0;
+            for (size_t slice = iteration; slice < numSlices; ++slice)
+            {
+                const State predicted = Coarse(m_Boundaries[slice], sliceSteps[slice] * settings.m_FineDeltaT, settings.m_CoarseDeltaT);
+
+                DynamicEntityType& next = m_Boundaries[slice + 1];
+                const State previous = next.m_State;
+                next.m_State = fine[slice] + (predicted - coarse[slice]);
+                Integrators::ProjectState(next);
+                coarse[slice] = predicted;
+
+                for (size_t field = 0; field < previous.size(); ++field)
+                {
+                    const double correction = std::abs(ScalarValue(next.m_State[field] - previous[field])) / std::max(1.0, std::abs(ScalarValue(previous[field])));
+                    maxCorrection = std::max(maxCorrection, correction);
+                }
+            }
+
+            m_Stats.m_Iterations = iteration + 1;
+            m_Stats.m_MaxCorrection = maxCorrection;
+            if (maxCorrection <= settings.m_Tolerance)
+            {
+                m_Stats.m_Converged = true;
+                break;
+            }
+        }
+
+        // All slices are exact once every slice has been refined.
+        m_Stats.m_Converged = m_Stats.m_Converged || m_Stats.m_Iterations == numSlices;
+        m_Stats.m_Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (settings.m_MeasureSerial)
+        {
+            const auto serialStart = std::chrono::steady_clock::now();
+            DynamicEntityType serial = dynEntity;
+            Fine(serial, totalFineSteps, settings.m_FineDeltaT);
+            m_Stats.m_SerialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - serialStart).count();
+            m_Stats.m_Speedup = m_Stats.m_SerialSeconds / m_Stats.m_Seconds;
+
+            for (size_t field = 0; field < serial.m_State.size(); ++field)
+            {
+                m_Stats.m_MaxSerialDeviation = std::max(m_Stats.m_MaxSerialDeviation,
+                    std::abs(ScalarValue(serial.m_State[field] - GetOutput()[field])));
+            }
+        }
+
+        return true;
+    }
+
+    State GetOutput() const
+    {
+        return m_Boundaries.back().m_State;
+    }
+
+    // States at the slice boundaries, from the initial state to the
+    // output.
+    const std::vector<DynamicEntityType>& GetBoundaries() const
+    {
+        return m_Boundaries;
+    }
+
+    const Stats& GetStats() const
+    {
+        return m_Stats;
+    }
+
+    size_t NumThreads() const
+    {
+        return m_Pool.NumThreads();
+    }
+
+private:
+
+    static void Fine(DynamicEntityType& inOutDynEntity, size_t numSteps, double deltaT)
+    {
+        FineIntegrator<DynamicEntityType> integrator;
+        for (size_t step = 0; step < numSteps; ++step)
+        {
+            integrator.Step(inOutDynEntity, deltaT);
+        }
+    }
+
+    // Whole coarse steps of at most coarseDeltaT across the slice.
+    static State Coarse(const DynamicEntityType& start, double sliceLength, double coarseDeltaT)
+    {
+        const size_t numSteps = std::max<size_t>(1, static_cast<size_t>(std::ceil(sliceLength / coarseDeltaT - 1.0e-9)));
+        const double deltaT = sliceLength / numSteps;
+
+        DynamicEntityType dynEntity = start;
+        CoarseIntegrator<DynamicEntityType> integrator;
+        for (size_t step = 0; step < numSteps; ++step)
+        {
+            integrator.Step(dynEntity, deltaT);
+        }
+        return dynEntity.m_State;
+    }
+
+private:
+    WorkStealingPool m_Pool;
+    std::vector<DynamicEntityType> m_Boundaries;
+    Stats m_Stats;
+};
@@ -0,0 +1,122 @@
+#include "./DynamicEntities.h"
+#include "./Parareal.h"
+#include "./TestUtils.h"
+
+#include <cmath>
+#include <iostream>
+
+//////////////////////////////////////////////////////////
+// Parareal Unit Tests
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+template <typename DynamicEntityType>
+typename DynamicEntityType::State SerialRK4(DynamicEntityType dynEntity, size_t numSteps, double deltaT)
+{
+    Integrators::RK4<DynamicEntityType> integrator;
+    for (size_t step = 0; step < numSteps; ++step)
+    {
+        integrator.Step(dynEntity, deltaT);
+    }
+    return dynEntity.m_State;
+}
+
+template <typename Stats>
+void PrintStats(const char* name, const Stats& stats)
+{
+    std::cout << "Parareal: " << name << ", slices = " << stats.m_NumSlices
+        << ", iterations = " << stats.m_Iterations
+        << ", speedup = " << stats.m_Speedup
+        << ", max deviation = " << stats.m_MaxSerialDeviation << "\n";
+}
+
+} // namespace
+
+int main(void)
+{
+    //////////////////////////////////////////////////////////
+    // Test spring over many periods converges to the serial
+    // fine solution before the last iteration.
+    {
+        const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+
+        PararealSolver<SimpleSpringMotion> solver(4);
+        PararealSolver<SimpleSpringMotion>::Settings settings;
+        settings.m_NumSlices = 16;
+        settings.m_FineDeltaT = 1.0e-3;
+        settings.m_CoarseDeltaT = 2.0e-2;
+        settings.m_Tolerance = 1.0e-10;
+        settings.m_MeasureSerial = true;
+
+        const bool isValid = solver.Run(16.0, shm, settings);
+        const auto& stats = solver.GetStats();
+        PrintStats("spring", stats);
+
+        const bool convergedEq = isValid && stats.m_Converged &&
+            stats.m_Iterations < settings.m_NumSlices &&
+            TestUtils::FloatEquals(solver.GetOutput(), SerialRK4(shm, 16000, 1.0e-3), 1.0e-8) &&
+            stats.m_MaxSerialDeviation < 1.0e-8 &&
+            solver.GetBoundaries().size() == settings.m_NumSlices + 1;
+        TestUtils::ReportResults(convergedEq, "Parareal Test: Spring Converges To Serial");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test every slice refined reproduces the serial run bit
+    // exactly, as the theory says.
+    {
+        const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+
+        PararealSolver<SimpleSpringMotion> solver(4);
+        PararealSolver<SimpleSpringMotion>::Settings settings;
+        settings.m_NumSlices = 5;
+        settings.m_FineDeltaT = 1.0e-2;
+        settings.m_CoarseDeltaT = 0.5;
+        settings.m_Tolerance = 0.0;
+
+        const bool isValid = solver.Run(5.0, shm, settings);
+        const bool exactEq = isValid && solver.GetStats().m_Iterations == 5 &&
+            solver.GetOutput() == SerialRK4(shm, 500, 1.0e-2);
+        TestUtils::ReportResults(exactEq, "Parareal Test: Exact After All Slices");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a long spinning pen flight, RK4 fine. Euler is too
+    // crude a coarse step for the spin, MidPoint converges in
+    // far fewer iterations.
+    {
+        using Solver = PararealSolver<CrudeSpinningPen, Integrators::RK4, Integrators::MidPoint>;
+        const CrudeSpinningPen pen{CrudeSpinningPen::State{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0, 30.0, 2.0, 0.5, 10.0}, {10.0, 8.0, 1.0}};
+
+        Solver solver(4);
+        Solver::Settings settings;
+        settings.m_NumSlices = 16;
+        settings.m_FineDeltaT = 1.0e-3;
+        settings.m_CoarseDeltaT = 1.0e-2;
+        settings.m_Tolerance = 1.0e-10;
+        settings.m_MeasureSerial = true;
+
+        const bool isValid = solver.Run(6.0, pen, settings);
+        const auto& stats = solver.GetStats();
+        PrintStats("pen", stats);
+
+        const bool penEq = isValid && stats.m_Converged &&
+            stats.m_Iterations < settings.m_NumSlices / 2 &&
+            stats.m_MaxSerialDeviation < 1.0e-7;
+        TestUtils::ReportResults(penEq, "Parareal Test: Pen Converges To Serial");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test inconsistent settings are rejected.
+    {
+        PararealSolver<SimpleSpringMotion> solver(1);
+        PararealSolver<SimpleSpringMotion>::Settings settings;
+        settings.m_FineDeltaT = 2.0;
+        const bool rejected = !solver.Run(1.0, SimpleSpringMotion{SimpleSpringMotion::State{1.0, 0.0}, 4.0}, settings);
+        TestUtils::ReportResults(rejected, "Parareal Test: Preconditions");
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+
+//////////////////////////////////////////////////////////
+// RealTime
+// Descr: Paces a simulation against the monotonic clock, eg
+// to drive hardware in the loop. Every step has an absolute
+// deadline, start of the run plus simulation time over the
+// time scale. The pacer sleeps until just before it and
+// spins the rest of the way, then records how late it woke
+// up. Steps which finish after their deadline are misses,
+// handled by the catch up policy.
+//////////////////////////////////////////////////////////
+
+namespace RealTime
+{
+
+enum class CatchUpPolicy
+{
+    Burst,      // Keep the schedule, run late steps back to back
+                // until caught up. Every step is output.
+    Skip,       // As Burst, but late steps are not output, so
+                // outputs are only ever on time.
+    SlowDown    // Move the schedule back by the overrun. Steps stay
+                // evenly spaced, simulation time falls behind.
+};
+
+struct Config
+{
+    double m_TimeScale = 1.0;               // Simulation seconds per wall clock second.
+    double m_SpinSeconds = 200.0e-6;        // Spin, rather than sleep, this close to a deadline.
+    CatchUpPolicy m_CatchUp = CatchUpPolicy::Burst;
+};
+
+// Counts of durations in power of two buckets of microseconds,
+// [0, 1), [1, 2), [2, 4), ... with the last bucket open ended.
+class Histogram
+{
+public:
+
+    static constexpr size_t NumBuckets = 24;
+
+    void Add(double seconds)
+    {
+        const double micros = 1.0e6 * seconds;
+        size_t bucket = 0;
+        while (bucket + 1 < NumBuckets && micros >= BucketUpperMicros(bucket))
+        {
+            ++bucket;
+        }
+
+        ++m_Counts[bucket];
+        ++m_NumSamples;
+        m_MaxSeconds = std::max(m_MaxSeconds, seconds);
+    }
+
+    // Exclusive upper bound of bucket, in microseconds.
+    static double BucketUpperMicros(size_t bucket)
+    {
+        return static_cast<double>(uint64_t(1) << bucket);
+    }
+
+    uint64_t GetCount(size_t bucket) const
+    {
+        return m_Counts[bucket];
+    }
+
+    uint64_t NumSamples() const
+    {
+        return m_NumSamples;
+    }
+
+    double GetMaxSeconds() const
+    {
+        return m_MaxSeconds;
+    }
+
+private:
+    std::array<uint64_t, NumBuckets> m_Counts{};
+    uint64_t m_NumSamples = 0;
+    double m_MaxSeconds = 0.0;
+};
+
+struct Stats
+{
+    uint64_t m_Steps = 0;
+    uint64_t m_DeadlineMisses = 0;
+    uint64_t m_SkippedOutputs = 0;          // Skip only.
+    double m_Lag = 0.0;                     // in wall clock seconds, SlowDown only.
+    Histogram m_Jitter;                     // Wake up minus deadline, steps on time.
+    Histogram m_Overrun;                    // Finish minus deadline, missed steps.
+};
+
+class Pacer
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    void SetConfig(const Config& config)
+    {
+        m_Config = config;
+    }
+
+    const Config& GetConfig() const
+    {
+        return m_Config;
+    }
+
+    // Starts the schedule now, at the current simulation time.
+    void Begin()
+    {
+        m_Stats = Stats{};
+        m_Start = Clock::now();
+        m_SimTime = 0.0;
+    }
+
+    // Waits for the deadline of a step of stepSize simulation seconds.
+    // Returns false if the step's output should be skipped.
+    bool WaitForStep(double stepSize)
+    {
+        ++m_Stats.m_Steps;
+
+        // From the start of the run, so rounding to clock ticks does
+        // not add up over the steps.
+        m_SimTime += stepSize;
+        const Clock::time_point deadline = m_Start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(m_SimTime / m_Config.m_TimeScale));
+
+        const Clock::time_point finished = Clock::now();
+        if (finished > deadline)
+        {
+            const std::chrono::duration<double> overrun = finished - deadline;
+            ++m_Stats.m_DeadlineMisses;
+            m_Stats.m_Overrun.Add(overrun.count());
+
+            switch (m_Config.m_CatchUp)
+            {
+                case CatchUpPolicy::Burst:
+                    return true;
+
+                case CatchUpPolicy::Skip:
+                    ++m_Stats.m_SkippedOutputs;
+                    return false;
+
+                case CatchUpPolicy::SlowDown:
+                    m_Start += finished - deadline;
+                    m_Stats.m_Lag += overrun.count();
+                    return true;
+            }
+        }
+
+        // Sleep is only accurate to the scheduler's tick, so spin out
+        // the last stretch.
+        const auto spin = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(m_Config.m_SpinSeconds));
+        std::this_thread::sleep_until(deadline - spin);
+
+        Clock::time_point woke = Clock::now();
+        while (woke < deadline)
+        {
+            woke = Clock::now();
+        }
+
+        const std::chrono::duration<double> jitter = woke - deadline;
+        m_Stats.m_Jitter.Add(jitter.count());
+        return true;
+    }
+
+    const Stats& GetStats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    Config m_Config;
+    Stats m_Stats;
+    Clock::time_point m_Start;              // Pushed later by SlowDown overruns.
+    double m_SimTime = 0.0;                 // in seconds, since Begin().
+};
+
+} // namespace RealTime
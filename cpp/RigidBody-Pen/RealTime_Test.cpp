@@ -0,0 +1,127 @@
+#include "./DynamicEntities.h"
+#include "./RealTime.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <chrono>
+#include <thread>
+
+//////////////////////////////////////////////////////////
+// RealTime Unit Tests
+//////////////////////////////////////////////////////////
+
+// Runs sim and returns the wall clock time it took, in seconds.
+template <typename SimulationType>
+static double TimedRun(SimulationType& sim)
+{
+    const auto start = std::chrono::steady_clock::now();
+    sim.Run();
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    return wall.count();
+}
+
+int main(void)
+{
+    const SimpleSpringMotion spring(SimpleSpringMotion::State{1.0, 0.0}, 4.0);
+
+    //////////////////////////////////////////////////////////
+    // Test histogram buckets.
+    {
+        RealTime::Histogram histogram;
+        histogram.Add(0.5e-6);
+        histogram.Add(1.0e-6);
+        histogram.Add(3.0e-6);
+        histogram.Add(3.9e-6);
+        histogram.Add(100.0);
+
+        const bool histogramEq = histogram.NumSamples() == 5 &&
+            histogram.GetCount(0) == 1 &&
+            histogram.GetCount(1) == 1 &&
+            histogram.GetCount(2) == 2 &&
+            histogram.GetCount(RealTime::Histogram::NumBuckets - 1) == 1 &&
+            histogram.GetMaxSeconds() == 100.0;
+        TestUtils::ReportResults(histogramEq, "RealTime Test: Histogram Buckets");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test steps are paced to the wall clock, and to a scaled
+    // wall clock, without changing the trajectory.
+    {
+        Simulation<SimpleSpringMotion> fastSim(0.2 - .005, .01, false, spring);
+        fastSim.Run();
+
+        Simulation<SimpleSpringMotion> realSim(0.2 - .005, .01, false, spring);
+        realSim.SetRealTime(RealTime::Config{});
+        const double realWall = TimedRun(realSim);
+
+        Simulation<SimpleSpringMotion> scaledSim(2.0 - .05, .1, false, spring);
+        RealTime::Config scaledConfig;
+        scaledConfig.m_TimeScale = 10.0;
+        scaledSim.SetRealTime(scaledConfig);
+        const double scaledWall = TimedRun(scaledSim);
+
+        const RealTime::Stats& stats = realSim.GetRealTimeStats();
+        const bool pacedValid =
+            realSim.GetOutput() == fastSim.GetOutput() &&
+            realWall >= 0.2 && realWall < 0.3 &&
+            scaledWall >= 0.2 && scaledWall < 0.3 &&
+            stats.m_Steps == 20 &&
+            stats.m_Jitter.NumSamples() + stats.m_Overrun.NumSamples() == 20 &&
+            stats.m_Overrun.NumSamples() == stats.m_DeadlineMisses;
+        TestUtils::ReportResults(pacedValid, "RealTime Test: Lockstep Pacing");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test catch up policies on a single slow output. Step 5 of
+    // 20 overruns by 50ms, 5 steps' worth.
+    {
+        auto runWithPolicy = [&](RealTime::CatchUpPolicy policy, size_t& outNumOutputs, double& outWall)
+        {
+            Simulation<SimpleSpringMotion> sim(0.2 - .005, .01, false, spring);
+            RealTime::Config config;
+            config.m_CatchUp = policy;
+            sim.SetRealTime(config);
+
+            outNumOutputs = 0;
+            sim.SetOutputSink([&](double, const SimpleSpringMotion::State&)
+            {
+                if (++outNumOutputs == 6)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                }
+            });
+
+            outWall = TimedRun(sim);
+            return sim.GetRealTimeStats();
+        };
+
+        size_t burstOutputs = 0;
+        double burstWall = 0.0;
+        const RealTime::Stats burst = runWithPolicy(RealTime::CatchUpPolicy::Burst, burstOutputs, burstWall);
+        const bool burstValid = burst.m_DeadlineMisses >= 4 &&
+            burst.m_SkippedOutputs == 0 &&
+            burstOutputs == 21 &&
+            burstWall < 0.25;
+        TestUtils::ReportResults(burstValid, "RealTime Test: Burst Catch Up");
+
+        size_t skipOutputs = 0;
+        double skipWall = 0.0;
+        const RealTime::Stats skip = runWithPolicy(RealTime::CatchUpPolicy::Skip, skipOutputs, skipWall);
+        const bool skipValid = skip.m_DeadlineMisses >= 4 &&
+            skip.m_SkippedOutputs == skip.m_DeadlineMisses &&
+            skipOutputs == 21 - skip.m_SkippedOutputs &&
+            skipWall < 0.25;
+        TestUtils::ReportResults(skipValid, "RealTime Test: Skip Catch Up");
+
+        size_t slowOutputs = 0;
+        double slowWall = 0.0;
+        const RealTime::Stats slow = runWithPolicy(RealTime::CatchUpPolicy::SlowDown, slowOutputs, slowWall);
+        const bool slowValid = slow.m_DeadlineMisses >= 1 &&
+            slow.m_Lag >= 0.035 &&
+            slowOutputs == 21 &&
+            slowWall >= 0.235;
+        TestUtils::ReportResults(slowValid, "RealTime Test: SlowDown Catch Up");
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "./Dual.h"
+#include "./Simulation.h"
+
+#include <array>
+#include <stddef.h>
+#include <tuple>
+
+//////////////////////////////////////////////////////////
+// Sensitivity
+// Descr: Derivatives of a simulation's final state with
+// respect to its initial state and the entity's Params, eg
+// the pen's inertia, exact to round off for the chosen
+// integrator and step size. One Run() over Dual scalars
+// replaces the 2 * (inputs) runs of central differences.
+//////////////////////////////////////////////////////////
+
+// DynamicEntityType is a double entity from DynamicEntities.h, or
+// any entity providing Params, GetParams() and Rebind. The same
+// Simulation runs on its Dual rebind, see GetSimulation().
+template <typename DynamicEntityType, template <typename> class Integrator = Integrators::MidPoint>
+class SensitivitySimulation
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+    static constexpr size_t NumFields = std::tuple_size<State>::value;
+
+    // Inputs are the initial state fields followed by the params.
+    static constexpr size_t NumInputs = NumFields + DynamicEntityType::NumParams;
+
+    using Scalar = Dual<NumInputs>;
+    using DualEntityType = typename DynamicEntityType::template Rebind<Scalar>;
+
+    // Row i holds d(output[i]) / d(input).
+    using Sensitivities = std::array<std::array<double, NumInputs>, NumFields>;
+
+    SensitivitySimulation(double duration, double deltaT, bool printStatus, const DynamicEntityType& dynEntity)
+    : m_Simulation(duration, deltaT, printStatus, Seed(dynEntity))
+    {}
+
+    bool Run()
+    {
+        return m_Simulation.Run();
+    }
+
+    // Final state, as Simulation::GetOutput() would give for
+    // DynamicEntityType.
+    State GetOutput() const
+    {
+        const typename DualEntityType::State dualOutput = m_Simulation.GetOutput();
+
+        State output;
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            output[field] = dualOutput[field].m_Value;
+        }
+        return output;
+    }
+
+    Sensitivities GetSensitivities() const
+    {
+        const typename DualEntityType::State dualOutput = m_Simulation.GetOutput();
+
+        Sensitivities sensitivities;
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            sensitivities[field] = dualOutput[field].m_Grad;
+        }
+        return sensitivities;
+    }
+
+    // The underlying simulation, eg to set adaptive stepping or events.
+    Simulation<DualEntityType, Integrator>& GetSimulation()
+    {
+        return m_Simulation;
+    }
+
+    const Simulation<DualEntityType, Integrator>& GetSimulation() const
+    {
+        return m_Simulation;
+    }
+
+private:
+
+    // Every input is its own derivative direction.
+    static DualEntityType Seed(const DynamicEntityType& dynEntity)
+    {
+        typename DualEntityType::State state;
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            state[field] = Scalar::Variable(dynEntity.m_State[field], field);
+        }
+
+        const typename DynamicEntityType::Params params = dynEntity.GetParams();
+        typename DualEntityType::Params dualParams;
+        for (size_t param = 0; param < params.size(); ++param)
+        {
+            dualParams[param] = Scalar::Variable(params[param], NumFields + param);
+        }
+
+        return DualEntityType(state, dualParams);
+    }
+
+    Simulation<DualEntityType, Integrator> m_Simulation;
+};
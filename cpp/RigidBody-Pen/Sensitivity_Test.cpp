@@ -0,0 +1,123 @@
+#include "./DynamicEntities.h"
+#include "./Sensitivity.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <cmath>
+
+//////////////////////////////////////////////////////////
+// Sensitivity Unit Tests
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Final state of a plain double simulation, for finite differences.
+template <typename DynamicEntityType, template <typename> class Integrator>
+typename DynamicEntityType::State RunDouble(const typename DynamicEntityType::State& state,
+    const typename DynamicEntityType::Params& params, double duration, double deltaT)
+{
+    Simulation<DynamicEntityType, Integrator> sim(duration, deltaT, false, DynamicEntityType(state, params));
+    sim.Run();
+    return sim.GetOutput();
+}
+
+// Largest difference between the Dual sensitivities and central
+// differences, relative to the size of the derivative.
+template <typename DynamicEntityType, template <typename> class Integrator>
+double MaxSensitivityError(const DynamicEntityType& dynEntity, double duration, double deltaT)
+{
+    using Sensitivity = SensitivitySimulation<DynamicEntityType, Integrator>;
+    using State = typename DynamicEntityType::State;
+    using Params = typename DynamicEntityType::Params;
+
+    Sensitivity sensitivity(duration, deltaT, false, dynEntity);
+    sensitivity.Run();
+    const typename Sensitivity::Sensitivities exact = sensitivity.GetSensitivities();
+
+    double maxError = 0.0;
+    for (size_t input = 0; input < Sensitivity::NumInputs; ++input)
+    {
+        State statePlus = dynEntity.m_State, stateMinus = dynEntity.m_State;
+        Params paramsPlus = dynEntity.GetParams(), paramsMinus = dynEntity.GetParams();
+        double& plus = input < Sensitivity::NumFields ? statePlus[input] : paramsPlus[input - Sensitivity::NumFields];
+        double& minus = input < Sensitivity::NumFields ? stateMinus[input] : paramsMinus[input - Sensitivity::NumFields];
+
+        const double step = 1.0e-6 * std::max(1.0, std::abs(plus));
+        plus += step;
+        minus -= step;
+
+        const State outPlus = RunDouble<DynamicEntityType, Integrator>(statePlus, paramsPlus, duration, deltaT);
+        const State outMinus = RunDouble<DynamicEntityType, Integrator>(stateMinus, paramsMinus, duration, deltaT);
+        for (size_t field = 0; field < Sensitivity::NumFields; ++field)
+        {
+            const double difference = (outPlus[field] - outMinus[field]) / (2.0 * step);
+            const double error = std::abs(difference - exact[field][input]) / std::max(1.0, std::abs(difference));
+            maxError = std::max(maxError, error);
+        }
+    }
+
+    return maxError;
+}
+
+} // namespace
+
+int main(void)
+{
+    //////////////////////////////////////////////////////////
+    // Test Dual arithmetic against analytic derivatives of
+    // f(x, y) = sin(x) * y + sqrt(x) / y - exp(x * y).
+    {
+        using D = Dual<2>;
+        const double x = 0.7, y = 1.3;
+        const D dx = D::Variable(x, 0), dy = D::Variable(y, 1);
+        const D f = sin(dx) * dy + sqrt(dx) / dy - exp(dx * dy);
+
+        const double value = std::sin(x) * y + std::sqrt(x) / y - std::exp(x * y);
+        const std::array<double, 2> grad = {
+            std::cos(x) * y + 0.5 / (std::sqrt(x) * y) - y * std::exp(x * y),
+            std::sin(x) - std::sqrt(x) / (y * y) - x * std::exp(x * y)};
+
+        const bool dualEq = std::abs(f.m_Value - value) < 1e-15 &&
+            TestUtils::FloatEquals(f.m_Grad, grad, 1e-14);
+        TestUtils::ReportResults(dualEq, "Sensitivity Test: Dual Arithmetic");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test Dual run reproduces the double run, and spring
+    // sensitivities match the analytic ones closely, eg
+    // dx/dx0 = cos(wt) and dx/dv0 = sin(wt)/w.
+    {
+        const SimpleSpringMotion sho{SimpleSpringMotion::State{1.0, 0.5}, 4.0};
+        SensitivitySimulation<SimpleSpringMotion, Integrators::RK4> sensitivity(1.0 - .0005, .001, false, sho);
+        Simulation<SimpleSpringMotion, Integrators::RK4> sim(1.0 - .0005, .001, false, sho);
+        const bool ran = sensitivity.Run() && sim.Run();
+
+        const auto grad = sensitivity.GetSensitivities();
+        const bool springEq = ran &&
+            TestUtils::FloatEquals(sensitivity.GetOutput(), sim.GetOutput(), 1e-14) &&
+            std::abs(grad[0][0] - std::cos(2.0)) < 1e-9 &&
+            std::abs(grad[0][1] - std::sin(2.0) / 2.0) < 1e-9 &&
+            std::abs(grad[1][0] + 2.0 * std::sin(2.0)) < 1e-9 &&
+            std::abs(grad[1][1] - std::cos(2.0)) < 1e-9;
+        TestUtils::ReportResults(springEq, "Sensitivity Test: Spring Matches Analytic");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test pen sensitivities, initial state and inertia,
+    // against central differences of whole runs.
+    {
+        const CrudeSpinningPen pen{CrudeSpinningPen::State{
+            0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 10.0, 10.0, 10.0, 10.0, 1.0, 10.0}, {10.0, 10.0, 1.0}};
+        const double crudeError = MaxSensitivityError<CrudeSpinningPen, Integrators::RK4>(pen, 1.0, .01);
+
+        const auto q = QuaternionSpinningPen::QuaternionFromEulerAngles(0.1, 0.2, 0.0);
+        const QuaternionSpinningPen quatPen{QuaternionSpinningPen::State{
+            0.0, 0.0, 0.0, q[0], q[1], q[2], q[3], 10.0, 10.0, 10.0, 10.0, 1.0, 10.0}, {10.0, 8.0, 1.0}};
+        const double quatError = MaxSensitivityError<QuaternionSpinningPen, Integrators::MidPoint>(quatPen, 1.0, .01);
+
+        TestUtils::ReportResults(crudeError < 1e-5 && quatError < 1e-5, "Sensitivity Test: Pen Matches Finite Differences");
+    }
+
+    return 0;
+}
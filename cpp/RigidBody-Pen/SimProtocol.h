@@ -0,0 +1,321 @@
+#pragma once
+
+#include "./DynamicEntities.h"
+#include "./IntegratorSelection.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// SimProtocol
+// Descr: Binary protocol of the simulation server, see
+// SimServer.h, over a Unix domain socket. A request is a
+// RequestHeader followed by the entity's state and then its
+// params, as doubles. Every request is answered with zero
+// or more Trajectory frames, if asked for, then one Final
+// frame, each a ResponseHeader followed by samples of the
+// time and the state. Frames of different requests on one
+// connection may interleave, match them by m_RequestId.
+// Numbers are in the machine's own byte order, client and
+// server run on the same host.
+//////////////////////////////////////////////////////////
+
+namespace SimProtocol
+{
+
+constexpr uint32_t RequestMagic = 0x51534252;   // "RBSQ"
+constexpr uint32_t ResponseMagic = 0x50534252;  // "RBSP"
+
+enum class EntityKind : uint8_t
+{
+    ConstantVelParticle,
+    SimpleSpringMotion,
+    CrudeSpinningPen,
+    QuaternionSpinningPen,
+    Count
+};
+
+// Request flags.
+constexpr uint8_t FlagTrajectory = 1;   // Stream the state after every step.
+
+enum class Status : uint8_t
+{
+    Ok,
+    BadRequest,         // Malformed, or sizes which do not match the entity.
+    SimulationFailed    // Run() returned false, eg dt not below duration.
+};
+
+enum class FrameKind : uint8_t
+{
+    Trajectory,
+    Final
+};
+
+struct RequestHeader
+{
+    uint32_t m_Magic = RequestMagic;
+    uint32_t m_RequestId = 0;
+    uint8_t m_Entity = 0;               // EntityKind.
+    uint8_t m_Integrator = 0;           // IntegratorKind.
+    uint8_t m_Flags = 0;
+    uint8_t m_Reserved = 0;
+    uint16_t m_NumFields = 0;           // State doubles which follow.
+    uint16_t m_NumParams = 0;           // Param doubles after the state.
+    double m_DeltaT = 0.0;              // in seconds.
+    double m_Duration = 0.0;            // in seconds.
+};
+
+struct ResponseHeader
+{
+    uint32_t m_Magic = ResponseMagic;
+    uint32_t m_RequestId = 0;
+    uint8_t m_Status = 0;               // Status.
+    uint8_t m_Kind = 0;                 // FrameKind.
+    uint16_t m_NumFields = 0;
+    uint32_t m_NumSamples = 0;          // Each 1 + m_NumFields doubles, time first.
+    uint32_t m_BatchSize = 0;           // Requests the server ran together with this one.
+    uint32_t m_Reserved = 0;
+};
+
+static_assert(sizeof(RequestHeader) == 32, "RequestHeader layout");
+static_assert(sizeof(ResponseHeader) == 24, "ResponseHeader layout");
+static_assert(std::is_trivially_copyable<RequestHeader>::value && std::is_trivially_copyable<ResponseHeader>::value,
+    "Headers are sent as raw bytes");
+
+// Largest state or params a request may carry.
+constexpr uint16_t MaxValues = 64;
+
+struct Request
+{
+    RequestHeader m_Header;
+    std::vector<double> m_Values;       // State, then params.
+};
+
+struct Response
+{
+    ResponseHeader m_Header;
+    std::vector<double> m_Samples;
+};
+
+template <typename DynamicEntityType>
+struct EntityKindOf;
+
+template <>
+struct EntityKindOf<ConstantVelParticle> : std::integral_constant<EntityKind, EntityKind::ConstantVelParticle> {};
+
+template <>
+struct EntityKindOf<SimpleSpringMotion> : std::integral_constant<EntityKind, EntityKind::SimpleSpringMotion> {};
+
+template <>
+struct EntityKindOf<CrudeSpinningPen> : std::integral_constant<EntityKind, EntityKind::CrudeSpinningPen> {};
+
+template <>
+struct EntityKindOf<QuaternionSpinningPen> : std::integral_constant<EntityKind, EntityKind::QuaternionSpinningPen> {};
+
+// Calls fn with a null pointer to the entity type of kind, which
+// stands in for a template argument of a generic lambda. Returns
+// false for unknown kinds.
+template <typename Function>
+bool VisitEntityKind(uint8_t kind, Function&& fn)
+{
+    switch (static_cast<EntityKind>(kind))
+    {
+        case EntityKind::ConstantVelParticle:   fn(static_cast<ConstantVelParticle*>(nullptr)); return true;
+        case EntityKind::SimpleSpringMotion:    fn(static_cast<SimpleSpringMotion*>(nullptr)); return true;
+        case EntityKind::CrudeSpinningPen:      fn(static_cast<CrudeSpinningPen*>(nullptr)); return true;
+        case EntityKind::QuaternionSpinningPen: fn(static_cast<QuaternionSpinningPen*>(nullptr)); return true;
+        case EntityKind::Count:                 break;
+    }
+
+    return false;
+}
+
+template <typename DynamicEntityType>
+Request MakeRequest(uint32_t requestId, const DynamicEntityType& dynEntity, IntegratorKind integrator,
+    double deltaT, double duration, bool trajectory)
+{
+    const typename DynamicEntityType::Params params = dynEntity.GetParams();
+
+    Request request;
+    request.m_Header.m_RequestId = requestId;
+    request.m_Header.m_Entity = static_cast<uint8_t>(EntityKindOf<DynamicEntityType>::value);
+    request.m_Header.m_Integrator = static_cast<uint8_t>(integrator);
+    request.m_Header.m_Flags = trajectory ? FlagTrajectory : 0;
+    request.m_Header.m_NumFields = static_cast<uint16_t>(dynEntity.m_State.size());
+    request.m_Header.m_NumParams = static_cast<uint16_t>(params.size());
+    request.m_Header.m_DeltaT = deltaT;
+    request.m_Header.m_Duration = duration;
+    request.m_Values.assign(dynEntity.m_State.begin(), dynEntity.m_State.end());
+    request.m_Values.insert(request.m_Values.end(), params.begin(), params.end());
+    return request;
+}
+
+// Blocking socket io. Returns false on error or end of stream.
+inline bool ReadAll(int fd, void* buffer, size_t size)
+{
+    char* out = static_cast<char*>(buffer);
+    while (size > 0)
+    {
+        const ssize_t count = recv(fd, out, size, 0);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return false;
+        }
+        out += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+inline bool WriteAll(int fd, const void* buffer, size_t size)
+{
+    const char* in = static_cast<const char*>(buffer);
+    while (size > 0)
+    {
+        const ssize_t count = send(fd, in, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return false;
+        }
+        in += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+// Header and values in one write, so concurrent writers on a
+// connection never split a frame.
+template <typename Header>
+bool WriteFrame(int fd, const Header& header, const double* values, size_t numValues, std::vector<char>& scratch)
+{
+    scratch.resize(sizeof(Header) + numValues * sizeof(double));
+    memcpy(scratch.data(), &header, sizeof(Header));
+    if (numValues > 0)
+    {
+        memcpy(scratch.data() + sizeof(Header), values, numValues * sizeof(double));
+    }
+    return WriteAll(fd, scratch.data(), scratch.size());
+}
+
+inline bool ReadResponse(int fd, Response& outResponse)
+{
+    if (!ReadAll(fd, &outResponse.m_Header, sizeof(ResponseHeader)) || outResponse.m_Header.m_Magic != ResponseMagic)
+    {
+        return false;
+    }
+
+    outResponse.m_Samples.resize(size_t(outResponse.m_Header.m_NumSamples) * (1 + outResponse.m_Header.m_NumFields));
+    return ReadAll(fd, outResponse.m_Samples.data(), outResponse.m_Samples.size() * sizeof(double));
+}
+
+inline sockaddr_un MakeAddress(const std::string& socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+// One connection to a SimServer. Call() is for one request at a time,
+// pipelined clients use Send() and Receive() directly.
+class SimClient
+{
+public:
+
+    SimClient() = default;
+
+    ~SimClient()
+    {
+        Close();
+    }
+
+    SimClient(const SimClient&) = delete;
+    SimClient& operator=(const SimClient&) = delete;
+
+    bool Connect(const std::string& socketPath)
+    {
+        Close();
+        if (socketPath.size() >= sizeof(sockaddr_un::sun_path))
+        {
+            std::cout << "SimClient: socket path too long " << socketPath << "\n";
+            return false;
+        }
+
+        m_Fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        const sockaddr_un address = MakeAddress(socketPath);
+        if (m_Fd < 0 || connect(m_Fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            std::cout << "SimClient: cannot connect to " << socketPath << "\n";
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_Fd >= 0)
+        {
+            close(m_Fd);
+            m_Fd = -1;
+        }
+    }
+
+    bool Send(const Request& request)
+    {
+        return m_Fd >= 0 && WriteFrame(m_Fd, request.m_Header, request.m_Values.data(), request.m_Values.size(), m_Scratch);
+    }
+
+    bool Receive(Response& outResponse)
+    {
+        return m_Fd >= 0 && ReadResponse(m_Fd, outResponse);
+    }
+
+    // Sends request and waits for its Final frame. Trajectory samples,
+    // if requested, are appended to outTrajectory when given.
+    bool Call(const Request& request, Response& outFinal, std::vector<double>* outTrajectory = nullptr)
+    {
+        if (!Send(request))
+        {
+            return false;
+        }
+
+        while (Receive(outFinal))
+        {
+            if (outFinal.m_Header.m_Kind == static_cast<uint8_t>(FrameKind::Final))
+            {
+                return true;
+            }
+            if (outTrajectory)
+            {
+                outTrajectory->insert(outTrajectory->end(), outFinal.m_Samples.begin(), outFinal.m_Samples.end());
+            }
+        }
+        return false;
+    }
+
+private:
+    int m_Fd = -1;
+    std::vector<char> m_Scratch;
+};
+
+} // namespace SimProtocol
@@ -0,0 +1,679 @@
+#pragma once
+
+#include "./DynamicEntityBatches.h"
+#include "./SimProtocol.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// SimServer
+// Descr: Long lived simulation server on a Unix domain
+// socket, see SimProtocol.h for the wire format. Every
+// connection has a reader thread which queues requests by
+// entity type. A dispatcher waits a short batching window
+// for concurrent requests to arrive, then hands all queued
+// requests of one entity type as a batch to the workers,
+// which run them and stream the results back. Final state
+// spinning pen requests with the same Euler or MidPoint
+// integrator, step and duration are stepped together as a
+// CrudeSpinningPenBatch, split across the workers, see
+// DynamicEntityBatches.h. Other requests in a batch run as
+// their own Simulation. The dispatcher waits for a free
+// worker, not for the batch to finish, so a long run or a
+// slow reader holds up one worker and nothing else. Under
+// load a batch also collects whatever arrived while the
+// workers were busy.
+//////////////////////////////////////////////////////////
+
+class SimServer
+{
+public:
+
+    struct Settings
+    {
+        size_t m_NumThreads = 0;            // Workers, zero for every hardware thread.
+        size_t m_MaxBatch = 1024;           // Requests per batch.
+        double m_BatchWindow = 2.0e-4;      // in seconds, wait for a batch to fill.
+        size_t m_SamplesPerFrame = 256;     // Trajectory samples per frame.
+        double m_MaxSteps = 1.0e7;          // Largest duration / dt a request may ask for.
+        double m_SendTimeout = 5.0;         // in seconds, before a stalled client is dropped.
+    };
+
+    struct Stats
+    {
+        uint64_t m_Requests = 0;            // Run, bad requests excluded.
+        uint64_t m_BadRequests = 0;
+        uint64_t m_Batches = 0;
+        uint64_t m_LargestBatch = 0;
+        uint64_t m_PenBatchRequests = 0;    // Run in a CrudeSpinningPenBatch with others.
+        uint64_t m_DroppedConnections = 0;  // Closed after a send timed out or failed.
+    };
+
+    SimServer()
+    : SimServer(Settings{})
+    {}
+
+    explicit SimServer(const Settings& settings)
+    : m_Settings(settings)
+    , m_NumThreads(std::max<size_t>(settings.m_NumThreads == 0 ? std::thread::hardware_concurrency() : settings.m_NumThreads, 1))
+    {}
+
+    ~SimServer()
+    {
+        Stop();
+    }
+
+    SimServer(const SimServer&) = delete;
+    SimServer& operator=(const SimServer&) = delete;
+
+    // Listens on socketPath, replacing a stale socket there, and serves
+    // until Stop(). Returns false if the socket cannot be set up.
+    bool Start(const std::string& socketPath)
+    {
+        if (m_AcceptThread.joinable() || socketPath.size() >= sizeof(sockaddr_un::sun_path))
+        {
+            std::cout << "SimServer: cannot listen on " << socketPath << "\n";
+            return false;
+        }
+
+        struct stat existing;
+        if (stat(socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+        {
+            unlink(socketPath.c_str());
+        }
+
+        m_ListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        const sockaddr_un address = SimProtocol::MakeAddress(socketPath);
+        if (m_ListenFd < 0 ||
+            bind(m_ListenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(m_ListenFd, 128) != 0)
+        {
+            std::cout << "SimServer: cannot listen on " << socketPath << "\n";
+            if (m_ListenFd >= 0)
+            {
+                close(m_ListenFd);
+                m_ListenFd = -1;
+            }
+            return false;
+        }
+
+        m_SocketPath = socketPath;
+        m_Stopping = false;
+        m_AcceptThread = std::thread(&SimServer::AcceptLoop, this);
+        m_DispatchThread = std::thread(&SimServer::DispatchLoop, this);
+        for (size_t workerIdx = 0; workerIdx < m_NumThreads; ++workerIdx)
+        {
+            m_Workers.emplace_back(&SimServer::WorkerLoop, this);
+        }
+        return true;
+    }
+
+    // Finishes the runs in progress, drops queued requests, closes
+    // every connection and removes the socket.
+    void Stop()
+    {
+        if (!m_AcceptThread.joinable())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_PendingCv.notify_all();
+        m_ReadyCv.notify_all();
+
+        m_AcceptThread.join();
+        close(m_ListenFd);
+        m_ListenFd = -1;
+
+        // Wakes the readers out of recv.
+        for (const std::weak_ptr<Connection>& weakConnection : m_Connections)
+        {
+            if (const std::shared_ptr<Connection> connection = weakConnection.lock())
+            {
+                shutdown(connection->m_Fd, SHUT_RDWR);
+            }
+        }
+        for (std::thread& reader : m_Readers)
+        {
+            reader.join();
+        }
+        m_Readers.clear();
+        m_Connections.clear();
+
+        m_DispatchThread.join();
+        for (std::thread& worker : m_Workers)
+        {
+            worker.join();
+        }
+        m_Workers.clear();
+        for (std::deque<Job>& pending : m_Pending)
+        {
+            pending.clear();
+        }
+        m_NumPending = 0;
+        m_Ready.clear();
+        m_NumIdle = 0;
+        unlink(m_SocketPath.c_str());
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        stats.m_Requests = m_NumRequests.load();
+        stats.m_BadRequests = m_NumBadRequests.load();
+        stats.m_Batches = m_NumBatches.load();
+        stats.m_LargestBatch = m_LargestBatch.load();
+        stats.m_PenBatchRequests = m_NumPenBatchRequests.load();
+        stats.m_DroppedConnections = m_NumDroppedConnections.load();
+        return stats;
+    }
+
+    size_t NumThreads() const
+    {
+        return m_NumThreads;
+    }
+
+private:
+
+    static constexpr size_t NumEntityKinds = static_cast<size_t>(SimProtocol::EntityKind::Count);
+
+    // Closed once the reader and every job of the connection are done
+    // with it, so a worker never writes to a reused descriptor.
+    struct Connection
+    {
+        explicit Connection(int fd)
+        : m_Fd(fd)
+        {}
+
+        ~Connection()
+        {
+            close(m_Fd);
+        }
+
+        const int m_Fd;
+        std::mutex m_WriteMutex;
+        std::atomic<bool> m_Open{true};
+    };
+
+    struct Job
+    {
+        std::shared_ptr<Connection> m_Connection;
+        SimProtocol::RequestHeader m_Header;
+        std::vector<double> m_Values;
+        uint32_t m_BatchSize = 0;           // Set on dispatch.
+    };
+
+    void AcceptLoop()
+    {
+        while (!m_Stopping)
+        {
+            // Polled, so that Stop() is noticed.
+            pollfd listenPoll{m_ListenFd, POLLIN, 0};
+            if (poll(&listenPoll, 1, 100) <= 0)
+            {
+                continue;
+            }
+
+            const int fd = accept(m_ListenFd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            // A client which stops reading must not hold a worker for
+            // good, see SendFrame.
+            const double sendTimeout = std::max(m_Settings.m_SendTimeout, 1.0e-3);
+            timeval timeout;
+            timeout.tv_sec = static_cast<time_t>(sendTimeout);
+            timeout.tv_usec = static_cast<suseconds_t>(1.0e6 * (sendTimeout - std::floor(sendTimeout)));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            PruneReaders();
+            const std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd);
+            m_Connections.push_back(connection);
+            m_Readers.emplace_back(&SimServer::ReadLoop, this, connection);
+        }
+    }
+
+    // Joins the readers of closed connections. A connection outlives
+    // its reader, so once it is gone the reader has returned.
+    void PruneReaders()
+    {
+        size_t kept = 0;
+        for (size_t idx = 0; idx < m_Readers.size(); ++idx)
+        {
+            if (m_Connections[idx].expired())
+            {
+                m_Readers[idx].join();
+                continue;
+            }
+            if (kept != idx)
+            {
+                m_Connections[kept] = std::move(m_Connections[idx]);
+                m_Readers[kept] = std::move(m_Readers[idx]);
+            }
+            ++kept;
+        }
+        m_Connections.resize(kept);
+        m_Readers.resize(kept);
+    }
+
+    // Queues the connection's requests until it closes. Malformed
+    // frames close the connection, as the stream cannot be resynced.
+    void ReadLoop(std::shared_ptr<Connection> connection)
+    {
+        std::vector<char> scratch;
+        while (true)
+        {
+            Job job;
+            job.m_Connection = connection;
+            SimProtocol::RequestHeader& header = job.m_Header;
+            if (!SimProtocol::ReadAll(connection->m_Fd, &header, sizeof(header)) ||
+                header.m_Magic != SimProtocol::RequestMagic ||
+                header.m_NumFields > SimProtocol::MaxValues || header.m_NumParams > SimProtocol::MaxValues)
+            {
+                break;
+            }
+
+            job.m_Values.resize(size_t(header.m_NumFields) + header.m_NumParams);
+            if (!SimProtocol::ReadAll(connection->m_Fd, job.m_Values.data(), job.m_Values.size() * sizeof(double)))
+            {
+                break;
+            }
+
+            if (!IsValid(header, job.m_Values))
+            {
+                ++m_NumBadRequests;
+                SimProtocol::ResponseHeader response;
+                response.m_RequestId = header.m_RequestId;
+                response.m_Status = static_cast<uint8_t>(SimProtocol::Status::BadRequest);
+                response.m_Kind = static_cast<uint8_t>(SimProtocol::FrameKind::Final);
+                SendFrame(*connection, response, nullptr, 0, scratch);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Pending[header.m_Entity].push_back(std::move(job));
+                ++m_NumPending;
+            }
+            m_PendingCv.notify_one();
+        }
+
+        connection->m_Open = false;
+    }
+
+    // Known entity and an integrator which supports it, finite state and
+    // params of the entity's sizes, a positive step and duration, and no more steps
+    // than the budget, so that no request holds a worker for long.
+    bool IsValid(const SimProtocol::RequestHeader& header, const std::vector<double>& values) const
+    {
+        const IntegratorKind integrator = static_cast<IntegratorKind>(header.m_Integrator);
+        bool sizesMatch = false;
+        bool supported = false;
+        const bool knownEntity = SimProtocol::VisitEntityKind(header.m_Entity, [&](auto* entityTag)
+        {
+            using DynamicEntityType = std::remove_pointer_t<decltype(entityTag)>;
+            sizesMatch = header.m_NumFields == std::tuple_size<typename DynamicEntityType::State>::value &&
+                header.m_NumParams == DynamicEntityType::NumParams;
+            supported = integrator != IntegratorKind::VelocityVerlet || Integrators::SupportsVelocityVerlet<DynamicEntityType>;
+        });
+
+        const std::string integratorName = IntegratorName(integrator);
+        return knownEntity && sizesMatch && supported && integratorName != "Unknown" &&
+            header.m_DeltaT > 0.0 && header.m_Duration > 0.0 &&
+            std::isfinite(header.m_DeltaT) && std::isfinite(header.m_Duration) &&
+            header.m_Duration / header.m_DeltaT <= m_Settings.m_MaxSteps &&
+            std::all_of(values.begin(), values.end(), [](double value){ return std::isfinite(value); });
+    }
+
+    bool FullBatchPending() const
+    {
+        return std::any_of(m_Pending.begin(), m_Pending.end(), [this](const std::deque<Job>& pending)
+        {
+            return pending.size() >= m_Settings.m_MaxBatch;
+        });
+    }
+
+    void DispatchLoop()
+    {
+        size_t nextKind = 0;
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true)
+        {
+            // Waits for work and a free worker, so that requests which
+            // arrive meanwhile join the next batch.
+            m_PendingCv.wait(lock, [this]
+            {
+                return m_Stopping || (m_NumPending > 0 && m_Ready.size() < m_NumIdle);
+            });
+
+            // Give concurrent requests a moment to join the batch.
+            m_PendingCv.wait_for(lock, std::chrono::duration<double>(m_Settings.m_BatchWindow), [this]
+            {
+                return m_Stopping || FullBatchPending();
+            });
+            if (m_Stopping)
+            {
+                return;
+            }
+
+            // Entity kinds take turns, so none starves.
+            size_t kind = nextKind;
+            while (m_Pending[kind].empty())
+            {
+                kind = (kind + 1) % NumEntityKinds;
+            }
+            nextKind = (kind + 1) % NumEntityKinds;
+
+            std::deque<Job>& pending = m_Pending[kind];
+            const size_t batchSize = std::min(pending.size(), std::max<size_t>(m_Settings.m_MaxBatch, 1));
+            std::vector<Job> batch;
+            batch.reserve(batchSize);
+            std::move(pending.begin(), pending.begin() + batchSize, std::back_inserter(batch));
+            pending.erase(pending.begin(), pending.begin() + batchSize);
+            m_NumPending -= batchSize;
+            QueueBatch(batch);
+
+            m_NumRequests += batchSize;
+            ++m_NumBatches;
+            m_LargestBatch = std::max<uint64_t>(m_LargestBatch.load(), batchSize);
+            m_ReadyCv.notify_all();
+        }
+    }
+
+    // Pen requests a CrudeSpinningPenBatch can run, stepped as
+    // Simulation::Run() would.
+    static bool RunsInPenBatch(const SimProtocol::RequestHeader& header)
+    {
+        const IntegratorKind integrator = static_cast<IntegratorKind>(header.m_Integrator);
+        return header.m_Entity == static_cast<uint8_t>(SimProtocol::EntityKind::CrudeSpinningPen) &&
+            (integrator == IntegratorKind::Euler || integrator == IntegratorKind::MidPoint) &&
+            !(header.m_Flags & SimProtocol::FlagTrajectory) && header.m_DeltaT < header.m_Duration;
+    }
+
+    // Queues a dispatched batch as work items. Pen requests which can
+    // share a CrudeSpinningPenBatch are grouped by integrator, step and
+    // duration, and each group is split into up to one item per worker.
+    // Every other request is an item of its own. Called with m_Mutex held.
+    void QueueBatch(std::vector<Job>& batch)
+    {
+        std::vector<Job> penJobs;
+        for (Job& job : batch)
+        {
+            job.m_BatchSize = static_cast<uint32_t>(batch.size());
+            if (RunsInPenBatch(job.m_Header))
+            {
+                penJobs.push_back(std::move(job));
+            }
+            else
+            {
+                m_Ready.emplace_back();
+                m_Ready.back().push_back(std::move(job));
+            }
+        }
+
+        auto groupKey = [](const Job& job)
+        {
+            return std::make_tuple(job.m_Header.m_Integrator, job.m_Header.m_DeltaT, job.m_Header.m_Duration);
+        };
+        std::stable_sort(penJobs.begin(), penJobs.end(), [&](const Job& a, const Job& b)
+        {
+            return groupKey(a) < groupKey(b);
+        });
+
+        for (size_t begin = 0; begin < penJobs.size(); )
+        {
+            size_t end = begin + 1;
+            while (end < penJobs.size() && groupKey(penJobs[end]) == groupKey(penJobs[begin]))
+            {
+                ++end;
+            }
+
+            const size_t chunkSize = (end - begin + m_NumThreads - 1) / m_NumThreads;
+            for (size_t chunk = begin; chunk < end; chunk += chunkSize)
+            {
+                m_Ready.emplace_back();
+                std::move(penJobs.begin() + chunk, penJobs.begin() + std::min(chunk + chunkSize, end),
+                    std::back_inserter(m_Ready.back()));
+            }
+            begin = end;
+        }
+    }
+
+    // Runs dispatched work items one at a time, whichever batch they are from.
+    void WorkerLoop()
+    {
+        std::vector<char> scratch;      // Frame buffer.
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true)
+        {
+            ++m_NumIdle;
+            m_PendingCv.notify_one();
+            m_ReadyCv.wait(lock, [this]{ return m_Stopping || !m_Ready.empty(); });
+            --m_NumIdle;
+            if (m_Stopping)
+            {
+                return;
+            }
+
+            const std::vector<Job> work = std::move(m_Ready.front());
+            m_Ready.pop_front();
+
+            lock.unlock();
+            if (work.size() > 1)
+            {
+                RunPenBatch(work, scratch);
+            }
+            else
+            {
+                const Job& job = work.front();
+                SimProtocol::VisitEntityKind(job.m_Header.m_Entity, [&](auto* entityTag)
+                {
+                    using DynamicEntityType = std::remove_pointer_t<decltype(entityTag)>;
+                    RunJob<DynamicEntityType>(job, scratch);
+                });
+            }
+            lock.lock();
+        }
+    }
+
+    // Runs pen requests sharing integrator, step and duration, see
+    // RunsInPenBatch, column wise as one batch. Same steps as
+    // Simulation::Run(), so results match single runs to rounding.
+    void RunPenBatch(const std::vector<Job>& jobs, std::vector<char>& scratch)
+    {
+        constexpr size_t NumFields = std::tuple_size<CrudeSpinningPen::State>::value;
+
+        std::vector<CrudeSpinningPen> pens;
+        pens.reserve(jobs.size());
+        for (const Job& job : jobs)
+        {
+            CrudeSpinningPen::State state;
+            CrudeSpinningPen::Params params;
+            std::copy(job.m_Values.begin(), job.m_Values.begin() + NumFields, state.begin());
+            std::copy(job.m_Values.begin() + NumFields, job.m_Values.end(), params.begin());
+            pens.emplace_back(state, params);
+        }
+
+        const SimProtocol::RequestHeader& request = jobs.front().m_Header;
+        const bool euler = static_cast<IntegratorKind>(request.m_Integrator) == IntegratorKind::Euler;
+        CrudeSpinningPenBatch batch(pens);
+        double elapsedTime = 0.0;
+        while (elapsedTime < request.m_Duration)
+        {
+            if (euler)
+            {
+                Integrators::EulerStep(batch, request.m_DeltaT);
+            }
+            else
+            {
+                Integrators::MidPointStep(batch, request.m_DeltaT);
+            }
+            elapsedTime += request.m_DeltaT;
+        }
+        m_NumPenBatchRequests += jobs.size();
+
+        SimProtocol::ResponseHeader header;
+        header.m_Status = static_cast<uint8_t>(SimProtocol::Status::Ok);
+        header.m_Kind = static_cast<uint8_t>(SimProtocol::FrameKind::Final);
+        header.m_NumFields = static_cast<uint16_t>(NumFields);
+        header.m_NumSamples = 1;
+        std::array<double, 1 + NumFields> finalSample;
+        finalSample[0] = elapsedTime;
+        for (size_t pen = 0; pen < jobs.size(); ++pen)
+        {
+            const CrudeSpinningPen::State state = batch.GetState(pen);
+            std::copy(state.begin(), state.end(), finalSample.begin() + 1);
+            header.m_RequestId = jobs[pen].m_Header.m_RequestId;
+            header.m_BatchSize = jobs[pen].m_BatchSize;
+            SendFrame(*jobs[pen].m_Connection, header, finalSample.data(), finalSample.size(), scratch);
+        }
+    }
+
+    template <typename DynamicEntityType>
+    void RunJob(const Job& job, std::vector<char>& scratch)
+    {
+        using State = typename DynamicEntityType::State;
+        using Params = typename DynamicEntityType::Params;
+        constexpr size_t NumFields = std::tuple_size<State>::value;
+        constexpr size_t SampleSize = 1 + NumFields;
+
+        // Nobody is listening any more.
+        if (!job.m_Connection->m_Open)
+        {
+            return;
+        }
+
+        State state;
+        Params params;
+        std::copy(job.m_Values.begin(), job.m_Values.begin() + NumFields, state.begin());
+        if constexpr (std::tuple_size<Params>::value > 0)
+        {
+            std::copy(job.m_Values.begin() + NumFields, job.m_Values.end(), params.begin());
+        }
+        const DynamicEntityType dynEntity(state, params);
+
+        SimProtocol::ResponseHeader header;
+        header.m_RequestId = job.m_Header.m_RequestId;
+        header.m_Status = static_cast<uint8_t>(SimProtocol::Status::Ok);
+        header.m_Kind = static_cast<uint8_t>(SimProtocol::FrameKind::Trajectory);
+        header.m_NumFields = static_cast<uint16_t>(NumFields);
+        header.m_BatchSize = job.m_BatchSize;
+
+        std::vector<double> samples;
+        const size_t frameValues = std::max<size_t>(m_Settings.m_SamplesPerFrame, 1) * SampleSize;
+        SelectedOutputSink<DynamicEntityType> outputSink;
+        if (job.m_Header.m_Flags & SimProtocol::FlagTrajectory)
+        {
+            samples.reserve(frameValues);
+            outputSink = [&](double time, const State& sampleState)
+            {
+                samples.push_back(time);
+                samples.insert(samples.end(), sampleState.begin(), sampleState.end());
+                if (samples.size() == frameValues)
+                {
+                    header.m_NumSamples = static_cast<uint32_t>(samples.size() / SampleSize);
+                    SendFrame(*job.m_Connection, header, samples.data(), samples.size(), scratch);
+                    samples.clear();
+                }
+            };
+        }
+
+        const SelectedRunResult<DynamicEntityType> result = RunSimulation<DynamicEntityType>(
+            static_cast<IntegratorKind>(job.m_Header.m_Integrator), job.m_Header.m_Duration, job.m_Header.m_DeltaT,
+            false, dynEntity, Integrators::AdaptiveTolerances{}, outputSink);
+
+        if (!samples.empty())
+        {
+            header.m_NumSamples = static_cast<uint32_t>(samples.size() / SampleSize);
+            SendFrame(*job.m_Connection, header, samples.data(), samples.size(), scratch);
+        }
+
+        std::array<double, SampleSize> finalSample;
+        finalSample[0] = result.m_ElapsedTime;
+        std::copy(result.m_Output.begin(), result.m_Output.end(), finalSample.begin() + 1);
+        header.m_Status = static_cast<uint8_t>(result.m_IsValid ? SimProtocol::Status::Ok : SimProtocol::Status::SimulationFailed);
+        header.m_Kind = static_cast<uint8_t>(SimProtocol::FrameKind::Final);
+        header.m_NumSamples = 1;
+        SendFrame(*job.m_Connection, header, finalSample.data(), finalSample.size(), scratch);
+    }
+
+    // A failed or timed out write may leave part of a frame behind, so
+    // the connection is closed, which also ends its reader and skips the
+    // rest of its jobs' output.
+    void SendFrame(Connection& connection, const SimProtocol::ResponseHeader& header,
+        const double* values, size_t numValues, std::vector<char>& scratch)
+    {
+        std::lock_guard<std::mutex> lock(connection.m_WriteMutex);
+        if (!connection.m_Open)
+        {
+            return;
+        }
+
+        if (!SimProtocol::WriteFrame(connection.m_Fd, header, values, numValues, scratch))
+        {
+            connection.m_Open = false;
+            shutdown(connection.m_Fd, SHUT_RDWR);
+            ++m_NumDroppedConnections;
+        }
+    }
+
+private:
+    const Settings m_Settings;
+    const size_t m_NumThreads;
+
+    std::string m_SocketPath;
+    int m_ListenFd = -1;
+    std::atomic<bool> m_Stopping{false};
+    std::thread m_AcceptThread;
+    std::thread m_DispatchThread;
+    std::vector<std::thread> m_Workers;
+
+    // Owned by the accept thread until Stop() joins it. Reader idx
+    // serves connection idx.
+    std::vector<std::weak_ptr<Connection>> m_Connections;
+    std::vector<std::thread> m_Readers;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_PendingCv;
+    std::array<std::deque<Job>, NumEntityKinds> m_Pending;     // By SimProtocol::EntityKind.
+    size_t m_NumPending = 0;
+    std::condition_variable m_ReadyCv;
+    std::deque<std::vector<Job>> m_Ready;   // Dispatched work items, waiting for a worker.
+    size_t m_NumIdle = 0;                   // Workers waiting for a job.
+
+    std::atomic<uint64_t> m_NumRequests{0};
+    std::atomic<uint64_t> m_NumBadRequests{0};
+    std::atomic<uint64_t> m_NumBatches{0};
+    std::atomic<uint64_t> m_LargestBatch{0};
+    std::atomic<uint64_t> m_NumPenBatchRequests{0};
+    std::atomic<uint64_t> m_NumDroppedConnections{0};
+};
@@ -0,0 +1,279 @@
+#include "./DynamicEntities.h"
+#include "./IntegratorSelection.h"
+#include "./SimServer.h"
+#include "./TestUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// SimServer Unit Tests
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Final frame state, without its time.
+template <typename DynamicEntityType>
+typename DynamicEntityType::State FinalState(const SimProtocol::Response& response)
+{
+    typename DynamicEntityType::State state{};
+    if (response.m_Samples.size() == state.size() + 1)
+    {
+        std::copy(response.m_Samples.begin() + 1, response.m_Samples.end(), state.begin());
+    }
+    return state;
+}
+
+} // namespace
+
+int main(void)
+{
+    const std::string socketPath = "/tmp/SimServer_Test." + std::to_string(getpid()) + ".sock";
+    const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+    const CrudeSpinningPen pen{CrudeSpinningPen::State{
+        0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 1.0, 1.0, 30.0, 2.0, 0.5, 10.0}, {10.0, 8.0, 1.0}};
+
+    //////////////////////////////////////////////////////////
+    // Test request layout, state then params.
+    {
+        const SimProtocol::Request request = SimProtocol::MakeRequest(7, pen, IntegratorKind::RK4, .01, 1.0, true);
+        const bool layoutEq = request.m_Header.m_RequestId == 7 &&
+            request.m_Header.m_Entity == static_cast<uint8_t>(SimProtocol::EntityKind::CrudeSpinningPen) &&
+            request.m_Header.m_Integrator == static_cast<uint8_t>(IntegratorKind::RK4) &&
+            request.m_Header.m_Flags == SimProtocol::FlagTrajectory &&
+            request.m_Header.m_NumFields == 12 && request.m_Header.m_NumParams == 3 &&
+            request.m_Values.size() == 15 && request.m_Values[11] == 10.0 && request.m_Values[12] == 10.0 &&
+            request.m_Values[14] == 1.0;
+        TestUtils::ReportResults(layoutEq, "SimServer Test: Request Layout");
+    }
+
+    SimServer::Settings settings;
+    settings.m_NumThreads = 4;
+    settings.m_BatchWindow = 2.0e-2;
+    settings.m_SamplesPerFrame = 16;
+    settings.m_MaxSteps = 4.0e6;
+    settings.m_SendTimeout = 0.2;
+    SimServer server(settings);
+    const bool started = server.Start(socketPath);
+    TestUtils::ReportResults(started, "SimServer Test: Start");
+    if (!started)
+    {
+        return 0;
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test final states match local runs bit exactly.
+    {
+        SimProtocol::SimClient client;
+        SimProtocol::Response springResponse, penResponse;
+        const bool called = client.Connect(socketPath) &&
+            client.Call(SimProtocol::MakeRequest(1, shm, IntegratorKind::RK4, .001, 1.0, false), springResponse) &&
+            client.Call(SimProtocol::MakeRequest(2, pen, IntegratorKind::MidPoint, .01, 2.0, false), penResponse);
+
+        const auto springLocal = RunSimulation(IntegratorKind::RK4, 1.0, .001, false, shm);
+        const auto penLocal = RunSimulation(IntegratorKind::MidPoint, 2.0, .01, false, pen);
+        const bool finalEq = called &&
+            springResponse.m_Header.m_RequestId == 1 && penResponse.m_Header.m_RequestId == 2 &&
+            springResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::Ok) &&
+            FinalState<SimpleSpringMotion>(springResponse) == springLocal.m_Output &&
+            FinalState<CrudeSpinningPen>(penResponse) == penLocal.m_Output &&
+            penResponse.m_Samples[0] == penLocal.m_ElapsedTime;
+        TestUtils::ReportResults(finalEq, "SimServer Test: Final States");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test trajectories stream every step, in frames, ending at
+    // the final state.
+    {
+        SimProtocol::SimClient client;
+        SimProtocol::Response response;
+        std::vector<double> trajectory;
+        const bool called = client.Connect(socketPath) &&
+            client.Call(SimProtocol::MakeRequest(3, pen, IntegratorKind::RK4, .01, 1.0 - .005, true), response, &trajectory);
+
+        const size_t sampleSize = 13;
+        const bool trajectoryEq = called && trajectory.size() == 101 * sampleSize &&
+            trajectory[0] == 0.0 && trajectory[1] == 0.0 &&
+            std::equal(trajectory.end() - sampleSize, trajectory.end(), response.m_Samples.begin());
+        TestUtils::ReportResults(trajectoryEq, "SimServer Test: Trajectory Stream");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test bad requests are answered, and failed runs reported.
+    {
+        SimProtocol::SimClient client;
+        SimProtocol::Request wrongSize = SimProtocol::MakeRequest(4, shm, IntegratorKind::RK4, .01, 1.0, false);
+        wrongSize.m_Header.m_Entity = static_cast<uint8_t>(SimProtocol::EntityKind::CrudeSpinningPen);
+        SimProtocol::Request badIntegrator = SimProtocol::MakeRequest(5, shm, IntegratorKind::RK4, .01, 1.0, false);
+        badIntegrator.m_Header.m_Integrator = 200;
+        const SimProtocol::Request overBudget = SimProtocol::MakeRequest(7, shm, IntegratorKind::RK4, 1.0e-7, 1.0, false);
+        SimProtocol::Request nanState = SimProtocol::MakeRequest(12, shm, IntegratorKind::DormandPrince, .01, 1.0, false);
+        nanState.m_Values[0] = std::nan("");
+        const SimProtocol::Request penVerlet = SimProtocol::MakeRequest(13, pen, IntegratorKind::VelocityVerlet, .01, 1.0, false);
+
+        SimProtocol::Response sizeResponse, integratorResponse, failedResponse, budgetResponse, nanResponse, verletResponse;
+        const bool called = client.Connect(socketPath) &&
+            client.Call(wrongSize, sizeResponse) && client.Call(badIntegrator, integratorResponse) &&
+            client.Call(SimProtocol::MakeRequest(6, shm, IntegratorKind::RK4, 2.0, 1.0, false), failedResponse) &&
+            client.Call(overBudget, budgetResponse) && client.Call(nanState, nanResponse) &&
+            client.Call(penVerlet, verletResponse);
+
+        const bool errorsEq = called &&
+            sizeResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::BadRequest) &&
+            integratorResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::BadRequest) &&
+            failedResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::SimulationFailed) &&
+            budgetResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::BadRequest) &&
+            nanResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::BadRequest) &&
+            verletResponse.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::BadRequest) &&
+            server.GetStats().m_BadRequests == 5;
+        TestUtils::ReportResults(errorsEq, "SimServer Test: Errors");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test concurrent clients are coalesced into batches, and
+    // every one gets its own answer.
+    {
+        const size_t numClients = 8;
+        const size_t requestsPerClient = 10;
+        const auto expected = RunSimulation(IntegratorKind::RK4, 1.0, .01, false, pen);
+        const uint64_t batchesBefore = server.GetStats().m_Batches;
+
+        std::vector<int> clientOk(numClients, 0);
+        std::vector<std::thread> clients;
+        for (size_t clientIdx = 0; clientIdx < numClients; ++clientIdx)
+        {
+            clients.emplace_back([&, clientIdx]
+            {
+                SimProtocol::SimClient client;
+                bool ok = client.Connect(socketPath);
+                for (size_t idx = 0; ok && idx < requestsPerClient; ++idx)
+                {
+                    const uint32_t requestId = static_cast<uint32_t>(100 * clientIdx + idx);
+                    SimProtocol::Response response;
+                    ok = client.Call(SimProtocol::MakeRequest(requestId, pen, IntegratorKind::RK4, .01, 1.0, false), response) &&
+                        response.m_Header.m_RequestId == requestId &&
+                        FinalState<CrudeSpinningPen>(response) == expected.m_Output;
+                }
+                clientOk[clientIdx] = ok ? 1 : 0;
+            });
+        }
+        for (std::thread& client : clients)
+        {
+            client.join();
+        }
+
+        const SimServer::Stats stats = server.GetStats();
+        const bool batchedEq = std::count(clientOk.begin(), clientOk.end(), 1) == int(numClients) &&
+            stats.m_LargestBatch > 1 &&
+            stats.m_Batches - batchesBefore < numClients * requestsPerClient;
+        TestUtils::ReportResults(batchedEq, "SimServer Test: Concurrent Batching");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test concurrent pen requests sharing integrator and step
+    // run as a CrudeSpinningPenBatch, each getting its own pen.
+    {
+        const size_t numClients = 8;
+        const size_t requestsPerClient = 4;
+        const uint64_t penBatchBefore = server.GetStats().m_PenBatchRequests;
+
+        std::vector<int> clientOk(numClients, 0);
+        std::vector<std::thread> clients;
+        for (size_t clientIdx = 0; clientIdx < numClients; ++clientIdx)
+        {
+            clients.emplace_back([&, clientIdx]
+            {
+                SimProtocol::SimClient client;
+                bool ok = client.Connect(socketPath);
+                for (size_t idx = 0; ok && idx < requestsPerClient; ++idx)
+                {
+                    CrudeSpinningPen::State state{0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 1.0, 1.0, 30.0, 2.0, 0.5, 10.0};
+                    state[9] += 0.1 * clientIdx;
+                    state[11] -= idx;
+                    const CrudeSpinningPen clientPen{state, {10.0, 8.0, 1.0}};
+                    const auto expected = RunSimulation(IntegratorKind::MidPoint, 1.0, .01, false, clientPen);
+
+                    const uint32_t requestId = static_cast<uint32_t>(200 + 100 * clientIdx + idx);
+                    SimProtocol::Response response;
+                    ok = client.Call(SimProtocol::MakeRequest(requestId, clientPen, IntegratorKind::MidPoint, .01, 1.0, false), response) &&
+                        response.m_Header.m_RequestId == requestId &&
+                        response.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::Ok) &&
+                        response.m_Samples[0] == expected.m_ElapsedTime &&
+                        TestUtils::FloatEquals(FinalState<CrudeSpinningPen>(response), expected.m_Output, 1.0e-9);
+                }
+                clientOk[clientIdx] = ok ? 1 : 0;
+            });
+        }
+        for (std::thread& client : clients)
+        {
+            client.join();
+        }
+
+        const bool penBatchEq = std::count(clientOk.begin(), clientOk.end(), 1) == int(numClients) &&
+            server.GetStats().m_PenBatchRequests > penBatchBefore;
+        TestUtils::ReportResults(penBatchEq, "SimServer Test: Pen Batches");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a long run does not hold up requests which arrive
+    // after its batch was dispatched.
+    {
+        std::atomic<bool> longDone{false};
+        bool longOk = false;
+        std::thread longClient([&]
+        {
+            SimProtocol::SimClient client;
+            SimProtocol::Response response;
+            longOk = client.Connect(socketPath) &&
+                client.Call(SimProtocol::MakeRequest(8, pen, IntegratorKind::RK4, 1.0e-6, 1.0, false), response) &&
+                response.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::Ok);
+            longDone = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        SimProtocol::SimClient client;
+        SimProtocol::Response response;
+        const bool shortOk = client.Connect(socketPath) &&
+            client.Call(SimProtocol::MakeRequest(9, shm, IntegratorKind::RK4, .01, 1.0, false), response) &&
+            response.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::Ok);
+        const bool overtook = !longDone;
+        longClient.join();
+
+        TestUtils::ReportResults(shortOk && overtook && longOk, "SimServer Test: No Straggler Wait");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test a client which stops reading its trajectory is
+    // dropped after the send timeout, and others are served.
+    {
+        SimProtocol::SimClient stalled;
+        const bool sent = stalled.Connect(socketPath) &&
+            stalled.Send(SimProtocol::MakeRequest(10, pen, IntegratorKind::RK4, 1.0e-5, 1.0, true));
+
+        const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (server.GetStats().m_DroppedConnections == 0 && std::chrono::steady_clock::now() < giveUp)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        SimProtocol::SimClient client;
+        SimProtocol::Response response;
+        const bool served = client.Connect(socketPath) &&
+            client.Call(SimProtocol::MakeRequest(11, shm, IntegratorKind::RK4, .01, 1.0, false), response) &&
+            response.m_Header.m_Status == static_cast<uint8_t>(SimProtocol::Status::Ok);
+
+        TestUtils::ReportResults(sent && server.GetStats().m_DroppedConnections == 1 && served,
+            "SimServer Test: Stalled Client Dropped");
+    }
+
+    server.Stop();
+    TestUtils::ReportResults(access(socketPath.c_str(), F_OK) != 0, "SimServer Test: Stop");
+
+    return 0;
+}
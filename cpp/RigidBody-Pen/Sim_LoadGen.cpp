@@ -0,0 +1,160 @@
+#include "./DynamicEntities.h"
+#include "./SimProtocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// Sim_LoadGen
+// Descr: Load generator for Sim_Server. Each client thread
+// has its own connection and sends one spinning pen request
+// at a time, closed loop, so offered load scales with the
+// number of clients. Writes throughput, latency percentiles
+// and the mean batch size the server ran, as JSON.
+// Usage: ./Sim_LoadGen <socket> [clients] [requests per client]
+//     [duration] [dt] [--trajectory]
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+struct ClientResult
+{
+    std::vector<double> m_Latencies;        // in seconds.
+    uint64_t m_BatchSizeSum = 0;
+    uint64_t m_Failures = 0;
+};
+
+void RunClient(const std::string& socketPath, size_t clientIdx, size_t numRequests, double duration, double deltaT,
+    bool trajectory, ClientResult& outResult)
+{
+    SimProtocol::SimClient client;
+    if (!client.Connect(socketPath))
+    {
+        outResult.m_Failures = numRequests;
+        return;
+    }
+
+    std::mt19937 rng(static_cast<uint32_t>(clientIdx));
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    outResult.m_Latencies.reserve(numRequests);
+
+    SimProtocol::Response response;
+    std::vector<double> samples;
+    for (size_t idx = 0; idx < numRequests; ++idx)
+    {
+        const CrudeSpinningPen pen{CrudeSpinningPen::State{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 5.0 + jitter(rng), 5.0 + jitter(rng), 10.0, 10.0, 0.0, 10.0 + jitter(rng)},
+            {10.0, 10.0, 1.0}};
+        const SimProtocol::Request request =
+            SimProtocol::MakeRequest(static_cast<uint32_t>(idx), pen, IntegratorKind::RK4, deltaT, duration, trajectory);
+
+        samples.clear();
+        const auto start = std::chrono::steady_clock::now();
+        const bool called = client.Call(request, response, &samples);
+        const auto end = std::chrono::steady_clock::now();
+
+        if (!called || response.m_Header.m_Status != static_cast<uint8_t>(SimProtocol::Status::Ok))
+        {
+            ++outResult.m_Failures;
+            if (!called)
+            {
+                outResult.m_Failures += numRequests - idx - 1;
+                return;
+            }
+            continue;
+        }
+        outResult.m_Latencies.push_back(std::chrono::duration<double>(end - start).count());
+        outResult.m_BatchSizeSum += response.m_Header.m_BatchSize;
+    }
+}
+
+// Nearest rank percentile of sorted values.
+double Percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: ./Sim_LoadGen <socket> [clients] [requests per client] [duration] [dt] [--trajectory]\n";
+        return 1;
+    }
+
+    const std::string socketPath = argv[1];
+    size_t numClients = 16;
+    size_t requestsPerClient = 200;
+    double duration = 2.04;
+    double deltaT = .01;
+    bool trajectory = false;
+    for (int arg = 2, positional = 0; arg < argc; ++arg)
+    {
+        const std::string value = argv[arg];
+        if (value == "--trajectory")
+        {
+            trajectory = true;
+            continue;
+        }
+        switch (positional++)
+        {
+            case 0: numClients = std::stoul(value); break;
+            case 1: requestsPerClient = std::stoul(value); break;
+            case 2: duration = std::stod(value); break;
+            default: deltaT = std::stod(value); break;
+        }
+    }
+
+    std::vector<ClientResult> results(numClients);
+    std::vector<std::thread> clients;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t clientIdx = 0; clientIdx < numClients; ++clientIdx)
+    {
+        clients.emplace_back(RunClient, socketPath, clientIdx, requestsPerClient, duration, deltaT, trajectory,
+            std::ref(results[clientIdx]));
+    }
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    uint64_t batchSizeSum = 0;
+    uint64_t failures = 0;
+    for (const ClientResult& result : results)
+    {
+        latencies.insert(latencies.end(), result.m_Latencies.begin(), result.m_Latencies.end());
+        batchSizeSum += result.m_BatchSizeSum;
+        failures += result.m_Failures;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const double completed = static_cast<double>(latencies.size());
+
+    std::cout << "{\n  \"clients\": " << numClients << ",\n"
+              << "  \"requests\": " << latencies.size() << ",\n"
+              << "  \"failures\": " << failures << ",\n"
+              << "  \"trajectory\": " << (trajectory ? "true" : "false") << ",\n"
+              << "  \"elapsed_s\": " << elapsed << ",\n"
+              << "  \"throughput_per_s\": " << (elapsed > 0.0 ? completed / elapsed : 0.0) << ",\n"
+              << "  \"mean_batch_size\": " << (completed > 0.0 ? static_cast<double>(batchSizeSum) / completed : 0.0) << ",\n"
+              << "  \"latency_ms\": {"
+              << "\"p50\": " << 1.0e3 * Percentile(latencies, 0.5)
+              << ", \"p90\": " << 1.0e3 * Percentile(latencies, 0.9)
+              << ", \"p99\": " << 1.0e3 * Percentile(latencies, 0.99)
+              << ", \"max\": " << 1.0e3 * (latencies.empty() ? 0.0 : latencies.back()) << "}\n}\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "./SimServer.h"
+
+#include <csignal>
+#include <iostream>
+#include <pthread.h>
+#include <signal.h>
+#include <string>
+
+//////////////////////////////////////////////////////////
+// Sim_Server
+// Descr: Simulation daemon, serves SimProtocol requests on a
+// Unix domain socket until interrupted, then prints its
+// stats. Clients, eg Sim_LoadGen, reuse the one process
+// instead of starting a simulation process per scenario.
+// Usage: ./Sim_Server <socket> [threads] [batch window]
+// Threads default to every hardware thread, the batch
+// window is in seconds.
+//////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: ./Sim_Server <socket> [threads] [batch window]\n";
+        return 1;
+    }
+
+    SimServer::Settings settings;
+    if (argc > 2)
+    {
+        settings.m_NumThreads = std::stoul(argv[2]);
+    }
+    if (argc > 3)
+    {
+        settings.m_BatchWindow = std::stod(argv[3]);
+    }
+
+    // Blocked before any thread starts, so only sigwait sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    SimServer server(settings);
+    if (!server.Start(argv[1]))
+    {
+        return 1;
+    }
+    std::cout << "Serving on " << argv[1] << " with " << server.NumThreads() << " threads" << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.Stop();
+
+    const SimServer::Stats stats = server.GetStats();
+    std::cout << "Requests: " << stats.m_Requests
+              << ", bad requests: " << stats.m_BadRequests
+              << ", batches: " << stats.m_Batches
+              << ", largest batch: " << stats.m_LargestBatch
+              << ", pen batch requests: " << stats.m_PenBatchRequests
+              << ", dropped connections: " << stats.m_DroppedConnections << "\n";
+    return 0;
+}
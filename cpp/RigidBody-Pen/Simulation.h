@@ -1,29 +1,120 @@
+#pragma once
+
+#include "./Instrumentation.h"
 #include "./Integrators.h"
+#include "./Invariants.h"
+#include "./RealTime.h"
+#include "./TextOutput.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <functional>
 #include <iostream>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
 
 //////////////////////////////////////////////////////////
 // Simulation main class.
 // Descr:
 //////////////////////////////////////////////////////////
 
-template <typename DynamicEntityType>
+// Integrator is a policy from Integrators.h, eg Integrators::RK4,
+// or Integrators::DormandPrince for adaptive steps. It is resolved
+// at compile time, so every entity and integrator combination is
+// inlined into Run(), and fixed step runs carry no adaptive state.
+// InstrumentationPolicy is Instrumentation::Disabled, which costs
+// nothing, or Instrumentation::Enabled to profile Run(), see
+// GetInstrumentation().
+// DynamicEntityType may be over any scalar type, eg
+// CrudeSpinningPenT<float>. Simulation time is always double.
+template <typename DynamicEntityType, template <typename> class Integrator = Integrators::MidPoint,
+    typename InstrumentationPolicy = Instrumentation::Disabled>
 class Simulation
 {
 public:
 
+    // The type stepped by the integrator. DynamicEntityType itself
+    // unless instrumented.
+    using StepEntity = typename InstrumentationPolicy::template Entity<DynamicEntityType>;
+
+    // True if Integrator steps by error control, see SetTolerances.
+    static constexpr bool Adaptive = Integrators::IsAdaptive<Integrator<StepEntity>>::value;
+
+    // Scalar type of the state, eg double or float.
+    using Scalar = Integrators::ScalarOf<DynamicEntityType>;
+
     // Simulation output for now is just final state. Redefine 
     // if something more sophisticated is required later, eg .bag
     // file or other.
     using SimulationOutputType = typename DynamicEntityType::State;
 
+    // Receives the state after every step, and the initial state, with
+    // its simulation time. Eg a TrajectoryWriter, see TrajectoryFile.h.
+    using OutputSink = std::function<void(double, const typename DynamicEntityType::State&)>;
+
+    // Scalar event function g(state), eg height above ground. An event
+    // fires where g crosses zero.
+    using EventFunction = std::function<double(const typename DynamicEntityType::State&)>;
+
+    enum class EventDirection
+    {
+        Rising,     // g goes from negative to zero or positive.
+        Falling,    // g goes from positive to zero or negative.
+        Either
+    };
+
+    enum class EventAction
+    {
+        Terminate,
+        Record
+    };
+
+    // Everything needed to resume a run bit exactly: the entity's state
+    // and parameters, the time reached and the integrator's scratch.
+    // Event functions and sinks are not part of it, they belong to the
+    // Simulation a checkpoint is restored into.
+    struct Checkpoint
+    {
+        DynamicEntityType m_DynEntity;
+        double m_ElapsedTime;                   // in seconds.
+        Integrator<StepEntity> m_Integrator;
+        Integrators::StepStats m_StepStats;
+    };
+
+    // Receives the simulation time, the index into
+    // DynamicEntityType::ConservedNames and the relative drift of a
+    // conserved quantity when it first exceeds its budget, see
+    // SetInvariantMonitor.
+    using DriftAlarm = std::function<void(double, size_t, double)>;
+
+    // Relative drift of each conserved quantity.
+    using InvariantDrifts = typename Invariants::DriftMonitor<DynamicEntityType>::Drifts;
+
+    // Receives periodic checkpoints during Run(), see SetCheckpointInterval.
+    using CheckpointSink = std::function<void(const Checkpoint&)>;
+
+    struct EventRecord
+    {
+        size_t m_EventIdx;                      // Order of AddEvent calls.
+        double m_Time;                          // in seconds.
+        typename DynamicEntityType::State m_State;
+    };
+
     Simulation(double duration, double deltaT, bool printStatus, DynamicEntityType dynEntity)
     : m_Duration(duration)
     , m_DeltaT(deltaT)
     , m_PrintStatus(printStatus)
     , m_DynEntity(dynEntity)
-    {}
+    , m_StepStart(dynEntity)
+    {
+        // Adaptive runs start from a step of deltaT.
+        if constexpr (Adaptive)
+        {
+            m_Integrator.SetDeltaT(deltaT);
+        }
+    }
 
     bool Run()
     {
@@ -35,25 +126,116 @@ public:
         }
         else
         {
-            // Track the simulation time
-            double elapsedTime = 0.0; 
+            // Track the simulation time, from a restored checkpoint if any.
+            m_ElapsedTime = m_StartTime;
+            m_NextCheckpointTime = m_StartTime + m_CheckpointInterval;
+            m_TerminatedByEvent = false;
+            m_TerminatedByDrift = false;
+            const size_t failedSteps = m_StepStats.m_FailedSteps;
+            m_Instrumentation.BeginRun();
+            m_Instrumentation.Attach(m_DynEntity);
 
-            if(m_PrintStatus)
+            if(m_RealTime)
             {
-                PrintStatus(elapsedTime);
+                m_Pacer.Begin();
             }
 
-            while(elapsedTime < m_Duration)
+            UpdateEventValues();
+
+            if(m_DenseOutput)
             {
+                m_DenseKnots.clear();
+                RecordDenseKnot();
+            }
+
+            if(m_MonitorInvariants)
+            {
+                m_DriftMonitor.Begin(m_DynEntity);
+                m_StepsToDriftCheck = m_StepsPerDriftCheck;
+            }
+
+            {
+                [[maybe_unused]] const auto outputScope = m_Instrumentation.Time(Instrumentation::Phase::Output);
+
+                if(m_PrintStatus)
+                {
+                    PrintStatus(m_ElapsedTime);
+                }
+
+                if(m_OutputSink)
+                {
+                    m_OutputSink(m_ElapsedTime, m_DynEntity.m_State);
+                }
+            }
+
+            while(m_ElapsedTime < m_Duration)
+            {
+                // Keep the start of the step, to locate events inside it.
+                const double stepStartTime = m_ElapsedTime;
+                if(!m_Events.empty())
+                {
+                    m_StepStart = m_DynEntity;
+                }
+
                 // Update
-                Integrators::MidPointStep(m_DynEntity, m_DeltaT);
-                elapsedTime += m_DeltaT;    
+                {
+                    [[maybe_unused]] const auto stepScope = m_Instrumentation.Time(Instrumentation::Phase::Step);
+                    Advance();
+                    m_Instrumentation.CountStep();
+                }
+
+                // A failed step, eg on a non-finite state, ends the run.
+                if(m_StepStats.m_FailedSteps != failedSteps)
+                {
+                    std::cout << "Simulation Failed! Step failed at t = " << m_ElapsedTime << "\n";
+                    return false;
+                }
+
+                if(!m_Events.empty())
+                {
+                    [[maybe_unused]] const auto eventsScope = m_Instrumentation.Time(Instrumentation::Phase::Events);
+                    m_TerminatedByEvent = ProcessEvents(stepStartTime);
+                }
+
+                if(m_DenseOutput)
+                {
+                    RecordDenseKnot();
+                }
+
+                if(m_MonitorInvariants && --m_StepsToDriftCheck == 0)
+                {
+                    m_StepsToDriftCheck = m_StepsPerDriftCheck;
+                    m_TerminatedByDrift = CheckInvariants();
+                }
+
+                // In real time mode, hold the output back until its wall clock time.
+                const bool outputStep = !m_RealTime || m_Pacer.WaitForStep(m_ElapsedTime - stepStartTime);
 
                 // Visualize -- stdout for now, but could be something more sophisticated
                 // upate graphics, etc..
-                if(m_PrintStatus)
                 {
-                    PrintStatus(elapsedTime); 
+                    [[maybe_unused]] const auto outputScope = m_Instrumentation.Time(Instrumentation::Phase::Output);
+
+                    if(m_PrintStatus && outputStep)
+                    {
+                        PrintStatus(m_ElapsedTime); 
+                    }
+
+                    if(m_OutputSink && outputStep)
+                    {
+                        m_OutputSink(m_ElapsedTime, m_DynEntity.m_State);
+                    }
+
+                    if(m_CheckpointSink && m_ElapsedTime >= m_NextCheckpointTime)
+                    {
+                        m_CheckpointSink(GetCheckpoint());
+                        m_NextCheckpointTime += m_CheckpointInterval;
+                    }
+                }
+
+                if(m_TerminatedByEvent || m_TerminatedByDrift)
+                {
+                    break;
                 }
             }
 
@@ -61,6 +243,245 @@ public:
         }
     }
 
+    // Watches g(state) for sign changes in the given direction. Crossings
+    // are checked after every step and located inside the step by
+    // bisection, to within EventTimeTolerance. A Terminate event ends
+    // Run() at the crossing, a Record event is logged and Run() goes on.
+    void AddEvent(EventFunction function, EventDirection direction, EventAction action)
+    {
+        m_Events.push_back(Event{std::move(function), direction, action});
+        m_EventValues.push_back(0.0);
+    }
+
+    // Events which fired during Run(), in time order.
+    const std::vector<EventRecord>& GetEventRecords() const
+    {
+        return m_EventRecords;
+    }
+
+    // True if Run() was ended by a Terminate event rather than m_Duration.
+    bool WasTerminatedByEvent() const
+    {
+        return m_TerminatedByEvent;
+    }
+
+    // Tracks the drift of DynamicEntityType's conserved quantities,
+    // relative to their values at the start of Run(), every
+    // stepsPerCheck steps. When a quantity first drifts more than
+    // maxRelDrift, alarm is called, if given, and a Terminate action
+    // ends Run() after that step. Each check costs one
+    // ConservedQuantities() evaluation, see Integrators_Bench.
+    void SetInvariantMonitor(double maxRelDrift, EventAction action, DriftAlarm alarm = DriftAlarm{}, size_t stepsPerCheck = 1)
+    {
+        static_assert(Invariants::HasConservedQuantities<DynamicEntityType>::value,
+            "Invariant monitoring needs DynamicEntityType::ConservedQuantities");
+
+        m_MonitorInvariants = true;
+        m_MaxRelDrift = maxRelDrift;
+        m_DriftAction = action;
+        m_DriftAlarm = std::move(alarm);
+        m_StepsPerDriftCheck = std::max<size_t>(stepsPerCheck, 1);
+    }
+
+    // Largest drift of each conserved quantity during the last Run(),
+    // in the order of DynamicEntityType::ConservedNames.
+    const InvariantDrifts& GetMaxInvariantDrift() const
+    {
+        return m_DriftMonitor.GetMaxDrift();
+    }
+
+    // True if Run() was ended by a conserved quantity over budget.
+    bool WasTerminatedByDrift() const
+    {
+        return m_TerminatedByDrift;
+    }
+
+    // Simulation time reached by Run().
+    double GetElapsedTime() const
+    {
+        return m_ElapsedTime;
+    }
+
+    // Error control of an adaptive Integrator, eg
+    // Integrators::DormandPrince. m_DeltaT is its initial step.
+    void SetTolerances(const Integrators::AdaptiveTolerances& tolerances)
+    {
+        static_assert(Adaptive, "Tolerances need an adaptive Integrator, eg Integrators::DormandPrince");
+        m_Integrator.SetTolerances(tolerances);
+    }
+
+    // Keeps the state and its derivatives after every step of Run(), so
+    // that StateAt() can interpolate between steps. Costs one derivative
+    // evaluation per step, none with adaptive stepping. With
+    // recordHistory false only the last step is kept, in fixed memory.
+    void SetDenseOutput(bool recordHistory)
+    {
+        m_DenseOutput = true;
+        m_DenseHistory = recordHistory;
+    }
+
+    // State at time t, interpolated inside the step containing it, see
+    // Integrators::HermiteInterpolate. Returns false if t is not within
+    // the kept steps of the last Run().
+    bool StateAt(double t, typename DynamicEntityType::State& outState) const
+    {
+        if(m_DenseKnots.empty() || t < m_DenseKnots.front().m_Time || t > m_DenseKnots.back().m_Time)
+        {
+            return false;
+        }
+
+        // First knot after t, the step ends there.
+        auto after = std::upper_bound(m_DenseKnots.begin(), m_DenseKnots.end(), t, [](double time, const DenseKnot& knot)
+        {
+            return time < knot.m_Time;
+        });
+        if(after == m_DenseKnots.end())
+        {
+            outState = m_DenseKnots.back().m_State;
+            return true;
+        }
+
+        const DenseKnot& before = *(after - 1);
+        const double stepSize = after->m_Time - before.m_Time;
+        outState = Integrators::HermiteInterpolate(before.m_State, before.m_Derivs, after->m_State, after->m_Derivs,
+            stepSize, (t - before.m_Time) / stepSize);
+
+        if constexpr (Integrators::HasProjectState<DynamicEntityType>::value)
+        {
+            m_DynEntity.ProjectState(outState);
+        }
+        return true;
+    }
+
+    // Runs in lockstep with the wall clock, see RealTime.h. Every step
+    // is output at its deadline, start of Run() plus simulation time
+    // over config.m_TimeScale.
+    void SetRealTime(const RealTime::Config& config)
+    {
+        m_RealTime = true;
+        m_Pacer.SetConfig(config);
+    }
+
+    // Jitter, deadline misses and catch up of the last real time Run().
+    const RealTime::Stats& GetRealTimeStats() const
+    {
+        return m_Pacer.GetStats();
+    }
+
+    // Snapshot of the run as it stands, eg after Run() reached m_Duration
+    // or from inside a CheckpointSink.
+    Checkpoint GetCheckpoint() const
+    {
+        return Checkpoint{m_DynEntity, m_ElapsedTime, m_Integrator, m_StepStats};
+    }
+
+    // Makes the next Run() continue from checkpoint until m_Duration. Any
+    // number of Simulations may be restored from one checkpoint to fork
+    // continuations, eg after editing checkpoint.m_DynEntity.
+    void Restore(const Checkpoint& checkpoint)
+    {
+        static_cast<DynamicEntityType&>(m_DynEntity) = checkpoint.m_DynEntity;
+        m_StartTime = checkpoint.m_ElapsedTime;
+        m_ElapsedTime = checkpoint.m_ElapsedTime;
+        m_Integrator = checkpoint.m_Integrator;
+        m_StepStats = checkpoint.m_StepStats;
+
+        // The checkpoint's state may have been edited, so Dormand-Prince's
+        // reused derivatives are recomputed. Same bits if it was not.
+        if constexpr (Adaptive)
+        {
+            m_Integrator.ResetDerivs();
+        }
+    }
+
+    // Hands a checkpoint to checkpointSink every interval seconds of
+    // simulation time during Run().
+    void SetCheckpointInterval(double interval, CheckpointSink checkpointSink)
+    {
+        m_CheckpointInterval = interval;
+        m_CheckpointSink = std::move(checkpointSink);
+    }
+
+    // Binary checkpoint files. The header names the entity and
+    // integrator and the size of the checkpoint, the body is the raw
+    // Checkpoint, so a restore is bit exact. Files are only valid for
+    // the same build on the same kind of machine.
+    static bool WriteCheckpoint(std::ostream& out, const Checkpoint& checkpoint)
+    {
+        static_assert(std::is_trivially_copyable<Checkpoint>::value, "Checkpoint must be trivially copyable");
+
+        const CheckpointHeader header = MakeCheckpointHeader();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&checkpoint), sizeof(checkpoint));
+        return out.good();
+    }
+
+    // Reads a checkpoint written by WriteCheckpoint into inOutCheckpoint.
+    // Returns false, leaving it unchanged, if the file does not match
+    // this Simulation type.
+    static bool ReadCheckpoint(std::istream& in, Checkpoint& inOutCheckpoint)
+    {
+        static_assert(std::is_trivially_copyable<Checkpoint>::value, "Checkpoint must be trivially copyable");
+
+        const CheckpointHeader expected = MakeCheckpointHeader();
+        CheckpointHeader header;
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if(!in.good() || memcmp(&header, &expected, sizeof(header)) != 0)
+        {
+            std::cout << "Checkpoint does not match simulation type.\n";
+            return false;
+        }
+
+        alignas(Checkpoint) char buffer[sizeof(Checkpoint)];
+        in.read(buffer, sizeof(buffer));
+        if(!in.good())
+        {
+            std::cout << "Checkpoint is truncated.\n";
+            return false;
+        }
+
+        memcpy(static_cast<void*>(&inOutCheckpoint), buffer, sizeof(buffer));
+        return true;
+    }
+
+    // Restores from a checkpoint file, see ReadCheckpoint.
+    bool LoadCheckpoint(std::istream& in)
+    {
+        Checkpoint checkpoint = GetCheckpoint();
+        if(!ReadCheckpoint(in, checkpoint))
+        {
+            return false;
+        }
+
+        Restore(checkpoint);
+        return true;
+    }
+
+    // Streams states to outputSink during Run(). Pass an empty sink to stop.
+    void SetOutputSink(OutputSink outputSink)
+    {
+        m_OutputSink = std::move(outputSink);
+    }
+
+    // Accepted, rejected and failed steps and derivative evaluations of
+    // Run().
+    const Integrators::StepStats& GetStepStats() const
+    {
+        return m_StepStats;
+    }
+
+    // Counters and phase timings of the last Run(), and its trace if
+    // enabled, when InstrumentationPolicy is Instrumentation::Enabled.
+    const InstrumentationPolicy& GetInstrumentation() const
+    {
+        return m_Instrumentation;
+    }
+
+    InstrumentationPolicy& GetInstrumentation()
+    {
+        return m_Instrumentation;
+    }
+
     // This is sort of a dummy implementatoin of getting the
     // final simulation output. 
     SimulationOutputType GetOutput() const
@@ -70,18 +491,297 @@ public:
 
 private:
 
-    // Writes output to stdout
+    static constexpr double EventTimeTolerance = 1.0e-10;  // in seconds.
+
+    struct CheckpointHeader
+    {
+        char m_Magic[8];
+        uint64_t m_Size;
+        char m_EntityName[32];
+        char m_IntegratorName[32];
+    };
+
+    static CheckpointHeader MakeCheckpointHeader()
+    {
+        CheckpointHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.m_Magic, "RBPCKPT", 8);
+        header.m_Size = sizeof(Checkpoint);
+        strncpy(header.m_EntityName, DynamicEntityType::Name, sizeof(header.m_EntityName) - 1);
+        strncpy(header.m_IntegratorName, Integrator<DynamicEntityType>::Name, sizeof(header.m_IntegratorName) - 1);
+        return header;
+    }
+
+    struct Event
+    {
+        EventFunction m_Function;
+        EventDirection m_Direction;
+        EventAction m_Action;
+    };
+
+    // State and derivatives at one step boundary, for StateAt().
+    struct DenseKnot
+    {
+        double m_Time;                          // in seconds.
+        typename DynamicEntityType::State m_State;
+        typename DynamicEntityType::State m_Derivs;
+    };
+
+    // Dormand-Prince already has the derivatives at the current
+    // state, unless an event moved it.
+    void RecordDenseKnot()
+    {
+        DenseKnot knot{m_ElapsedTime, m_DynEntity.m_State, m_DynEntity.m_State};
+        bool hasDerivs = false;
+        if constexpr (Adaptive)
+        {
+            hasDerivs = m_Integrator.HasDerivs();
+            if(hasDerivs)
+            {
+                knot.m_Derivs = m_Integrator.GetDerivs();
+            }
+        }
+
+        if(!hasDerivs)
+        {
+            knot.m_Derivs = m_DynEntity.CalcDerivs();
+            ++m_StepStats.m_DerivEvals;
+        }
+
+        // Steps of zero length, eg an event at the step start, add nothing.
+        if(!m_DenseKnots.empty() && m_DenseKnots.back().m_Time >= knot.m_Time)
+        {
+            m_DenseKnots.back() = knot;
+            return;
+        }
+
+        if(!m_DenseHistory && m_DenseKnots.size() == 2)
+        {
+            m_DenseKnots.erase(m_DenseKnots.begin());
+        }
+        m_DenseKnots.push_back(knot);
+    }
+
+    // Advances m_DynEntity and m_ElapsedTime by one step.
+    void Advance()
+    {
+        if constexpr (Adaptive)
+        {
+            // Adaptive steps are clipped to land exactly on m_Duration.
+            const double timeLeft = m_Duration - m_ElapsedTime;
+            const double stepTaken = m_Integrator.Step(m_DynEntity, timeLeft, m_StepStats);
+            m_ElapsedTime = (stepTaken < timeLeft) ? m_ElapsedTime + stepTaken : m_Duration;
+        }
+        else
+        {
+            m_StepStats.m_DerivEvals += m_Integrator.Step(m_DynEntity, m_DeltaT);
+            m_ElapsedTime += m_DeltaT;
+            ++m_StepStats.m_AcceptedSteps;
+            CountFailedStep(m_Integrator);
+        }
+    }
+
+    // Steps a copy of start by deltaT with the scheme Run() uses. Used
+    // to locate events, so it leaves the run's integrator state alone.
+    StepEntity StepFrom(const StepEntity& start, double deltaT)
+    {
+        StepEntity dynEntity = start;
+
+        if constexpr (Adaptive)
+        {
+            Integrator<StepEntity> integrator;
+            integrator.SetTolerances(m_Integrator.GetTolerances());
+            integrator.SetDeltaT(deltaT);
+            double stepped = 0.0;
+            while(stepped < deltaT)
+            {
+                const double timeLeft = deltaT - stepped;
+                const double stepTaken = integrator.Step(dynEntity, timeLeft, m_StepStats);
+                stepped = (stepTaken < timeLeft) ? stepped + stepTaken : deltaT;
+            }
+        }
+        else
+        {
+            Integrator<StepEntity> integrator;
+            m_StepStats.m_DerivEvals += integrator.Step(dynEntity, deltaT);
+            CountFailedStep(integrator);
+        }
+
+        return dynEntity;
+    }
+
+    void CountFailedStep(const Integrator<StepEntity>& integrator)
+    {
+        if constexpr (Integrators::CanFailStep<Integrator<StepEntity>>::value)
+        {
+            if(integrator.LastStepFailed())
+            {
+                ++m_StepStats.m_FailedSteps;
+            }
+        }
+    }
+
+    static bool IsCrossing(EventDirection direction, double before, double after)
+    {
+        const bool rising = before < 0.0 && after >= 0.0;
+        const bool falling = before > 0.0 && after <= 0.0;
+
+        switch(direction)
+        {
+            case EventDirection::Rising:    return rising;
+            case EventDirection::Falling:   return falling;
+            case EventDirection::Either:    return rising || falling;
+        }
+
+        return false;
+    }
+
+    // Checks every event across the step just taken from m_StepStart.
+    // Crossings are located and recorded in time order. Returns true,
+    // with the simulation moved back to the crossing, if a Terminate
+    // event fired.
+    bool ProcessEvents(double stepStartTime)
+    {
+        const double stepSize = m_ElapsedTime - stepStartTime;
+
+        std::vector<EventRecord> fired;
+        for(size_t eventIdx = 0; eventIdx < m_Events.size(); ++eventIdx)
+        {
+            const Event& event = m_Events[eventIdx];
+            const double before = m_EventValues[eventIdx];
+            const double after = event.m_Function(m_DynEntity.m_State);
+            m_EventValues[eventIdx] = after;
+
+            if(!IsCrossing(event.m_Direction, before, after))
+            {
+                continue;
+            }
+
+            // Bisect on the time into the step, keeping the crossing
+            // between lower and upper. The state past the crossing is
+            // reported, so g has crossed in the recorded state.
+            double lower = 0.0;
+            double upper = stepSize;
+            StepEntity upperEntity = m_DynEntity;
+            while(upper - lower > EventTimeTolerance)
+            {
+                const double mid = 0.5 * (lower + upper);
+                const StepEntity midEntity = StepFrom(m_StepStart, mid);
+                if(IsCrossing(event.m_Direction, before, event.m_Function(midEntity.m_State)))
+                {
+                    upper = mid;
+                    upperEntity = midEntity;
+                }
+                else
+                {
+                    lower = mid;
+                }
+            }
+
+            fired.push_back(EventRecord{eventIdx, stepStartTime + upper, upperEntity.m_State});
+        }
+
+        std::sort(fired.begin(), fired.end(), [](const EventRecord& a, const EventRecord& b)
+        {
+            return a.m_Time < b.m_Time;
+        });
+
+        for(const EventRecord& record : fired)
+        {
+            m_EventRecords.push_back(record);
+
+            if(m_Events[record.m_EventIdx].m_Action == EventAction::Terminate)
+            {
+                m_DynEntity.m_State = record.m_State;
+                m_ElapsedTime = record.m_Time;
+
+                // Dormand-Prince's reused derivatives and the event
+                // values belong to the discarded end of the step.
+                if constexpr (Adaptive)
+                {
+                    m_Integrator.ResetDerivs();
+                }
+                UpdateEventValues();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Evaluates every event function at the current state.
+    void UpdateEventValues()
+    {
+        for(size_t eventIdx = 0; eventIdx < m_Events.size(); ++eventIdx)
+        {
+            m_EventValues[eventIdx] = m_Events[eventIdx].m_Function(m_DynEntity.m_State);
+        }
+    }
+
+    // Checks the drift of the conserved quantities at the current
+    // state. Returns true if Run() should stop.
+    bool CheckInvariants()
+    {
+        const bool exceeded = m_DriftMonitor.Check(m_DynEntity, m_MaxRelDrift, [this](size_t quantityIdx, double drift)
+        {
+            if(m_DriftAlarm)
+            {
+                m_DriftAlarm(m_ElapsedTime, quantityIdx, drift);
+            }
+        });
+
+        return exceeded && m_DriftAction == EventAction::Terminate;
+    }
+
+    // Writes output to stdout. The text buffer is shared by every
+    // simulation on the thread, so printing does not allocate.
     void PrintStatus(double currTime)
     {
-        const std::string dynState = m_DynEntity.ReportState();
-        std::cout << "****************************************\n";
-        std::cout << "t = " << currTime << ", \n " << dynState << "\n";   
+        static thread_local TextOutput::TextBuffer statusText(1024);
+        statusText.Clear();
+        TextOutput::AppendStatus<DynamicEntityType>(statusText, currTime, m_DynEntity.m_State);
+        statusText.WriteTo(std::cout);
     }
 
 private:
     const double m_Duration;        // in seconds.
     const double m_DeltaT;          // in seconds.
     const bool m_PrintStatus;
-    DynamicEntityType m_DynEntity;  // Must conform to DynamicEntity interface 
+    StepEntity m_DynEntity;         // Must conform to DynamicEntity interface 
                                     // as described in DynamicEntity.cpp 
+
+    Integrator<StepEntity> m_Integrator;
+    Integrators::StepStats m_StepStats;
+    OutputSink m_OutputSink;
+
+    double m_ElapsedTime = 0.0;     // in seconds.
+    double m_StartTime = 0.0;       // in seconds, where Run() starts.
+
+    double m_CheckpointInterval = 0.0;      // in seconds.
+    double m_NextCheckpointTime = 0.0;      // in seconds.
+    CheckpointSink m_CheckpointSink;
+
+    std::vector<Event> m_Events;
+    std::vector<double> m_EventValues;      // g of each event at m_ElapsedTime.
+    std::vector<EventRecord> m_EventRecords;
+    StepEntity m_StepStart;                 // Entity at the start of the step, if there are events.
+    bool m_TerminatedByEvent = false;
+
+    InstrumentationPolicy m_Instrumentation;
+
+    bool m_RealTime = false;
+    RealTime::Pacer m_Pacer;
+
+    bool m_DenseOutput = false;
+    bool m_DenseHistory = false;
+    std::vector<DenseKnot> m_DenseKnots;    // By time, the last two only without history.
+
+    bool m_MonitorInvariants = false;
+    double m_MaxRelDrift = 0.0;
+    EventAction m_DriftAction = EventAction::Record;
+    DriftAlarm m_DriftAlarm;
+    size_t m_StepsPerDriftCheck = 1;
+    size_t m_StepsToDriftCheck = 1;
+    Invariants::DriftMonitor<DynamicEntityType> m_DriftMonitor;
+    bool m_TerminatedByDrift = false;
 };
\ No newline at end of file
@@ -1,15 +1,103 @@
 #include "./Simulation.h"
 #include "./DynamicEntities.h"
+#include "./IntegratorSelection.h"
 #include "./TestUtils.h"
 
+#include <cmath>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
 
 //////////////////////////////////////////////////////////
 // Simulation Unit Tests
+// Usage: ./Simulation_Test [--float]
+// --float only runs the scenarios below in float and double
+// and prints the largest deviation of each.
 //////////////////////////////////////////////////////////
 
-int main(void)
+namespace
 {
+
+// Largest difference between the float and double final states of
+// one scenario, relative to max(1, |double|) so that positions and
+// rates compare alike. Printed with its field if verbose.
+template <template <typename> class EntityT, template <typename> class Integrator = Integrators::MidPoint>
+double FloatDeviation(const std::string& scenario, bool verbose,
+    const typename EntityT<double>::State& state, const typename EntityT<double>::Params& params,
+    double duration, double deltaT)
+{
+    typename EntityT<float>::State floatState;
+    std::copy(state.begin(), state.end(), floatState.begin());
+    typename EntityT<float>::Params floatParams;
+    std::copy(params.begin(), params.end(), floatParams.begin());
+
+    Simulation<EntityT<double>, Integrator> simDouble(duration, deltaT, false, EntityT<double>(state, params));
+    Simulation<EntityT<float>, Integrator> simFloat(duration, deltaT, false, EntityT<float>(floatState, floatParams));
+    if (!simDouble.Run() || !simFloat.Run())
+    {
+        return HUGE_VAL;
+    }
+
+    double maxDeviation = 0.0;
+    size_t maxField = 0;
+    for (size_t field = 0; field < state.size(); ++field)
+    {
+        const double expected = simDouble.GetOutput()[field];
+        const double deviation = std::abs(simFloat.GetOutput()[field] - expected) / std::max(1.0, std::abs(expected));
+        if (deviation > maxDeviation)
+        {
+            maxDeviation = deviation;
+            maxField = field;
+        }
+    }
+
+    if (verbose)
+    {
+        std::cout << "Float Deviation: " << scenario << ", " << maxDeviation
+            << " in " << EntityT<double>::FieldNames[maxField] << "\n";
+    }
+    return maxDeviation;
+}
+
+// The scenarios of main() over float. Returns the largest deviation.
+double RunFloatScenarios(bool verbose)
+{
+    const std::array<double, 3> cylinder = {10.0, 10.0, 1.0};
+    const double deviations[] = {
+        FloatDeviation<ConstantVelParticleT>("CVP", verbose, {1.0, 1.0}, {}, 1, 0.1),
+        FloatDeviation<SimpleSpringMotionT>("SHM", verbose, {1.0, 0.0}, {10.0}, 2.1, 0.01),
+        FloatDeviation<SimpleSpringMotionT, Integrators::Euler>("Spring Euler", verbose, {1.0, 0.0}, {4.0}, 1.0 - 0.005, 0.01),
+        FloatDeviation<SimpleSpringMotionT, Integrators::MidPoint>("Spring MidPoint", verbose, {1.0, 0.0}, {4.0}, 1.0 - 0.005, 0.01),
+        FloatDeviation<SimpleSpringMotionT, Integrators::RK4>("Spring RK4", verbose, {1.0, 0.0}, {4.0}, 1.0 - 0.005, 0.01),
+        FloatDeviation<SimpleSpringMotionT, Integrators::VelocityVerlet>("Spring VelocityVerlet", verbose, {1.0, 0.0}, {4.0}, 1.0 - 0.005, 0.01),
+        FloatDeviation<CrudeSpinningPenT>("CPM No Spin", verbose,
+            {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 0.0}, cylinder, 2.04, .01),
+        FloatDeviation<CrudeSpinningPenT>("CPM Z Spin", verbose,
+            {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 10.0}, cylinder, 2.04, .01),
+        FloatDeviation<CrudeSpinningPenT>("CPM Flat", verbose,
+            {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 0.0}, cylinder, 2.04, .01),
+        FloatDeviation<CrudeSpinningPenT>("CPM Precession", verbose,
+            {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0}, cylinder, 2.04, .01),
+        FloatDeviation<QuaternionSpinningPenT, Integrators::RK4>("QSP Precession", verbose,
+            {0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0}, cylinder, 2.04, .02),
+        FloatDeviation<QuaternionSpinningPenT, Integrators::RK4>("QSP Z Spin", verbose,
+            {0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 10.0}, cylinder, 0.2 - .005, .01)};
+
+    return *std::max_element(std::begin(deviations), std::end(deviations));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--float")
+    {
+        const double maxDeviation = RunFloatScenarios(true);
+        std::cout << "Max Float Deviation: " << maxDeviation << "\n";
+        return 0;
+    }
+
     //////////////////////////////////////////////////////////
     // Test of ConstantVelParticle based sim.
     {
@@ -30,6 +118,54 @@ int main(void)
         TestUtils::ReportResults(isValidShm, "SHM Test: isValid");
     }
 
+    //////////////////////////////////////////////////////////
+    // Integrator policies:
+    // Spring, x = cos(2t), stepped with each fixed step policy.
+    // Fourth order RK4 should land much closer than the others.
+    {
+        SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        const double duration = 1.0 - 0.005;    // 100 steps, see Adaptive precession.
+        const SimpleSpringMotion::State expected{std::cos(2.0), -2.0 * std::sin(2.0)};
+
+        Simulation<SimpleSpringMotion, Integrators::Euler> simEuler(duration, 0.01, false, shm);
+        Simulation<SimpleSpringMotion, Integrators::MidPoint> simMid(duration, 0.01, false, shm);
+        Simulation<SimpleSpringMotion, Integrators::RK4> simRK4(duration, 0.01, false, shm);
+        Simulation<SimpleSpringMotion, Integrators::VelocityVerlet> simVerlet(duration, 0.01, false, shm);
+        const bool isValid = simEuler.Run() && simMid.Run() && simRK4.Run() && simVerlet.Run();
+        TestUtils::ReportResults(isValid, "Integrator Policy Test: isValid");
+
+        const bool statesEq = TestUtils::FloatEquals(simEuler.GetOutput(), expected, 0.05) &&
+            TestUtils::FloatEquals(simMid.GetOutput(), expected, 1.0e-3) &&
+            TestUtils::FloatEquals(simRK4.GetOutput(), expected, 1.0e-8) &&
+            TestUtils::FloatEquals(simVerlet.GetOutput(), expected, 1.0e-3);
+        TestUtils::ReportResults(statesEq, "Integrator Policy Test: States Equal");
+
+        const bool evalsEq = simEuler.GetStepStats().m_DerivEvals == 100 &&
+            simMid.GetStepStats().m_DerivEvals == 200 &&
+            simRK4.GetStepStats().m_DerivEvals == 400 &&
+            simVerlet.GetStepStats().m_DerivEvals == 101;
+        TestUtils::ReportResults(evalsEq, "Integrator Policy Test: Derivative Evaluations");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Runtime integrator selection:
+    // Matches the compile time policy it names.
+    {
+        SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+
+        IntegratorKind kind = IntegratorKind::Euler;
+        const bool parsed = ParseIntegratorKind("RK4", kind) && kind == IntegratorKind::RK4 &&
+            !ParseIntegratorKind("rk5", kind) && kind == IntegratorKind::RK4;
+        TestUtils::ReportResults(parsed, "Integrator Selection Test: Parse");
+
+        const SelectedRunResult<SimpleSpringMotion> selected = RunSimulation(kind, 1.0, 0.01, false, shm);
+        Simulation<SimpleSpringMotion, Integrators::RK4> simRK4(1.0, 0.01, false, shm);
+        simRK4.Run();
+
+        const bool statesEq = selected.m_IsValid && TestUtils::FloatEquals(selected.m_Output, simRK4.GetOutput(), 0.0);
+        TestUtils::ReportResults(statesEq, "Integrator Selection Test: Matches Policy");
+    }
+
     //////////////////////////////////////////////////////////
     // No spin:
     // Pen lauched in with horiz and vertical vels
@@ -256,4 +392,484 @@ int main(void)
         const bool phi_dotNotZero = outputActual[10] != 0.0;
         TestUtils::ReportResults(phi_dotNotZero, "CPM Test: phi_dotNotZero");
     }
+
+    //////////////////////////////////////////////////////////
+    // Quaternion precession:
+    // Torque free precession as above with the quaternion pen, at
+    // twice the step size. Body rates follow the same Euler
+    // equations, world frame angular momentum must be conserved and
+    // the quaternion must stay normalized.
+    {
+        const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+        const QuaternionSpinningPen::State penStateInput{
+            // x, y, z
+            0.0, 0.0, 0.0,
+            // q_w, q_x, q_y, q_z
+            1.0, 0.0, 0.0, 0.0,
+            // vx, vy, vz
+            0.0, 0.0, 10.0,
+            // omega_x, omega_y, omega_z
+            10.0, 0.0, 10.0
+        };
+        QuaternionSpinningPen qsp(penStateInput, inertia);
+
+        auto worldMomentum = [&](const QuaternionSpinningPen& pen)
+        {
+            const std::array<double, 3> bodyMomentum{
+                inertia[0]*pen.m_State[10], inertia[1]*pen.m_State[11], inertia[2]*pen.m_State[12]};
+            return pen.BodyToWorld(bodyMomentum);
+        };
+
+        Simulation<QuaternionSpinningPen, Integrators::RK4> simQsp(2.04, .02, false, qsp);
+        const bool isValidQsp = simQsp.Run();
+        TestUtils::ReportResults(isValidQsp, "QSP Test: isValid");
+
+        QuaternionSpinningPen finalPen = qsp;
+        finalPen.m_State = simQsp.GetOutput();
+        const bool momentumEq = TestUtils::FloatEquals(worldMomentum(finalPen), worldMomentum(qsp), 1.0e-2);
+        TestUtils::ReportResults(momentumEq, "QSP Test: Angular Momentum Conserved");
+
+        const double norm = std::sqrt(finalPen.m_State[3]*finalPen.m_State[3] + finalPen.m_State[4]*finalPen.m_State[4] +
+            finalPen.m_State[5]*finalPen.m_State[5] + finalPen.m_State[6]*finalPen.m_State[6]);
+        TestUtils::ReportResults(std::abs(norm - 1.0) < 1.0e-12, "QSP Test: Quaternion Normalized");
+
+        const CrudeSpinningPen::State cspStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0};
+        Simulation<CrudeSpinningPen, Integrators::RK4> simCsp(2.04, .02, false, CrudeSpinningPen(cspStateInput, inertia));
+        simCsp.Run();
+        const std::array<double, 3> cspRates{simCsp.GetOutput()[9], simCsp.GetOutput()[10], simCsp.GetOutput()[11]};
+        const std::array<double, 3> qspRates{finalPen.m_State[10], finalPen.m_State[11], finalPen.m_State[12]};
+        TestUtils::ReportResults(TestUtils::FloatEquals(qspRates, cspRates, 1.0e-12), "QSP Test: Body Rates Equal");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Quaternion z-spin:
+    // Spin about the symmetry axis only, yaw grows linearly.
+    {
+        const QuaternionSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 0.0, 0.0, 10.0};
+        QuaternionSpinningPen qsp(penStateInput, {10.0, 10.0, 1.0});
+
+        Simulation<QuaternionSpinningPen, Integrators::RK4> simQsp(0.2 - .005, .01, false, qsp);
+        simQsp.Run();
+
+        QuaternionSpinningPen finalPen = qsp;
+        finalPen.m_State = simQsp.GetOutput();
+        const bool anglesEq = TestUtils::FloatEquals(finalPen.GetEulerAngles(), std::array<double, 3>{0.0, 0.0, 2.0}, 1.0e-6);
+        TestUtils::ReportResults(anglesEq, "QSP Test: Z Spin Angles Equal");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Ground impact event:
+    // Pen tossed from the ground with a long duration. The run must
+    // stop at impact, t = 2 vz / g, after recording the apex where
+    // vz falls through zero.
+    {
+        const CrudeSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 0.0, 10.0, 0.0, 0.0, 10.0};
+        CrudeSpinningPen csp(penStateInput, {10.0, 10.0, 1.0});
+
+        using PenSimulation = Simulation<CrudeSpinningPen>;
+        PenSimulation simCsp(10.0, .01, false, csp);
+        simCsp.AddEvent([](const CrudeSpinningPen::State& state){ return state[8]; },
+            PenSimulation::EventDirection::Falling, PenSimulation::EventAction::Record);
+        simCsp.AddEvent([](const CrudeSpinningPen::State& state){ return state[2]; },
+            PenSimulation::EventDirection::Falling, PenSimulation::EventAction::Terminate);
+        const bool isValidCsp = simCsp.Run();
+        TestUtils::ReportResults(isValidCsp && simCsp.WasTerminatedByEvent(), "Event Test: Terminated");
+
+        const double impactTime = 2.0 * 10.0 / 9.8;
+        const std::vector<PenSimulation::EventRecord>& records = simCsp.GetEventRecords();
+        const bool recordsEq = records.size() == 2 &&
+            records[0].m_EventIdx == 0 && std::abs(records[0].m_Time - 0.5 * impactTime) < 1.0e-8 &&
+            records[1].m_EventIdx == 1 && std::abs(records[1].m_Time - impactTime) < 1.0e-8;
+        TestUtils::ReportResults(recordsEq, "Event Test: Apex And Impact Located");
+
+        const CrudeSpinningPen::State outputActual = simCsp.GetOutput();
+        const bool statesEq = std::abs(simCsp.GetElapsedTime() - impactTime) < 1.0e-8 &&
+            std::abs(outputActual[0] - 10.0 * impactTime) < 1.0e-6 &&
+            std::abs(outputActual[2]) < 1.0e-6 &&
+            simCsp.GetStepStats().m_AcceptedSteps == 205;
+        TestUtils::ReportResults(statesEq, "Event Test: Stopped At Impact");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Adaptive run stopped by an event: the checkpoint must not
+    // carry Dormand-Prince derivatives from the discarded end of
+    // the step.
+    {
+        const CrudeSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 0.0, 10.0, 0.0, 0.0, 10.0};
+        CrudeSpinningPen csp(penStateInput, {10.0, 10.0, 1.0});
+
+        using PenSimulation = Simulation<CrudeSpinningPen, Integrators::DormandPrince>;
+        PenSimulation simCsp(10.0, .01, false, csp);
+        simCsp.AddEvent([](const CrudeSpinningPen::State& state){ return state[2]; },
+            PenSimulation::EventDirection::Falling, PenSimulation::EventAction::Terminate);
+        const bool isValidCsp = simCsp.Run() && simCsp.WasTerminatedByEvent();
+
+        const PenSimulation::Checkpoint checkpoint = simCsp.GetCheckpoint();
+        const bool derivsEq = !checkpoint.m_Integrator.HasDerivs() ||
+            checkpoint.m_Integrator.GetDerivs() == checkpoint.m_DynEntity.CalcDerivs();
+        TestUtils::ReportResults(isValidCsp && derivsEq, "Event Test: Adaptive Checkpoint At Impact");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Implicit run whose Newton iteration cannot converge, capped
+    // at one iteration through a checkpoint: Run() must stop after
+    // the failed step and report it.
+    {
+        using StiffSimulation = Simulation<SimpleSpringMotion, Integrators::Trapezoidal>;
+        const SimpleSpringMotion stiff{SimpleSpringMotion::State{1.0, 0.0}, 1.0e6};
+        StiffSimulation simConverged(1.0, .01, false, stiff);
+        const bool isValidConverged = simConverged.Run() && simConverged.GetStepStats().m_FailedSteps == 0;
+
+        StiffSimulation::Checkpoint capped = StiffSimulation(1.0, .01, false, stiff).GetCheckpoint();
+        capped.m_Integrator.m_Settings.m_MaxIterations = 1;
+        StiffSimulation simCapped(1.0, .01, false, stiff);
+        simCapped.Restore(capped);
+        const bool failedEq = !simCapped.Run() && simCapped.GetStepStats().m_FailedSteps == 1 &&
+            simCapped.GetElapsedTime() == .01;
+        TestUtils::ReportResults(isValidConverged && failedEq, "Implicit Test: Newton Failure Fails Run");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Adaptive run from a non-finite state: Run() must stop after
+    // the failed step and report it.
+    {
+        SimpleSpringMotion shm{SimpleSpringMotion::State{std::nan(""), 0.0}, 4.0};
+        Simulation<SimpleSpringMotion, Integrators::DormandPrince> simNan(1.0, .01, false, shm);
+        const bool failedEq = !simNan.Run() && simNan.GetStepStats().m_FailedSteps == 1 &&
+            simNan.GetElapsedTime() == .01;
+        TestUtils::ReportResults(failedEq, "Adaptive Test: Non-Finite State Fails Run");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Checkpoint and restore:
+    // A run resumed from a checkpoint file taken at t = 1 must match
+    // the uninterrupted run bit for bit, for fixed and adaptive
+    // stepping. Adaptive resumes recompute the first derivatives, one
+    // evaluation more. For fixed steps the checkpoint may also come
+    // from a run which was simply stopped at t = 1.
+    {
+        const CrudeSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+        CrudeSpinningPen csp(penStateInput, {10.0, 10.0, 1.0});
+
+        auto resumedMatches = [&](auto* simulationTag)
+        {
+            using ResumedSimulation = std::remove_pointer_t<decltype(simulationTag)>;
+            std::stringstream file;
+            ResumedSimulation simFull(2.04, .01, false, csp);
+            simFull.SetCheckpointInterval(1.0, [&](const typename ResumedSimulation::Checkpoint& checkpoint)
+            {
+                if (checkpoint.m_ElapsedTime < 2.0)
+                {
+                    ResumedSimulation::WriteCheckpoint(file, checkpoint);
+                }
+            });
+            simFull.Run();
+
+            ResumedSimulation simResumed(2.04, .01, false, CrudeSpinningPen(CrudeSpinningPen::State{}, {1.0, 1.0, 1.0}));
+            return simResumed.LoadCheckpoint(file) && simResumed.Run() &&
+                TestUtils::FloatEquals(simResumed.GetOutput(), simFull.GetOutput(), 0.0) &&
+                simResumed.GetElapsedTime() == simFull.GetElapsedTime() &&
+                simResumed.GetStepStats().m_DerivEvals == simFull.GetStepStats().m_DerivEvals + (ResumedSimulation::Adaptive ? 1 : 0);
+        };
+
+        using PenSimulation = Simulation<CrudeSpinningPen, Integrators::RK4>;
+        bool resumedEq = resumedMatches(static_cast<PenSimulation*>(nullptr)) &&
+            resumedMatches(static_cast<Simulation<CrudeSpinningPen, Integrators::DormandPrince>*>(nullptr));
+
+        PenSimulation simFull(2.04, .01, false, csp);
+        simFull.Run();
+        PenSimulation simFirst(1.0, .01, false, csp);
+        simFirst.Run();
+        PenSimulation simSecond(2.04, .01, false, csp);
+        simSecond.Restore(simFirst.GetCheckpoint());
+        simSecond.Run();
+        resumedEq = resumedEq && TestUtils::FloatEquals(simSecond.GetOutput(), simFull.GetOutput(), 0.0);
+        TestUtils::ReportResults(resumedEq, "Checkpoint Test: Resume Bit Exact");
+
+        // Checkpoint files of another simulation type are rejected.
+        std::stringstream file;
+        Simulation<CrudeSpinningPen> simMid(1.0, .01, false, csp);
+        Simulation<CrudeSpinningPen>::WriteCheckpoint(file, simMid.GetCheckpoint());
+        PenSimulation simRK4(1.0, .01, false, csp);
+        TestUtils::ReportResults(!simRK4.LoadCheckpoint(file), "Checkpoint Test: Reject Other Type");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Periodic checkpoints and forks:
+    // Checkpoints every 0.5 s. Forks from the t = 1 checkpoint, one
+    // unchanged and one with the spin removed, must match a full run
+    // and a run which never had spin in the last second respectively.
+    {
+        const CrudeSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+        CrudeSpinningPen csp(penStateInput, {10.0, 10.0, 1.0});
+
+        using PenSimulation = Simulation<CrudeSpinningPen>;
+        std::vector<PenSimulation::Checkpoint> checkpoints;
+        PenSimulation simFull(2.04, .01, false, csp);
+        simFull.SetCheckpointInterval(0.5, [&](const PenSimulation::Checkpoint& checkpoint)
+        {
+            checkpoints.push_back(checkpoint);
+        });
+        simFull.Run();
+        TestUtils::ReportResults(checkpoints.size() == 4, "Checkpoint Test: Periodic");
+
+        PenSimulation simFork(2.04, .01, false, csp);
+        simFork.Restore(checkpoints[1]);
+        simFork.Run();
+
+        PenSimulation::Checkpoint noSpin = checkpoints[1];
+        noSpin.m_DynEntity.m_State[9] = 0.0;
+        noSpin.m_DynEntity.m_State[11] = 0.0;
+        PenSimulation simNoSpinFork(2.04, .01, false, csp);
+        simNoSpinFork.Restore(noSpin);
+        simNoSpinFork.Run();
+
+        const CrudeSpinningPen::State forkOutput = simNoSpinFork.GetOutput();
+        const bool forksEq = TestUtils::FloatEquals(simFork.GetOutput(), simFull.GetOutput(), 0.0) &&
+            forkOutput[3] == noSpin.m_DynEntity.m_State[3] &&
+            forkOutput[5] == noSpin.m_DynEntity.m_State[5] &&
+            forkOutput[0] == simFull.GetOutput()[0];
+        TestUtils::ReportResults(forksEq, "Checkpoint Test: Forks");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Adaptive fork from an edited checkpoint: the first step must
+    // not reuse Dormand-Prince derivatives of the unedited state.
+    // Spring, x = 2.5 sin(2(t - 1)) after the edit at t = 1.
+    {
+        using SpringSimulation = Simulation<SimpleSpringMotion, Integrators::DormandPrince>;
+        const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        SpringSimulation simFirst(1.0, .01, false, shm);
+        simFirst.Run();
+
+        SpringSimulation::Checkpoint edited = simFirst.GetCheckpoint();
+        edited.m_DynEntity.m_State = SimpleSpringMotion::State{0.0, 5.0};
+        SpringSimulation simFork(2.0, .01, false, shm);
+        simFork.Restore(edited);
+        const bool isValidFork = simFork.Run();
+
+        SpringSimulation simFresh(1.0, .01, false, SimpleSpringMotion{SimpleSpringMotion::State{0.0, 5.0}, 4.0});
+        simFresh.Run();
+
+        const double exact = 2.5 * std::sin(2.0);
+        const bool forkEq = isValidFork && simFork.GetElapsedTime() == 2.0 &&
+            std::abs(simFork.GetOutput()[0] - exact) < 1.0e-5 &&
+            std::abs(simFork.GetOutput()[0] - simFresh.GetOutput()[0]) < 1.0e-5;
+        TestUtils::ReportResults(forkEq, "Checkpoint Test: Adaptive Edited Fork");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Adaptive precession:
+    // Same launch as above, stepped with Dormand-Prince. Compare
+    // against a fine fixed-step reference, and check the adaptive
+    // run needs less work than fixed steps of similar accuracy.
+    {        
+        const CrudeSpinningPen::State penStateInput{
+            // x, y, z
+            0.0,
+            0.0,
+            0.0,
+            // theta, phi, psi
+            0.0,
+            0.0,
+            0.0,
+            // vx, vy, vz
+            0.0,
+            0.0,
+            10.0,
+            // theta_dot, phi_dot, psi_dot
+            10.0,
+            0.0,
+            10.0
+        };
+
+        const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+        CrudeSpinningPen csp(penStateInput, inertia);
+
+        // Fixed steps run until elapsed time reaches the duration, so
+        // stop half a step short to take exactly 20400 steps.
+        Simulation simReference(2.04 - .00005, .0001, false, csp);
+        simReference.Run();
+
+        Simulation<CrudeSpinningPen, Integrators::DormandPrince> simAdaptive(2.04, .01, false, csp);
+        Integrators::AdaptiveTolerances tolerances;
+        tolerances.m_AbsTol = 1.0e-8;
+        tolerances.m_RelTol = 1.0e-8;
+        simAdaptive.SetTolerances(tolerances);
+        const bool isValidCsp = simAdaptive.Run();
+        TestUtils::ReportResults(isValidCsp, "CPM Test: isValid");
+
+        const bool statesEq = TestUtils::FloatEquals(simAdaptive.GetOutput(), simReference.GetOutput(), 1.0e-4);
+        TestUtils::ReportResults(statesEq, "CPM Test: Adaptive Precession States Equal");
+
+        const Integrators::StepStats& adaptiveStats = simAdaptive.GetStepStats();
+        const bool lessWork = adaptiveStats.m_DerivEvals < simReference.GetStepStats().m_DerivEvals;
+        TestUtils::ReportResults(lessWork, "CPM Test: Adaptive Fewer Derivative Evaluations");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Dense output:
+    // Spring, x = cos(2t), at a coarse RK4 step, sampled off the
+    // step grid. Interpolation error should stay at the level of
+    // the integration error.
+    {
+        SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        Simulation<SimpleSpringMotion, Integrators::RK4> simRK4(2.0, 0.1, false, shm);
+        simRK4.SetDenseOutput(true);
+        const bool isValid = simRK4.Run();
+
+        double maxError = 0.0;
+        bool allInside = true;
+        for (double t = 0.0; t <= 2.0; t += 0.0137)
+        {
+            SimpleSpringMotion::State state{};
+            allInside = allInside && simRK4.StateAt(t, state);
+            maxError = std::max(maxError, std::abs(state[0] - std::cos(2.0 * t)));
+            maxError = std::max(maxError, std::abs(state[1] + 2.0 * std::sin(2.0 * t)));
+        }
+
+        SimpleSpringMotion::State endState;
+        const bool endEq = simRK4.StateAt(simRK4.GetElapsedTime(), endState) && endState == simRK4.GetOutput();
+        SimpleSpringMotion::State outside;
+        const bool outsideRejected = !simRK4.StateAt(-0.01, outside) && !simRK4.StateAt(simRK4.GetElapsedTime() + 0.01, outside);
+        TestUtils::ReportResults(isValid && allInside && maxError < 1.0e-4 && endEq && outsideRejected,
+            "Dense Output Test: RK4 History");
+
+        // Without history only the last step answers.
+        Simulation<SimpleSpringMotion, Integrators::RK4> simLast(2.0, 0.1, false, shm);
+        simLast.SetDenseOutput(false);
+        simLast.Run();
+        SimpleSpringMotion::State lastState;
+        const bool lastEq = simLast.StateAt(simLast.GetElapsedTime() - 0.05, lastState) &&
+            std::abs(lastState[0] - std::cos(2.0 * (simLast.GetElapsedTime() - 0.05))) < 1.0e-4 &&
+            !simLast.StateAt(1.0, lastState);
+        TestUtils::ReportResults(lastEq, "Dense Output Test: Last Step Only");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Dense output with adaptive steps, which reuse Dormand-Prince's
+    // derivatives, and a quaternion kept normalized.
+    {
+        SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        Simulation<SimpleSpringMotion, Integrators::DormandPrince> simAdaptive(3.0, 0.01, false, shm);
+        Integrators::AdaptiveTolerances tolerances;
+        tolerances.m_AbsTol = 1.0e-9;
+        tolerances.m_RelTol = 1.0e-9;
+        simAdaptive.SetTolerances(tolerances);
+        simAdaptive.SetDenseOutput(true);
+        simAdaptive.Run();
+
+        double maxError = 0.0;
+        bool allInside = true;
+        for (double t = 0.0; t <= 3.0; t += 0.0137)
+        {
+            SimpleSpringMotion::State state{};
+            allInside = allInside && simAdaptive.StateAt(t, state);
+            maxError = std::max(maxError, std::abs(state[0] - std::cos(2.0 * t)));
+        }
+        const Integrators::StepStats& stats = simAdaptive.GetStepStats();
+        const bool adaptiveEq = allInside && maxError < 1.0e-6 && stats.m_DerivEvals == 1 + 6 * (stats.m_AcceptedSteps + stats.m_RejectedSteps) + 1;
+        TestUtils::ReportResults(adaptiveEq, "Dense Output Test: Adaptive");
+
+        const QuaternionSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0};
+        Simulation<QuaternionSpinningPen, Integrators::RK4> simQsp(1.0, .05, false, QuaternionSpinningPen(penStateInput, {10.0, 10.0, 1.0}));
+        simQsp.SetDenseOutput(true);
+        simQsp.Run();
+        QuaternionSpinningPen::State state{};
+        const bool inside = simQsp.StateAt(0.525, state);
+        const double norm = std::sqrt(state[3]*state[3] + state[4]*state[4] + state[5]*state[5] + state[6]*state[6]);
+        TestUtils::ReportResults(inside && std::abs(norm - 1.0) < 1.0e-12, "Dense Output Test: Quaternion Normalized");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Invariant monitors:
+    // Spring energy holds under RK4 and grows under Euler, which
+    // raises the alarm once and, recording only, runs on.
+    {
+        const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        const bool energyEq = std::abs(shm.ConservedQuantities()[0] - 2.0) < 1.0e-15;
+
+        using SpringRK4 = Simulation<SimpleSpringMotion, Integrators::RK4>;
+        using SpringEuler = Simulation<SimpleSpringMotion, Integrators::Euler>;
+
+        SpringRK4 simRK4(10.0, .001, false, shm);
+        simRK4.SetInvariantMonitor(1.0e-6, SpringRK4::EventAction::Terminate);
+        const bool rk4Eq = simRK4.Run() && !simRK4.WasTerminatedByDrift() && simRK4.GetMaxInvariantDrift()[0] < 1.0e-10;
+
+        size_t numAlarms = 0;
+        double alarmTime = 0.0;
+        SpringEuler simEuler(10.0, .01, false, shm);
+        simEuler.SetInvariantMonitor(1.0e-2, SpringEuler::EventAction::Record,
+            [&](double time, size_t quantityIdx, double drift)
+            {
+                numAlarms += (quantityIdx == 0 && drift > 1.0e-2) ? 1 : 0;
+                alarmTime = time;
+            });
+        simEuler.Run();
+
+        // Euler multiplies the energy by 1 + 4 dt^2 every step.
+        const bool eulerEq = numAlarms == 1 && !simEuler.WasTerminatedByDrift() &&
+            simEuler.GetElapsedTime() > 10.0 - .005 &&
+            std::abs(alarmTime - std::ceil(std::log(1.01) / std::log(1.0004)) * .01) < .015 &&
+            std::abs(simEuler.GetMaxInvariantDrift()[0] - (std::pow(1.0004, 1000) - 1.0)) < 1.0e-2;
+
+        // Checked every 50 steps, the alarm comes at the next check.
+        double sparseAlarmTime = 0.0;
+        SpringEuler simSparse(10.0, .01, false, shm);
+        simSparse.SetInvariantMonitor(1.0e-2, SpringEuler::EventAction::Terminate,
+            [&](double time, size_t, double) { sparseAlarmTime = time; }, 50);
+        const bool sparseEq = simSparse.Run() && simSparse.WasTerminatedByDrift() &&
+            sparseAlarmTime == simSparse.GetElapsedTime() && sparseAlarmTime >= alarmTime &&
+            sparseAlarmTime < alarmTime + .5 && std::abs(std::remainder(sparseAlarmTime, .5)) < 1.0e-9;
+        TestUtils::ReportResults(energyEq && rk4Eq && eulerEq && sparseEq, "Invariant Monitor Test: Spring Energy");
+    }
+
+    // Pen rotational energy and angular momentum stay put under RK4, and
+    // Euler with a large step is aborted as soon as they drift.
+    {
+        const CrudeSpinningPen pen{CrudeSpinningPen::State{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0, 30.0, 2.0, 0.5, 10.0}, {10.0, 8.0, 1.0}};
+        const auto quantities = pen.ConservedQuantities();
+        const bool valuesEq = std::abs(quantities[0] - 0.5 * (10.0 * 4.0 + 8.0 * 0.25 + 100.0)) < 1.0e-12 &&
+            std::abs(quantities[1] - std::sqrt(400.0 + 16.0 + 100.0)) < 1.0e-12 &&
+            std::abs(quantities[2] - 0.5 * (1.0 + 1.0 + 900.0)) < 1.0e-12;
+
+        using PenRK4 = Simulation<CrudeSpinningPen, Integrators::RK4>;
+        using PenEuler = Simulation<CrudeSpinningPen, Integrators::Euler>;
+
+        PenRK4 simRK4(5.0, .001, false, pen);
+        simRK4.SetInvariantMonitor(1.0e-8, PenRK4::EventAction::Terminate);
+        const bool rk4Eq = simRK4.Run() && !simRK4.WasTerminatedByDrift();
+
+        PenEuler simEuler(5.0, .01, false, pen);
+        simEuler.SetInvariantMonitor(1.0e-3, PenEuler::EventAction::Terminate);
+        const bool eulerEq = simEuler.Run() && simEuler.WasTerminatedByDrift() &&
+            simEuler.GetElapsedTime() < 5.0 && simEuler.GetMaxInvariantDrift()[1] > 1.0e-3 &&
+            simEuler.GetMaxInvariantDrift()[3] == 0.0;
+        TestUtils::ReportResults(valuesEq && rk4Eq && eulerEq, "Invariant Monitor Test: Pen Momentum");
+    }
+
+    // The largest step within budget. RK4 loses spring energy
+    // as (2 dt)^6 / 72 per step.
+    {
+        const SimpleSpringMotion shm{SimpleSpringMotion::State{1.0, 0.0}, 4.0};
+        const double deltaT = Invariants::LargestDeltaTWithinBudget<Simulation<SimpleSpringMotion, Integrators::RK4>>(
+            10.0, shm, 1.0e-6, {0.2, 0.1, 0.05, 0.025, 0.01});
+        TestUtils::ReportResults(deltaT == 0.025, "Invariant Monitor Test: Largest Step Within Budget");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Float precision:
+    // The scenarios above run in float stay within single
+    // precision round off of double, see --float.
+    {
+        TestUtils::ReportResults(RunFloatScenarios(false) < 1.0e-4, "Float Test: Deviation From Double");
+    }
 }
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+
+//////////////////////////////////////////////////////////
+// StateVector
+// Descr: Fixed size state of a DynamicEntity, a std::array
+// with expression template arithmetic. A linear
+// combination such as y + h * (b1 * k1 + b2 * k2) builds a
+// lightweight expression, evaluated element by element in
+// one pass when assigned, with no temporary states. Multiply
+// adds become FMAs where the target has them.
+//////////////////////////////////////////////////////////
+
+template <typename T, size_t N>
+struct StateVector;
+
+template <typename Expr>
+struct IsStateVector : std::false_type {};
+
+template <typename T, size_t N>
+struct IsStateVector<StateVector<T, N>> : std::true_type {};
+
+template <typename Expr>
+struct IsStateExpr : IsStateVector<Expr> {};
+
+// Leaves are held by reference, the expression nodes built from
+// them by value, so a full expression never dangles.
+template <typename Expr>
+using StateExprStorage = std::conditional_t<IsStateVector<Expr>::value, const Expr&, Expr>;
+
+// a * b + c, fused where the target has FMA.
+template <typename A, typename B, typename C>
+auto MulAdd(const A& a, const B& b, const C& c)
+{
+#if defined(__FMA__)
+    if constexpr (std::is_floating_point<B>::value && std::is_same<B, C>::value)
+    {
+        return std::fma(static_cast<B>(a), b, c);
+    }
+    else
+#endif
+    {
+        return a * b + c;
+    }
+}
+
+// scale * expr.
+template <typename S, typename Expr>
+struct StateScaled
+{
+    using value_type = typename Expr::value_type;
+    static constexpr size_t Size = Expr::Size;
+
+    auto operator[](size_t idx) const
+    {
+        return m_Scale * m_Expr[idx];
+    }
+
+    S m_Scale;
+    StateExprStorage<Expr> m_Expr;
+};
+
+template <typename Expr>
+struct IsScaled : std::false_type {};
+
+template <typename S, typename Expr>
+struct IsScaled<StateScaled<S, Expr>> : std::true_type {};
+
+// left + right, or left - right. A scaled operand makes the
+// element a multiply add.
+template <typename L, typename R, bool Subtract>
+struct StateSum
+{
+    using value_type = typename L::value_type;
+    static constexpr size_t Size = L::Size;
+
+    auto operator[](size_t idx) const
+    {
+        if constexpr (IsScaled<R>::value)
+        {
+            return MulAdd(Subtract ? -m_Right.m_Scale : m_Right.m_Scale, m_Right.m_Expr[idx], m_Left[idx]);
+        }
+        else if constexpr (IsScaled<L>::value && !Subtract)
+        {
+            return MulAdd(m_Left.m_Scale, m_Left.m_Expr[idx], m_Right[idx]);
+        }
+        else if constexpr (Subtract)
+        {
+            return m_Left[idx] - m_Right[idx];
+        }
+        else
+        {
+            return m_Left[idx] + m_Right[idx];
+        }
+    }
+
+    StateExprStorage<L> m_Left;
+    StateExprStorage<R> m_Right;
+};
+
+template <typename S, typename Expr>
+struct IsStateExpr<StateScaled<S, Expr>> : std::true_type {};
+
+template <typename L, typename R, bool Subtract>
+struct IsStateExpr<StateSum<L, R, Subtract>> : std::true_type {};
+
+template <typename T, size_t N>
+struct StateVector : public std::array<T, N>
+{
+    static constexpr size_t Size = N;
+
+    // Evaluates expr in one pass. expr may refer to this state, each
+    // element only reads its own index.
+    template <typename Expr, typename = std::enable_if_t<IsStateExpr<Expr>::value>>
+    StateVector& operator=(const Expr& expr)
+    {
+        static_assert(Expr::Size == N, "StateVector size mismatch");
+        for (size_t idx = 0; idx < N; ++idx)
+        {
+            (*this)[idx] = expr[idx];
+        }
+        return *this;
+    }
+
+    template <typename Expr, typename = std::enable_if_t<IsStateExpr<Expr>::value>>
+    StateVector& operator+=(const Expr& expr)
+    {
+        return *this = StateSum<StateVector, Expr, false>{*this, expr};
+    }
+
+    template <typename Expr, typename = std::enable_if_t<IsStateExpr<Expr>::value>>
+    StateVector& operator-=(const Expr& expr)
+    {
+        return *this = StateSum<StateVector, Expr, true>{*this, expr};
+    }
+};
+
+template <typename L, typename R, typename = std::enable_if_t<IsStateExpr<L>::value && IsStateExpr<R>::value>>
+StateSum<L, R, false> operator+(const L& left, const R& right)
+{
+    static_assert(L::Size == R::Size, "StateVector size mismatch");
+    return StateSum<L, R, false>{left, right};
+}
+
+template <typename L, typename R, typename = std::enable_if_t<IsStateExpr<L>::value && IsStateExpr<R>::value>>
+StateSum<L, R, true> operator-(const L& left, const R& right)
+{
+    static_assert(L::Size == R::Size, "StateVector size mismatch");
+    return StateSum<L, R, true>{left, right};
+}
+
+template <typename S, typename Expr, typename = std::enable_if_t<std::is_arithmetic<S>::value && IsStateExpr<Expr>::value>>
+StateScaled<S, Expr> operator*(S scale, const Expr& expr)
+{
+    return StateScaled<S, Expr>{scale, expr};
+}
+
+namespace std
+{
+
+template <typename T, size_t N>
+struct tuple_size<StateVector<T, N>> : std::integral_constant<size_t, N> {};
+
+template <size_t I, typename T, size_t N>
+struct tuple_element<I, StateVector<T, N>>
+{
+    using type = T;
+};
+
+} // namespace std
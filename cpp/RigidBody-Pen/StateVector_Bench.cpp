@@ -0,0 +1,123 @@
+#include "./StateVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// StateVector_Bench
+// Descr: Times RK4's final update of a pen state,
+// y += h/6 * (k1 + 2 k2 + 2 k3 + k4), over an ensemble of
+// states, done as separate axpy passes through a temporary
+// state and as one fused StateVector expression. Reports the
+// memory traffic per step each form needs and the time per
+// state, for an ensemble in cache and one far larger.
+// Usage: ./StateVector_Bench
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+constexpr size_t NumFields = 13;
+using State = StateVector<double, NumFields>;
+
+struct Stages
+{
+    State m_K1;
+    State m_K2;
+    State m_K3;
+    State m_K4;
+};
+
+// Per element, copy k1 (1 load, 1 store), three axpys (2 loads, 1
+// store each) and the final axpy (2 loads, 1 store).
+constexpr size_t SeparateAccesses = 2 + 3 * 3 + 3;
+// Per element, five loads and one store.
+constexpr size_t FusedAccesses = 6;
+
+// Keeps the optimizer from discarding the benchmarked work.
+volatile double g_Sink = 0.0;
+
+void Axpy(double scale, const State& x, State& inOutY)
+{
+    for (size_t idx = 0; idx < NumFields; ++idx)
+    {
+        inOutY[idx] += scale * x[idx];
+    }
+}
+
+void SeparateUpdate(double h, const Stages& stages, State& inOutState)
+{
+    State sum = stages.m_K1;
+    Axpy(2.0, stages.m_K2, sum);
+    Axpy(2.0, stages.m_K3, sum);
+    Axpy(1.0, stages.m_K4, sum);
+    Axpy(h / 6, sum, inOutState);
+}
+
+void FusedUpdate(double h, const Stages& stages, State& inOutState)
+{
+    inOutState += h / 6 * (stages.m_K1 + 2 * stages.m_K2 + 2 * stages.m_K3 + stages.m_K4);
+}
+
+template <typename Update>
+double SecondsPerState(size_t numStates, size_t numSteps, Update update, double& outChecksum)
+{
+    std::vector<State> states(numStates);
+    std::vector<Stages> stages(numStates);
+    for (size_t entity = 0; entity < numStates; ++entity)
+    {
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            states[entity][field] = 1.0 + 0.001 * field;
+            stages[entity].m_K1[field] = std::sin(0.1 * (entity + field));
+            stages[entity].m_K2[field] = std::cos(0.1 * (entity + field));
+            stages[entity].m_K3[field] = -std::sin(0.2 * (entity + field));
+            stages[entity].m_K4[field] = 0.5;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t step = 0; step < numSteps; ++step)
+    {
+        for (size_t entity = 0; entity < numStates; ++entity)
+        {
+            update(1.0e-3, stages[entity], states[entity]);
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    outChecksum = 0.0;
+    for (const State& state : states)
+    {
+        outChecksum += state[0] + state[NumFields - 1];
+    }
+    g_Sink = g_Sink + outChecksum;
+    return std::chrono::duration<double>(stop - start).count() / (numStates * numSteps);
+}
+
+void BenchEnsemble(const char* name, size_t numStates, size_t numSteps)
+{
+    double separateChecksum = 0.0, fusedChecksum = 0.0;
+    const double separate = SecondsPerState(numStates, numSteps, SeparateUpdate, separateChecksum);
+    const double fused = SecondsPerState(numStates, numSteps, FusedUpdate, fusedChecksum);
+
+    std::cout << name << ", " << numStates << " states:\n"
+        << "  separate passes: " << SeparateAccesses * NumFields * sizeof(double) << " bytes loaded and stored/step, "
+        << separate * 1.0e9 << " ns/state\n"
+        << "  fused:           " << FusedAccesses * NumFields * sizeof(double) << " bytes loaded and stored/step, "
+        << fused * 1.0e9 << " ns/state\n"
+        << "  speedup " << separate / fused
+        << ", checksum difference " << std::abs(separateChecksum - fusedChecksum) << "\n";
+}
+
+} // namespace
+
+int main(void)
+{
+    BenchEnsemble("In cache", 64, 200000);
+    BenchEnsemble("Streaming", 200000, 64);
+    return 0;
+}
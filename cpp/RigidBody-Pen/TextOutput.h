@@ -0,0 +1,329 @@
+#pragma once
+
+#include "./Dual.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <ostream>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// TextOutput
+// Descr: Text output of entity states without per sample
+// allocations. Numbers are written with std::to_chars
+// straight into a reusable TextBuffer, and sinks hand the
+// buffer to their stream in large blocks. Column and key
+// names come from each entity's FieldNames, so entities
+// carry no formatting code of their own.
+//////////////////////////////////////////////////////////
+
+namespace TextOutput
+{
+
+// Sinks write to their stream once this much text is buffered.
+constexpr size_t DefaultBlockSize = 1 << 16;
+
+// Growable character buffer, reused across samples. Only grows, so
+// once it has reached its working size appending never allocates.
+class TextBuffer
+{
+public:
+
+    explicit TextBuffer(size_t capacity = DefaultBlockSize)
+    : m_Data(std::max<size_t>(capacity, MinCapacity))
+    {}
+
+    void Append(char c)
+    {
+        Reserve(1);
+        m_Data[m_Size++] = c;
+    }
+
+    void Append(const char* text, size_t size)
+    {
+        Reserve(size);
+        memcpy(m_Data.data() + m_Size, text, size);
+        m_Size += size;
+    }
+
+    void Append(const char* text)
+    {
+        Append(text, strlen(text));
+    }
+
+    void Append(const std::string& text)
+    {
+        Append(text.data(), text.size());
+    }
+
+    // Shortest text which reads back to exactly value.
+    template <typename Real>
+    void AppendShortest(Real value)
+    {
+        AppendChars([value](char* first, char* last){ return std::to_chars(first, last, value); });
+    }
+
+    // As printf("%.<precision>f"), eg std::to_string for precision 6.
+    template <typename Real>
+    void AppendFixed(Real value, int precision)
+    {
+        AppendChars([value, precision](char* first, char* last)
+        {
+            return std::to_chars(first, last, value, std::chars_format::fixed, precision);
+        });
+    }
+
+    // As printf("%.<precision>g"), eg std::ostream's default for precision 6.
+    template <typename Real>
+    void AppendGeneral(Real value, int precision)
+    {
+        AppendChars([value, precision](char* first, char* last)
+        {
+            return std::to_chars(first, last, value, std::chars_format::general, precision);
+        });
+    }
+
+    const char* Data() const
+    {
+        return m_Data.data();
+    }
+
+    size_t Size() const
+    {
+        return m_Size;
+    }
+
+    void Clear()
+    {
+        m_Size = 0;
+    }
+
+    // Writes the buffered text to out in one call and clears the buffer.
+    bool WriteTo(std::ostream& out)
+    {
+        if (m_Size > 0)
+        {
+            out.write(m_Data.data(), static_cast<std::streamsize>(m_Size));
+            m_Size = 0;
+        }
+        return out.good();
+    }
+
+private:
+
+    // Longest shortest-form double, eg -2.2250738585072014e-308, with room to spare.
+    static constexpr size_t MinCapacity = 64;
+
+    void Reserve(size_t size)
+    {
+        if (m_Size + size > m_Data.size())
+        {
+            m_Data.resize(std::max(2 * m_Data.size(), m_Size + size));
+        }
+    }
+
+    // Formats in place, growing and retrying on the rare number which
+    // does not fit, eg fixed notation of 1e300.
+    template <typename ToChars>
+    void AppendChars(ToChars toChars)
+    {
+        Reserve(MinCapacity / 2);
+        while (true)
+        {
+            const std::to_chars_result result = toChars(m_Data.data() + m_Size, m_Data.data() + m_Data.size());
+            if (result.ec == std::errc())
+            {
+                m_Size = static_cast<size_t>(result.ptr - m_Data.data());
+                return;
+            }
+            m_Data.resize(2 * m_Data.size());
+        }
+    }
+
+private:
+    std::vector<char> m_Data;
+    size_t m_Size = 0;
+};
+
+// Appends the status of an entity as Simulation::PrintStatus shows
+// it, eg
+//   ****************************************
+//   t = 0.01,
+//    CSP: x = 0.100000, y = 0.100000, z = 0.100000,
+//    theta = ...
+// with three fields to a line.
+template <typename DynamicEntityType>
+void AppendStatus(TextBuffer& buffer, double time, const typename DynamicEntityType::State& state)
+{
+    constexpr size_t NumFields = std::tuple_size<typename DynamicEntityType::State>::value;
+    constexpr size_t FieldsPerLine = 3;
+
+    buffer.Append("****************************************\nt = ");
+    buffer.AppendGeneral(time, 6);
+    buffer.Append(", \n ");
+    buffer.Append(DynamicEntityType::ShortName);
+    buffer.Append(": ");
+    for (size_t field = 0; field < NumFields; ++field)
+    {
+        if (field > 0)
+        {
+            buffer.Append(field % FieldsPerLine == 0 ? ",\n " : ", ");
+        }
+        buffer.Append(DynamicEntityType::FieldNames[field]);
+        buffer.Append(" = ");
+        buffer.AppendFixed(static_cast<double>(ScalarValue(state[field])), 6);
+    }
+    buffer.Append("\n\n");
+}
+
+// Writes a trajectory as CSV, a header row of t and the entity's
+// field names, then one row per sample. Values are in shortest
+// round trip form, so reading the file back gives the exact states.
+//
+// Use with Simulation::SetOutputSink, eg
+//   sim.SetOutputSink([&](double t, const auto& state){ csv.Append(t, state); });
+template <typename DynamicEntityType>
+class CsvSink
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+    static constexpr size_t NumFields = std::tuple_size<State>::value;
+
+    explicit CsvSink(std::ostream& out, size_t blockSize = DefaultBlockSize)
+    : m_Out(out)
+    , m_BlockSize(blockSize)
+    , m_Buffer(blockSize + RowReserve)
+    {
+        m_Buffer.Append('t');
+        for (const char* name : DynamicEntityType::FieldNames)
+        {
+            m_Buffer.Append(',');
+            m_Buffer.Append(name);
+        }
+        m_Buffer.Append('\n');
+    }
+
+    CsvSink(const CsvSink&) = delete;
+    CsvSink& operator=(const CsvSink&) = delete;
+
+    ~CsvSink()
+    {
+        Flush();
+    }
+
+    void Append(double time, const State& state)
+    {
+        m_Buffer.AppendShortest(time);
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_Buffer.Append(',');
+            m_Buffer.AppendShortest(ScalarValue(state[field]));
+        }
+        m_Buffer.Append('\n');
+
+        if (m_Buffer.Size() >= m_BlockSize)
+        {
+            Flush();
+        }
+    }
+
+    bool Flush()
+    {
+        return m_Buffer.WriteTo(m_Out);
+    }
+
+private:
+    static constexpr size_t RowReserve = 32 * (NumFields + 1);
+
+    std::ostream& m_Out;
+    const size_t m_BlockSize;
+    TextBuffer m_Buffer;
+};
+
+// Writes a trajectory as JSON Lines, one object per sample keyed by
+// t and the entity's field names, eg
+//   {"t":0.01,"x":0.1,"vel_x":10}
+// Non finite values, which JSON cannot hold, are written as null.
+template <typename DynamicEntityType>
+class JsonLinesSink
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+    static constexpr size_t NumFields = std::tuple_size<State>::value;
+
+    explicit JsonLinesSink(std::ostream& out, size_t blockSize = DefaultBlockSize)
+    : m_Out(out)
+    , m_BlockSize(blockSize)
+    , m_Buffer(blockSize + RowReserve)
+    {
+        // Keys are formatted once, each with its separator.
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_Keys[field] = std::string(",\"") + DynamicEntityType::FieldNames[field] + "\":";
+        }
+    }
+
+    JsonLinesSink(const JsonLinesSink&) = delete;
+    JsonLinesSink& operator=(const JsonLinesSink&) = delete;
+
+    ~JsonLinesSink()
+    {
+        Flush();
+    }
+
+    void Append(double time, const State& state)
+    {
+        m_Buffer.Append("{\"t\":", 5);
+        AppendValue(time);
+        for (size_t field = 0; field < NumFields; ++field)
+        {
+            m_Buffer.Append(m_Keys[field]);
+            AppendValue(ScalarValue(state[field]));
+        }
+        m_Buffer.Append("}\n", 2);
+
+        if (m_Buffer.Size() >= m_BlockSize)
+        {
+            Flush();
+        }
+    }
+
+    bool Flush()
+    {
+        return m_Buffer.WriteTo(m_Out);
+    }
+
+private:
+
+    template <typename Real>
+    void AppendValue(Real value)
+    {
+        if (std::isfinite(value))
+        {
+            m_Buffer.AppendShortest(value);
+        }
+        else
+        {
+            m_Buffer.Append("null", 4);
+        }
+    }
+
+private:
+    static constexpr size_t RowReserve = 64 * (NumFields + 1);
+
+    std::ostream& m_Out;
+    const size_t m_BlockSize;
+    TextBuffer m_Buffer;
+    std::array<std::string, NumFields> m_Keys;
+};
+
+} // namespace TextOutput
@@ -0,0 +1,190 @@
+#include "./DynamicEntities.h"
+#include "./Simulation.h"
+#include "./TextOutput.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// TextOutput_Bench
+// Descr: Times writing a spinning pen trajectory as text,
+// with the old std::to_string and operator+ status report,
+// with the same status text from TextOutput::AppendStatus,
+// and with the CSV and JSON Lines sinks, into an output
+// which discards it, so only formatting is timed. memcpy
+// of the CSV text in the sinks' block size is the bound.
+// Usage: ./TextOutput_Bench
+//////////////////////////////////////////////////////////
+
+namespace
+{
+
+using State = CrudeSpinningPen::State;
+
+// Keeps the optimizer from discarding the copies.
+volatile char g_Sink = 0;
+
+struct Sample
+{
+    double m_Time;
+    State m_State;
+};
+
+// Counts and discards what is written.
+class NullStreamBuf : public std::streambuf
+{
+public:
+    size_t m_Bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        m_Bytes += static_cast<size_t>(count);
+        return count;
+    }
+
+    int overflow(int ch) override
+    {
+        ++m_Bytes;
+        return ch;
+    }
+};
+
+// The status report as entities used to write it.
+std::string LegacyReportState(const State& state)
+{
+    std::string out =
+        "CSP: x = " + std::to_string(state[0]) + ", y = " + std::to_string(state[1]) +
+        ", z = " + std::to_string(state[2]) + ",\n theta = " + std::to_string(state[3]) +
+        ", phi = " + std::to_string(state[4]) + ", psi = " + std::to_string(state[5]) +
+        ",\n vel_x = " + std::to_string(state[6]) + ", vel_y = " + std::to_string(state[7]) +
+        ", vel_z = " + std::to_string(state[8]) + ",\n theta_dot = " + std::to_string(state[9]) +
+        ", phi_dot = " + std::to_string(state[10]) + ", psi_dot = " + std::to_string(state[11]) + "\n";
+    return out;
+}
+
+std::vector<Sample> MakeTrajectory(size_t numSamples)
+{
+    const CrudeSpinningPen csp(State{0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0}, {10.0, 10.0, 1.0});
+
+    std::vector<Sample> samples;
+    samples.reserve(numSamples);
+    Simulation<CrudeSpinningPen, Integrators::RK4> sim(1.0e-4 * numSamples, 1.0e-4, false, csp);
+    sim.SetOutputSink([&](double time, const State& state)
+    {
+        if (samples.size() < numSamples)
+        {
+            samples.push_back(Sample{time, state});
+        }
+    });
+    sim.Run();
+    return samples;
+}
+
+template <typename Write>
+void Bench(const char* name, const std::vector<Sample>& samples, double memcpyRate, Write write)
+{
+    NullStreamBuf nullBuf;
+    std::ostream out(&nullBuf);
+
+    const auto start = std::chrono::steady_clock::now();
+    write(out);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double rate = nullBuf.m_Bytes / seconds;
+    std::cout << "  " << name << ": " << seconds * 1.0e9 / samples.size() << " ns/sample, "
+        << rate * 1.0e-6 << " MB/s";
+    if (memcpyRate > 0.0)
+    {
+        std::cout << ", " << memcpyRate / rate << "x memcpy time";
+    }
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(void)
+{
+    const std::vector<Sample> samples = MakeTrajectory(200000);
+    std::cout << samples.size() << " pen samples:\n";
+
+    // The CSV text, to time copying it in blocks.
+    std::ostringstream csvText;
+    {
+        TextOutput::CsvSink<CrudeSpinningPen> csv(csvText);
+        for (const Sample& sample : samples)
+        {
+            csv.Append(sample.m_Time, sample.m_State);
+        }
+    }
+    const std::string text = csvText.str();
+
+    double memcpyRate = 0.0;
+    {
+        std::vector<char> block(TextOutput::DefaultBlockSize);
+        const size_t repeats = 20;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (size_t pos = 0; pos < text.size(); pos += block.size())
+            {
+                const size_t count = std::min(block.size(), text.size() - pos);
+                memcpy(block.data(), text.data() + pos, count);
+                g_Sink = g_Sink + block[count - 1];
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        memcpyRate = repeats * text.size() / seconds;
+        std::cout << "  memcpy of CSV text: " << memcpyRate * 1.0e-6 << " MB/s\n";
+    }
+
+    Bench("to_string status  ", samples, memcpyRate, [&](std::ostream& out)
+    {
+        for (const Sample& sample : samples)
+        {
+            const std::string dynState = LegacyReportState(sample.m_State);
+            out << "****************************************\n";
+            out << "t = " << sample.m_Time << ", \n " << dynState << "\n";
+        }
+    });
+
+    Bench("to_chars status   ", samples, memcpyRate, [&](std::ostream& out)
+    {
+        TextOutput::TextBuffer buffer;
+        for (const Sample& sample : samples)
+        {
+            TextOutput::AppendStatus<CrudeSpinningPen>(buffer, sample.m_Time, sample.m_State);
+            if (buffer.Size() >= TextOutput::DefaultBlockSize)
+            {
+                buffer.WriteTo(out);
+            }
+        }
+        buffer.WriteTo(out);
+    });
+
+    Bench("CSV sink          ", samples, memcpyRate, [&](std::ostream& out)
+    {
+        TextOutput::CsvSink<CrudeSpinningPen> csv(out);
+        for (const Sample& sample : samples)
+        {
+            csv.Append(sample.m_Time, sample.m_State);
+        }
+    });
+
+    Bench("JSON Lines sink   ", samples, memcpyRate, [&](std::ostream& out)
+    {
+        TextOutput::JsonLinesSink<CrudeSpinningPen> jsonLines(out);
+        for (const Sample& sample : samples)
+        {
+            jsonLines.Append(sample.m_Time, sample.m_State);
+        }
+    });
+
+    return 0;
+}
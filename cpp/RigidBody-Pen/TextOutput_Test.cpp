@@ -0,0 +1,174 @@
+#include "./DynamicEntities.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+#include "./TextOutput.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// TextOutput Unit Tests
+//////////////////////////////////////////////////////////
+
+// Counts the writes which reach the output.
+class CountingStreamBuf : public std::streambuf
+{
+public:
+    size_t m_Writes = 0;
+    size_t m_Bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        ++m_Writes;
+        m_Bytes += static_cast<size_t>(count);
+        return count;
+    }
+
+    int overflow(int ch) override
+    {
+        ++m_Writes;
+        ++m_Bytes;
+        return ch;
+    }
+};
+
+// Values of each CSV row after the header, row by row.
+static std::vector<std::vector<double>> ParseCsv(const std::string& text, std::string& outHeader)
+{
+    std::vector<std::vector<double>> rows;
+    std::istringstream in(text);
+    std::getline(in, outHeader);
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::vector<double> row;
+        std::istringstream cells(line);
+        std::string cell;
+        while (std::getline(cells, cell, ','))
+        {
+            row.push_back(std::strtod(cell.c_str(), nullptr));
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+int main(void)
+{
+    const CrudeSpinningPen::State penStateInput{
+        0.0, 0.0, 0.0, 0.1, 0.2, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+    const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+    const CrudeSpinningPen csp(penStateInput, inertia);
+
+    //////////////////////////////////////////////////////////
+    // Test status text is as the to_string based ReportState
+    // wrote it.
+    {
+        const CrudeSpinningPen::State state{
+            1.5, -2.25, 1.0e-7, 3.0, 0.5, -0.125, 1234.5, 0.0, -9.8, 1.0e12, 2.0, 3.0};
+        const double time = 0.01 * 37;
+
+        std::ostringstream legacy;
+        legacy << "****************************************\n"
+               << "t = " << time << ", \n "
+               << "CSP: x = " + std::to_string(state[0]) + ", y = " + std::to_string(state[1]) +
+                  ", z = " + std::to_string(state[2]) + ",\n theta = " + std::to_string(state[3]) +
+                  ", phi = " + std::to_string(state[4]) + ", psi = " + std::to_string(state[5]) +
+                  ",\n vel_x = " + std::to_string(state[6]) + ", vel_y = " + std::to_string(state[7]) +
+                  ", vel_z = " + std::to_string(state[8]) + ",\n theta_dot = " + std::to_string(state[9]) +
+                  ", phi_dot = " + std::to_string(state[10]) + ", psi_dot = " + std::to_string(state[11]) + "\n"
+               << "\n";
+
+        TextOutput::TextBuffer buffer;
+        TextOutput::AppendStatus<CrudeSpinningPen>(buffer, time, state);
+        const bool statusEq = std::string(buffer.Data(), buffer.Size()) == legacy.str();
+        TestUtils::ReportResults(statusEq, "Text Output Test: Status Format");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test buffer grows for numbers longer than its capacity.
+    {
+        TextOutput::TextBuffer buffer(1);
+        buffer.AppendFixed(1.0e300, 6);
+        buffer.AppendShortest(-std::numeric_limits<double>::denorm_min());
+        const bool growEq = std::string(buffer.Data(), buffer.Size()) == std::to_string(1.0e300) + "-5e-324";
+        TestUtils::ReportResults(growEq, "Text Output Test: Buffer Growth");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test CSV of a Simulation reads back to the exact states.
+    {
+        std::vector<double> expected;
+        std::ostringstream out;
+        {
+            TextOutput::CsvSink<CrudeSpinningPen> csv(out);
+            Simulation simCsp(2.04, .01, false, csp);
+            simCsp.SetOutputSink([&](double time, const CrudeSpinningPen::State& state)
+            {
+                csv.Append(time, state);
+                expected.push_back(time);
+                expected.insert(expected.end(), state.begin(), state.end());
+            });
+            simCsp.Run();
+        }
+
+        std::string header;
+        const std::vector<std::vector<double>> rows = ParseCsv(out.str(), header);
+        std::vector<double> values;
+        bool rowsEq = rows.size() == 205;
+        for (const std::vector<double>& row : rows)
+        {
+            rowsEq = rowsEq && row.size() == 13;
+            values.insert(values.end(), row.begin(), row.end());
+        }
+
+        const bool csvEq = header == "t,x,y,z,theta,phi,psi,vel_x,vel_y,vel_z,theta_dot,phi_dot,psi_dot" &&
+            rowsEq && values == expected;
+        TestUtils::ReportResults(csvEq, "Text Output Test: CSV Round Trip");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test JSON Lines keys, shortest values, and null for non
+    // finite values.
+    {
+        std::ostringstream out;
+        {
+            TextOutput::JsonLinesSink<SimpleSpringMotion> jsonLines(out);
+            jsonLines.Append(0.0, SimpleSpringMotion::State{1.0, -0.1});
+            jsonLines.Append(0.25, SimpleSpringMotion::State{std::nan(""), 1.0e-20});
+        }
+
+        const bool jsonEq = out.str() ==
+            "{\"t\":0,\"x\":1,\"vel_x\":-0.1}\n"
+            "{\"t\":0.25,\"x\":null,\"vel_x\":1e-20}\n";
+        TestUtils::ReportResults(jsonEq, "Text Output Test: JSON Lines Format");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test sinks write in blocks, not per sample.
+    {
+        CountingStreamBuf counter;
+        std::ostream out(&counter);
+        const size_t blockSize = 4096;
+        const size_t numSamples = 10000;
+        {
+            TextOutput::CsvSink<CrudeSpinningPen> csv(out, blockSize);
+            for (size_t idx = 0; idx < numSamples; ++idx)
+            {
+                csv.Append(0.01 * idx, penStateInput);
+            }
+        }
+
+        const bool blocksEq = counter.m_Bytes > numSamples * 13 &&
+            counter.m_Writes <= counter.m_Bytes / blockSize + 1;
+        TestUtils::ReportResults(blocksEq, "Text Output Test: Block Writes");
+    }
+
+    return 0;
+}
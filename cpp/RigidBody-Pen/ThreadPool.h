@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// ThreadPool
+// Descr: Work stealing thread pool used to spread
+// independent simulations over cores.
+//////////////////////////////////////////////////////////
+
+class WorkStealingPool
+{
+public:
+
+    // Task signature: fn(index, workerIdx). workerIdx is in
+    // [0, NumThreads()) and lets callers keep per thread state.
+    using Task = std::function<void(size_t, size_t)>;
+
+    explicit WorkStealingPool(size_t numThreads = std::thread::hardware_concurrency())
+    {
+        numThreads = std::max<size_t>(numThreads, 1);
+
+        for (size_t idx = 0; idx < numThreads; ++idx)
+        {
+            m_Queues.push_back(std::make_unique<WorkQueue>());
+        }
+
+        for (size_t idx = 0; idx < numThreads; ++idx)
+        {
+            m_Threads.emplace_back([this, idx]{ WorkerLoop(idx); });
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_WakeCv.notify_all();
+
+        for (std::thread& thread : m_Threads)
+        {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t NumThreads() const
+    {
+        return m_Threads.size();
+    }
+
+    // Calls fn(index, workerIdx) for every index in [0, count) and blocks
+    // until all calls are done. Indices are handed out in chunks of
+    // chunkSize, dealt round robin to the workers' queues. A worker takes
+    // chunks from the back of its own queue and, once empty, steals from
+    // the front of the others. chunkSize of zero picks one automatically.
+    // One ParallelFor at a time; it must not be called from a task.
+    void ParallelFor(size_t count, size_t chunkSize, const Task& fn)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        if (chunkSize == 0)
+        {
+            chunkSize = std::max<size_t>(1, count / (8 * NumThreads()));
+        }
+
+        const size_t numChunks = (count + chunkSize - 1) / chunkSize;
+        m_ChunksLeft.store(numChunks);
+
+        for (size_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            const size_t begin = chunk * chunkSize;
+            const Range range{begin, std::min(begin + chunkSize, count), &fn};
+
+            WorkQueue& queue = *m_Queues[chunk % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(queue.m_Mutex);
+            queue.m_Ranges.push_back(range);
+        }
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        ++m_Generation;
+        m_WakeCv.notify_all();
+        m_DoneCv.wait(lock, [this]{ return m_ChunksLeft.load() == 0; });
+    }
+
+private:
+
+    // Chunk of indices. Carries its task, which lives on the stack of
+    // ParallelFor until every chunk of that call has completed.
+    struct Range
+    {
+        size_t m_Begin;
+        size_t m_End;
+        const Task* m_Task;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex m_Mutex;
+        std::deque<Range> m_Ranges;
+    };
+
+    void WorkerLoop(size_t workerIdx)
+    {
+        size_t seenGeneration = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WakeCv.wait(lock, [&]{ return m_Stop || m_Generation != seenGeneration; });
+                if (m_Stop)
+                {
+                    return;
+                }
+                seenGeneration = m_Generation;
+            }
+
+            Range range;
+            while (PopOrSteal(workerIdx, range))
+            {
+                for (size_t idx = range.m_Begin; idx < range.m_End; ++idx)
+                {
+                    (*range.m_Task)(idx, workerIdx);
+                }
+
+                if (m_ChunksLeft.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_DoneCv.notify_all();
+                }
+            }
+        }
+    }
+
+    bool PopOrSteal(size_t workerIdx, Range& outRange)
+    {
+        {
+            WorkQueue& own = *m_Queues[workerIdx];
+            std::lock_guard<std::mutex> lock(own.m_Mutex);
+            if (!own.m_Ranges.empty())
+            {
+                outRange = own.m_Ranges.back();
+                own.m_Ranges.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < m_Queues.size(); ++offset)
+        {
+            WorkQueue& victim = *m_Queues[(workerIdx + offset) % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(victim.m_Mutex);
+            if (!victim.m_Ranges.empty())
+            {
+                outRange = victim.m_Ranges.front();
+                victim.m_Ranges.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+    std::vector<std::thread> m_Threads;
+
+    std::mutex m_Mutex;                     // Guards m_Generation and m_Stop.
+    std::condition_variable m_WakeCv;
+    std::condition_variable m_DoneCv;
+    size_t m_Generation = 0;
+    bool m_Stop = false;
+    std::atomic<size_t> m_ChunksLeft{0};
+};
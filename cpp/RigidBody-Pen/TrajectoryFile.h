@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string.h>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////
+// TrajectoryFile
+// Descr: Binary columnar trajectory files. A fixed size
+// header names the entity, its state fields and the time
+// step, followed by one column of doubles per field, with
+// simulation time as column 0. Written and read through
+// mmap, so readers get each column in place without any
+// parsing. Files are in the host's byte order.
+//////////////////////////////////////////////////////////
+
+namespace Trajectory
+{
+
+constexpr char Magic[8] = {'R', 'B', 'P', 'T', 'R', 'J', '\0', '\0'};
+constexpr uint32_t Version = 1;
+constexpr size_t MaxColumns = 32;
+constexpr size_t MaxNameLength = 32;
+
+struct Header
+{
+    char m_Magic[8];
+    uint32_t m_Version;
+    uint32_t m_NumColumns;                  // State fields plus time.
+    double m_DeltaT;                        // in seconds, nominal step.
+    uint64_t m_Capacity;                    // Rows reserved per column.
+    uint64_t m_NumRows;                     // Rows written.
+    char m_EntityName[MaxNameLength];
+    char m_ColumnNames[MaxColumns][MaxNameLength];
+};
+
+// Columns start here, and column c at DataOffset + c * m_Capacity doubles.
+constexpr size_t DataOffset = (sizeof(Header) + 63) / 64 * 64;
+
+// Read only view of one column.
+struct ColumnView
+{
+    const double* begin() const { return m_Data; }
+    const double* end() const { return m_Data + m_Size; }
+    size_t size() const { return m_Size; }
+    const double& operator[](size_t row) const { return m_Data[row]; }
+
+    const double* m_Data = nullptr;
+    size_t m_Size = 0;
+};
+
+} // namespace Trajectory
+
+// Writes the trajectory of a DynamicEntityType. Rows are appended
+// straight into the mapped file, column capacity doubles as needed,
+// and Close() compacts the columns and truncates the file.
+//
+// Use with Simulation::SetOutputSink, eg
+//   sim.SetOutputSink([&](double t, const auto& state){ writer.Append(t, state); });
+template <typename DynamicEntityType>
+class TrajectoryWriter
+{
+public:
+
+    using State = typename DynamicEntityType::State;
+    static constexpr size_t NumColumns = std::tuple_size<State>::value + 1;
+    static_assert(NumColumns <= Trajectory::MaxColumns, "Too many state fields for trajectory header");
+
+    TrajectoryWriter() = default;
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    ~TrajectoryWriter()
+    {
+        Close();
+    }
+
+    bool Open(const std::string& path, double deltaT, size_t initialCapacity = 4096)
+    {
+        Close();
+
+        m_Fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_Fd < 0)
+        {
+            std::cout << "TrajectoryWriter: cannot open " << path << "\n";
+            return false;
+        }
+
+        if (!Map(std::max<size_t>(initialCapacity, 1)))
+        {
+            Close();
+            return false;
+        }
+
+        Trajectory::Header& header = GetHeader();
+        memset(&header, 0, sizeof(header));
+        memcpy(header.m_Magic, Trajectory::Magic, sizeof(header.m_Magic));
+        header.m_Version = Trajectory::Version;
+        header.m_NumColumns = NumColumns;
+        header.m_DeltaT = deltaT;
+        header.m_Capacity = m_Capacity;
+        header.m_NumRows = 0;
+        strncpy(header.m_EntityName, DynamicEntityType::Name, Trajectory::MaxNameLength - 1);
+        strncpy(header.m_ColumnNames[0], "t", Trajectory::MaxNameLength - 1);
+        for (size_t field = 0; field + 1 < NumColumns; ++field)
+        {
+            strncpy(header.m_ColumnNames[field + 1], DynamicEntityType::FieldNames[field], Trajectory::MaxNameLength - 1);
+        }
+
+        m_NumRows = 0;
+        return true;
+    }
+
+    bool Append(double time, const State& state)
+    {
+        if (m_Map == nullptr)
+        {
+            return false;
+        }
+
+        if (m_NumRows == m_Capacity && !Grow(2 * m_Capacity))
+        {
+            return false;
+        }
+
+        ColumnData(0)[m_NumRows] = time;
+        for (size_t field = 0; field + 1 < NumColumns; ++field)
+        {
+            ColumnData(field + 1)[m_NumRows] = state[field];
+        }
+
+        ++m_NumRows;
+        GetHeader().m_NumRows = m_NumRows;
+        return true;
+    }
+
+    size_t NumRows() const
+    {
+        return m_NumRows;
+    }
+
+    // Compacts the columns to the rows written and closes the file.
+    bool Close()
+    {
+        if (m_Fd < 0)
+        {
+            return true;
+        }
+
+        bool isValid = m_Map != nullptr;
+        if (isValid)
+        {
+            // Columns only move towards the front, so go first to last.
+            for (size_t column = 1; column < NumColumns; ++column)
+            {
+                memmove(ColumnData(0) + column * m_NumRows, ColumnData(column), m_NumRows * sizeof(double));
+            }
+            GetHeader().m_Capacity = m_NumRows;
+
+            munmap(m_Map, m_MapSize);
+            isValid = ftruncate(m_Fd, FileSize(m_NumRows)) == 0;
+        }
+
+        close(m_Fd);
+        m_Fd = -1;
+        m_Map = nullptr;
+        m_MapSize = 0;
+        m_Capacity = 0;
+        return isValid;
+    }
+
+private:
+
+    static size_t FileSize(size_t capacity)
+    {
+        return Trajectory::DataOffset + NumColumns * capacity * sizeof(double);
+    }
+
+    Trajectory::Header& GetHeader()
+    {
+        return *reinterpret_cast<Trajectory::Header*>(m_Map);
+    }
+
+    double* ColumnData(size_t column)
+    {
+        return reinterpret_cast<double*>(static_cast<char*>(m_Map) + Trajectory::DataOffset) + column * m_Capacity;
+    }
+
+    bool Map(size_t capacity)
+    {
+        const size_t mapSize = FileSize(capacity);
+        if (ftruncate(m_Fd, mapSize) != 0)
+        {
+            std::cout << "TrajectoryWriter: cannot resize file\n";
+            return false;
+        }
+
+        void* map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_Fd, 0);
+        if (map == MAP_FAILED)
+        {
+            std::cout << "TrajectoryWriter: cannot map file\n";
+            return false;
+        }
+
+        m_Map = map;
+        m_MapSize = mapSize;
+        m_Capacity = capacity;
+        return true;
+    }
+
+    bool Grow(size_t newCapacity)
+    {
+        const size_t oldCapacity = m_Capacity;
+        munmap(m_Map, m_MapSize);
+        m_Map = nullptr;
+
+        if (!Map(newCapacity))
+        {
+            return false;
+        }
+
+        // Columns only move towards the back, so go last to first.
+        double* data = ColumnData(0);
+        for (size_t column = NumColumns - 1; column > 0; --column)
+        {
+            memmove(data + column * newCapacity, data + column * oldCapacity, m_NumRows * sizeof(double));
+        }
+        GetHeader().m_Capacity = newCapacity;
+        return true;
+    }
+
+private:
+    int m_Fd = -1;
+    void* m_Map = nullptr;
+    size_t m_MapSize = 0;
+    size_t m_Capacity = 0;
+    size_t m_NumRows = 0;
+};
+
+// Maps a trajectory file read only and exposes its columns in place.
+class TrajectoryReader
+{
+public:
+
+    TrajectoryReader() = default;
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    ~TrajectoryReader()
+    {
+        Close();
+    }
+
+    bool Open(const std::string& path)
+    {
+        Close();
+
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::cout << "TrajectoryReader: cannot open " << path << "\n";
+            return false;
+        }
+
+        struct stat fileStat;
+        const bool statValid = fstat(fd, &fileStat) == 0 && static_cast<size_t>(fileStat.st_size) >= Trajectory::DataOffset;
+        void* map = statValid ? mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+
+        if (map == MAP_FAILED)
+        {
+            std::cout << "TrajectoryReader: cannot map " << path << "\n";
+            return false;
+        }
+
+        m_Map = map;
+        m_MapSize = fileStat.st_size;
+
+        const Trajectory::Header& header = GetHeader();
+        const bool headerValid = memcmp(header.m_Magic, Trajectory::Magic, sizeof(header.m_Magic)) == 0 &&
+            header.m_Version == Trajectory::Version &&
+            header.m_NumColumns <= Trajectory::MaxColumns &&
+            header.m_NumRows <= header.m_Capacity &&
+            Trajectory::DataOffset + header.m_NumColumns * header.m_Capacity * sizeof(double) <= m_MapSize;
+
+        if (!headerValid)
+        {
+            std::cout << "TrajectoryReader: " << path << " is not a valid trajectory file\n";
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_Map != nullptr)
+        {
+            munmap(m_Map, m_MapSize);
+            m_Map = nullptr;
+            m_MapSize = 0;
+        }
+    }
+
+    size_t NumRows() const
+    {
+        return GetHeader().m_NumRows;
+    }
+
+    size_t NumColumns() const
+    {
+        return GetHeader().m_NumColumns;
+    }
+
+    double GetDeltaT() const
+    {
+        return GetHeader().m_DeltaT;
+    }
+
+    std::string GetEntityName() const
+    {
+        return std::string(GetHeader().m_EntityName, strnlen(GetHeader().m_EntityName, Trajectory::MaxNameLength));
+    }
+
+    std::string GetColumnName(size_t column) const
+    {
+        const char* name = GetHeader().m_ColumnNames[column];
+        return std::string(name, strnlen(name, Trajectory::MaxNameLength));
+    }
+
+    Trajectory::ColumnView GetColumn(size_t column) const
+    {
+        const Trajectory::Header& header = GetHeader();
+        const double* data = reinterpret_cast<const double*>(static_cast<const char*>(m_Map) + Trajectory::DataOffset);
+        return Trajectory::ColumnView{data + column * header.m_Capacity, static_cast<size_t>(header.m_NumRows)};
+    }
+
+    // Column by name, eg "t" or "vel_z". Empty view if there is none.
+    Trajectory::ColumnView GetColumn(const std::string& name) const
+    {
+        for (size_t column = 0; column < NumColumns(); ++column)
+        {
+            if (GetColumnName(column) == name)
+            {
+                return GetColumn(column);
+            }
+        }
+
+        return Trajectory::ColumnView{};
+    }
+
+private:
+
+    const Trajectory::Header& GetHeader() const
+    {
+        return *reinterpret_cast<const Trajectory::Header*>(m_Map);
+    }
+
+private:
+    void* m_Map = nullptr;
+    size_t m_MapSize = 0;
+};
@@ -0,0 +1,83 @@
+#include "./TrajectoryFile.h"
+#include "./DynamicEntities.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+
+#include <cmath>
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////
+// TrajectoryFile Unit Tests
+//////////////////////////////////////////////////////////
+
+int main(void)
+{
+    const std::string path = "./TrajectoryFile_Test.trj";
+
+    //////////////////////////////////////////////////////////
+    // Test a pen flight written through Simulation reads back
+    // in place. Small initial capacity forces column growth.
+    {
+        const CrudeSpinningPen::State penStateInput{
+            0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0};
+        const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+        CrudeSpinningPen csp(penStateInput, inertia);
+
+        TrajectoryWriter<CrudeSpinningPen> writer;
+        const bool isOpen = writer.Open(path, 0.01, 16);
+
+        Simulation simCsp(2.04, .01, false, csp);
+        simCsp.SetOutputSink([&](double time, const CrudeSpinningPen::State& state)
+        {
+            writer.Append(time, state);
+        });
+        const bool isValid = isOpen && simCsp.Run() && writer.Close();
+        TestUtils::ReportResults(isValid, "Trajectory Test: Write");
+
+        TrajectoryReader reader;
+        const bool isRead = reader.Open(path);
+        TestUtils::ReportResults(isRead, "Trajectory Test: Read");
+
+        const bool headerEq = reader.GetEntityName() == "CrudeSpinningPen" &&
+            reader.GetDeltaT() == 0.01 &&
+            reader.NumColumns() == 13 &&
+            reader.NumRows() == 205 &&
+            reader.GetColumnName(0) == "t" &&
+            reader.GetColumnName(12) == "psi_dot";
+        TestUtils::ReportResults(headerEq, "Trajectory Test: Header");
+
+        // First row is the launch state, last row the final output.
+        CrudeSpinningPen::State firstRow;
+        CrudeSpinningPen::State lastRow;
+        for (size_t field = 0; field < firstRow.size(); ++field)
+        {
+            const Trajectory::ColumnView column = reader.GetColumn(field + 1);
+            firstRow[field] = column[0];
+            lastRow[field] = column[column.size() - 1];
+        }
+        const bool rowsEq = TestUtils::FloatEquals(firstRow, penStateInput, 0.0) &&
+            TestUtils::FloatEquals(lastRow, simCsp.GetOutput(), 0.0);
+        TestUtils::ReportResults(rowsEq, "Trajectory Test: Rows Equal");
+
+        const Trajectory::ColumnView time = reader.GetColumn("t");
+        const Trajectory::ColumnView velZ = reader.GetColumn("vel_z");
+        const bool columnsEq = time.size() == 205 && time[0] == 0.0 && std::abs(time[100] - 1.0) < 1.0e-9 &&
+            std::abs(velZ[100] - (10.0 - 9.8)) < 1.0e-9 &&
+            reader.GetColumn("no_such_field").size() == 0;
+        TestUtils::ReportResults(columnsEq, "Trajectory Test: Columns By Name");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test files which are not trajectories are rejected.
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        fputs("not a trajectory", file);
+        fclose(file);
+
+        TrajectoryReader reader;
+        TestUtils::ReportResults(!reader.Open(path), "Trajectory Test: Reject Invalid File");
+    }
+
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "./Integrators.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+// World
+// Descr: Many entities of several types stepped together.
+// Each type lives in its own contiguous array, no pointers
+// or virtual calls, and Step() advances the world one type
+// at a time in tight loops over those arrays. Entities are
+// referred to by generational handles, which stay valid as
+// other entities are added and removed.
+//////////////////////////////////////////////////////////
+
+// Refers to one entity of a World. Goes stale, rather than
+// dangling, once the entity is removed.
+template <typename DynamicEntityType>
+struct EntityHandle
+{
+    uint32_t m_Slot = UINT32_MAX;
+    uint32_t m_Generation = 0;
+};
+
+// Contiguous storage for one entity type. Removal swaps the last
+// entity into the gap, slots map handles to array positions.
+template <typename DynamicEntityType, template <typename> class Integrator>
+class EntityStore
+{
+public:
+
+    EntityHandle<DynamicEntityType> Add(const DynamicEntityType& dynEntity)
+    {
+        uint32_t slot;
+        if (m_FreeSlots.empty())
+        {
+            slot = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back(Slot{});
+        }
+        else
+        {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+
+        m_Slots[slot].m_Index = static_cast<uint32_t>(m_Entities.size());
+        m_Entities.push_back(dynEntity);
+        m_Integrators.emplace_back();
+        m_IndexToSlot.push_back(slot);
+        return EntityHandle<DynamicEntityType>{slot, m_Slots[slot].m_Generation};
+    }
+
+    bool Remove(EntityHandle<DynamicEntityType> handle)
+    {
+        if (!IsValid(handle))
+        {
+            return false;
+        }
+
+        const uint32_t index = m_Slots[handle.m_Slot].m_Index;
+        const uint32_t lastSlot = m_IndexToSlot.back();
+
+        m_Entities[index] = m_Entities.back();
+        m_Integrators[index] = std::move(m_Integrators.back());
+        m_IndexToSlot[index] = lastSlot;
+        m_Slots[lastSlot].m_Index = index;
+        m_Entities.pop_back();
+        m_Integrators.pop_back();
+        m_IndexToSlot.pop_back();
+
+        ++m_Slots[handle.m_Slot].m_Generation;
+        m_FreeSlots.push_back(handle.m_Slot);
+        return true;
+    }
+
+    bool IsValid(EntityHandle<DynamicEntityType> handle) const
+    {
+        return handle.m_Slot < m_Slots.size() && m_Slots[handle.m_Slot].m_Generation == handle.m_Generation;
+    }
+
+    DynamicEntityType* Get(EntityHandle<DynamicEntityType> handle)
+    {
+        return IsValid(handle) ? &m_Entities[m_Slots[handle.m_Slot].m_Index] : nullptr;
+    }
+
+    const DynamicEntityType* Get(EntityHandle<DynamicEntityType> handle) const
+    {
+        return IsValid(handle) ? &m_Entities[m_Slots[handle.m_Slot].m_Index] : nullptr;
+    }
+
+    const std::vector<DynamicEntityType>& GetEntities() const
+    {
+        return m_Entities;
+    }
+
+    void Step(double deltaT, Integrators::StepStats& inOutStats)
+    {
+        for (size_t idx = 0; idx < m_Entities.size(); ++idx)
+        {
+            inOutStats.m_DerivEvals += m_Integrators[idx].Step(m_Entities[idx], deltaT);
+        }
+        inOutStats.m_AcceptedSteps += m_Entities.size();
+    }
+
+private:
+
+    struct Slot
+    {
+        uint32_t m_Index = 0;               // Into m_Entities, while live.
+        uint32_t m_Generation = 0;          // Bumped on every removal.
+    };
+
+    std::vector<DynamicEntityType> m_Entities;
+    std::vector<uint32_t> m_IndexToSlot;    // Parallel to m_Entities.
+
+    // One integrator per entity, parallel to m_Entities. Scratch such
+    // as VelocityVerlet's cached derivatives belongs to one entity, as
+    // it depends on the entity's params as well as its state.
+    std::vector<Integrator<DynamicEntityType>> m_Integrators;
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_FreeSlots;
+};
+
+// Integrator is a fixed step policy from Integrators.h, applied to
+// every entity. Each of DynamicEntityTypes must appear only once.
+template <template <typename> class Integrator, typename... DynamicEntityTypes>
+class World
+{
+public:
+
+    template <typename DynamicEntityType>
+    EntityHandle<DynamicEntityType> Add(const DynamicEntityType& dynEntity)
+    {
+        return GetStore<DynamicEntityType>().Add(dynEntity);
+    }
+
+    // Returns false if handle is stale.
+    template <typename DynamicEntityType>
+    bool Remove(EntityHandle<DynamicEntityType> handle)
+    {
+        return GetStore<DynamicEntityType>().Remove(handle);
+    }
+
+    template <typename DynamicEntityType>
+    bool IsValid(EntityHandle<DynamicEntityType> handle) const
+    {
+        return GetStore<DynamicEntityType>().IsValid(handle);
+    }
+
+    // The entity, or nullptr if handle is stale. Only valid until the
+    // next Add or Remove of the same type.
+    template <typename DynamicEntityType>
+    DynamicEntityType* Get(EntityHandle<DynamicEntityType> handle)
+    {
+        return GetStore<DynamicEntityType>().Get(handle);
+    }
+
+    template <typename DynamicEntityType>
+    const DynamicEntityType* Get(EntityHandle<DynamicEntityType> handle) const
+    {
+        return GetStore<DynamicEntityType>().Get(handle);
+    }
+
+    // All entities of one type, contiguous and in no particular order.
+    template <typename DynamicEntityType>
+    const std::vector<DynamicEntityType>& GetEntities() const
+    {
+        return GetStore<DynamicEntityType>().GetEntities();
+    }
+
+    size_t Size() const
+    {
+        return std::apply([](const auto&... stores){ return (size_t(0) + ... + stores.GetEntities().size()); }, m_Stores);
+    }
+
+    // Advances every entity by deltaT, one pass per type.
+    void Step(double deltaT)
+    {
+        std::apply([&](auto&... stores){ (stores.Step(deltaT, m_StepStats), ...); }, m_Stores);
+        m_ElapsedTime += deltaT;
+    }
+
+    // Steps until duration, like Simulation::Run().
+    void Run(double duration, double deltaT)
+    {
+        while (m_ElapsedTime < duration)
+        {
+            Step(deltaT);
+        }
+    }
+
+    double GetElapsedTime() const
+    {
+        return m_ElapsedTime;
+    }
+
+    // Entity steps taken and derivative evaluations, summed over entities.
+    const Integrators::StepStats& GetStepStats() const
+    {
+        return m_StepStats;
+    }
+
+private:
+
+    template <typename DynamicEntityType>
+    EntityStore<DynamicEntityType, Integrator>& GetStore()
+    {
+        return std::get<EntityStore<DynamicEntityType, Integrator>>(m_Stores);
+    }
+
+    template <typename DynamicEntityType>
+    const EntityStore<DynamicEntityType, Integrator>& GetStore() const
+    {
+        return std::get<EntityStore<DynamicEntityType, Integrator>>(m_Stores);
+    }
+
+private:
+    std::tuple<EntityStore<DynamicEntityTypes, Integrator>...> m_Stores;
+    double m_ElapsedTime = 0.0;     // in seconds.
+    Integrators::StepStats m_StepStats;
+};
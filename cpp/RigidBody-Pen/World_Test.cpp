@@ -0,0 +1,101 @@
+#include "./DynamicEntities.h"
+#include "./Simulation.h"
+#include "./TestUtils.h"
+#include "./World.h"
+
+//////////////////////////////////////////////////////////
+// World Unit Tests
+//////////////////////////////////////////////////////////
+
+int main(void)
+{
+    using PenWorld = World<Integrators::RK4, ConstantVelParticle, SimpleSpringMotion, CrudeSpinningPen, QuaternionSpinningPen>;
+
+    const std::array<double, 3> inertia = {10.0, 10.0, 1.0};
+    const CrudeSpinningPen crudePen(CrudeSpinningPen::State{
+        0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0}, inertia);
+    const QuaternionSpinningPen quatPen(QuaternionSpinningPen::State{
+        0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 10.0, 10.0, 10.0, 10.0, 0.0, 10.0}, inertia);
+
+    //////////////////////////////////////////////////////////
+    // Test a mixed world matches one Simulation per entity.
+    {
+        PenWorld world;
+        const auto particle = world.Add(ConstantVelParticle(ConstantVelParticle::State{0.0, 1.0}));
+        const auto spring = world.Add(SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 4.0));
+        const auto crude = world.Add(crudePen);
+        const auto quat = world.Add(quatPen);
+        world.Run(1.0 - .005, .01);
+
+        Simulation<ConstantVelParticle, Integrators::RK4> particleSim(1.0 - .005, .01, false, ConstantVelParticle(ConstantVelParticle::State{0.0, 1.0}));
+        Simulation<SimpleSpringMotion, Integrators::RK4> springSim(1.0 - .005, .01, false, SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 4.0));
+        Simulation<CrudeSpinningPen, Integrators::RK4> crudeSim(1.0 - .005, .01, false, crudePen);
+        Simulation<QuaternionSpinningPen, Integrators::RK4> quatSim(1.0 - .005, .01, false, quatPen);
+        particleSim.Run();
+        springSim.Run();
+        crudeSim.Run();
+        quatSim.Run();
+
+        const bool worldEq = world.Size() == 4 &&
+            world.GetStepStats().m_AcceptedSteps == 4 * 100 &&
+            world.GetStepStats().m_DerivEvals == 4 * 4 * 100 &&
+            world.Get(particle)->m_State == particleSim.GetOutput() &&
+            world.Get(spring)->m_State == springSim.GetOutput() &&
+            world.Get(crude)->m_State == crudeSim.GetOutput() &&
+            world.Get(quat)->m_State == quatSim.GetOutput();
+        TestUtils::ReportResults(worldEq, "World Test: Mixed Types Match Simulation");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test removal keeps other handles and storage contiguous,
+    // and stale handles are rejected after slot reuse.
+    {
+        PenWorld world;
+        std::vector<EntityHandle<ConstantVelParticle>> handles;
+        for (int i = 0; i < 5; ++i)
+        {
+            handles.push_back(world.Add(ConstantVelParticle(ConstantVelParticle::State{double(i), 1.0})));
+        }
+
+        world.Step(.5);
+        const bool removed = world.Remove(handles[1]) && !world.Remove(handles[1]);
+        const auto reused = world.Add(ConstantVelParticle(ConstantVelParticle::State{-10.0, 0.0}));
+        world.Step(.5);
+
+        bool handlesValid = removed &&
+            world.GetEntities<ConstantVelParticle>().size() == 5 &&
+            world.GetEntities<CrudeSpinningPen>().empty() &&
+            !world.IsValid(handles[1]) &&
+            world.Get(handles[1]) == nullptr &&
+            reused.m_Slot == handles[1].m_Slot &&
+            world.Get(reused)->m_State[0] == -10.0;
+        for (int i : {0, 2, 3, 4})
+        {
+            handlesValid = handlesValid && world.Get(handles[i])->m_State[0] == i + 1.0;
+        }
+        TestUtils::ReportResults(handlesValid, "World Test: Handles Across Removal");
+    }
+
+    //////////////////////////////////////////////////////////
+    // Test each entity keeps its own Verlet scratch, so springs of
+    // different stiffness through the same state neither share
+    // accelerations nor miss the cache.
+    {
+        World<Integrators::VelocityVerlet, SimpleSpringMotion> world;
+        const auto soft = world.Add(SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 1.0));
+        const auto stiff = world.Add(SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 9.0));
+        world.Run(1.0 - .005, .01);
+
+        Simulation<SimpleSpringMotion, Integrators::VelocityVerlet> softSim(1.0 - .005, .01, false, SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 1.0));
+        Simulation<SimpleSpringMotion, Integrators::VelocityVerlet> stiffSim(1.0 - .005, .01, false, SimpleSpringMotion(SimpleSpringMotion::State{1.0, 0.0}, 9.0));
+        softSim.Run();
+        stiffSim.Run();
+
+        const bool scratchEq = world.GetStepStats().m_DerivEvals == 2 * 101 &&
+            world.Get(soft)->m_State == softSim.GetOutput() &&
+            world.Get(stiff)->m_State == stiffSim.GetOutput();
+        TestUtils::ReportResults(scratchEq, "World Test: Verlet Scratch Per Entity");
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/sh
+
+####################################
+# Builds and runs all benchmarks
+####################################
+
+echo "Building EnsembleRunner_Bench..."
+clang++ ./EnsembleRunner_Bench.cpp -std=c++17 -O3 -march=native -pthread -o EnsembleRunner_Bench -Wall
+echo "Done."
+
+echo "Building Integrators_Bench..."
+clang++ ./Integrators_Bench.cpp -std=c++17 -O3 -march=native -o Integrators_Bench -Wall
+echo "Done."
+
+echo "Building StateVector_Bench..."
+clang++ ./StateVector_Bench.cpp -std=c++17 -O3 -march=native -o StateVector_Bench -Wall
+echo "Done."
+
+echo "Building TextOutput_Bench..."
+clang++ ./TextOutput_Bench.cpp -std=c++17 -O3 -march=native -o TextOutput_Bench -Wall
+echo "Done."
+
+echo "Running EnsembleRunner_Bench..."
+./EnsembleRunner_Bench
+echo "Done."
+
+echo "Running Integrators_Bench..."
+./Integrators_Bench Integrators_Bench.json
+echo "Results written to Integrators_Bench.json"
+echo "Done."
+
+echo "Running StateVector_Bench..."
+./StateVector_Bench
+echo "Done."
+
+echo "Running TextOutput_Bench..."
+./TextOutput_Bench
+echo "Done."
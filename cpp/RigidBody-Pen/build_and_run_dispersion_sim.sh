@@ -0,0 +1,13 @@
+#!/bin/sh
+
+###################################
+# Builds and runs dispersion example
+###################################
+
+echo "Building Dispersion_Sim..."
+clang++ ./Dispersion_Sim.cpp -std=c++17 -O3 -pthread -o Dispersion_Sim -Wall
+echo "Done."
+
+echo "Running Dispersion_Sim on 10000 random launches..."
+awk 'BEGIN { srand(1); for (i = 0; i < 10000; i++) printf "0,0,0,0,0,0,%f,%f,10,10,0,%f\n", 5 + rand(), 5 + rand(), 10 + rand() }' | ./Dispersion_Sim - 2.04 .01
+echo "Done."
@@ -0,0 +1,35 @@
+#!/bin/sh
+
+###################################
+# Builds the simulation server and
+# runs the load generator against it
+###################################
+
+echo "Building Sim_Server..."
+clang++ ./Sim_Server.cpp -std=c++17 -O3 -pthread -o Sim_Server -Wall
+echo "Done."
+
+echo "Building Sim_LoadGen..."
+clang++ ./Sim_LoadGen.cpp -std=c++17 -O3 -pthread -o Sim_LoadGen -Wall
+echo "Done."
+
+SOCKET=/tmp/Sim_Server.$$.sock
+
+echo "Starting Sim_Server on $SOCKET..."
+./Sim_Server $SOCKET &
+SERVER=$!
+while [ ! -S $SOCKET ] && kill -0 $SERVER 2>/dev/null; do sleep .1; done
+echo "Done."
+
+echo "Running Sim_LoadGen with 16 clients of 200 requests..."
+./Sim_LoadGen $SOCKET 16 200
+echo "Done."
+
+echo "Running Sim_LoadGen with 4 clients of 50 trajectory requests..."
+./Sim_LoadGen $SOCKET 4 50 --trajectory
+echo "Done."
+
+echo "Stopping Sim_Server..."
+kill $SERVER
+wait $SERVER
+echo "Done."
@@ -16,6 +16,58 @@ echo "Building Simulation_Test..."
 clang++ ./Simulation_Test.cpp -std=c++17 -o Simulation_Test
 echo "Done."
 
+echo "Building DynamicEntityBatches_Test..."
+clang++ ./DynamicEntityBatches_Test.cpp -std=c++17 -o DynamicEntityBatches_Test -Wall
+echo "Done."
+
+echo "Building EnsembleRunner_Test..."
+clang++ ./EnsembleRunner_Test.cpp -std=c++17 -pthread -o EnsembleRunner_Test -Wall
+echo "Done."
+
+echo "Building TrajectoryFile_Test..."
+clang++ ./TrajectoryFile_Test.cpp -std=c++17 -o TrajectoryFile_Test -Wall
+echo "Done."
+
+echo "Building AsyncOutput_Test..."
+clang++ ./AsyncOutput_Test.cpp -std=c++17 -pthread -o AsyncOutput_Test -Wall
+echo "Done."
+
+echo "Building Instrumentation_Test..."
+clang++ ./Instrumentation_Test.cpp -std=c++17 -o Instrumentation_Test -Wall
+echo "Done."
+
+echo "Building RealTime_Test..."
+clang++ ./RealTime_Test.cpp -std=c++17 -o RealTime_Test -Wall
+echo "Done."
+
+echo "Building World_Test..."
+clang++ ./World_Test.cpp -std=c++17 -o World_Test -Wall
+echo "Done."
+
+echo "Building Contacts_Test..."
+clang++ ./Contacts_Test.cpp -std=c++17 -o Contacts_Test -Wall
+echo "Done."
+
+echo "Building OnlineStats_Test..."
+clang++ ./OnlineStats_Test.cpp -std=c++17 -pthread -o OnlineStats_Test -Wall
+echo "Done."
+
+echo "Building Sensitivity_Test..."
+clang++ ./Sensitivity_Test.cpp -std=c++17 -o Sensitivity_Test -Wall
+echo "Done."
+
+echo "Building Parareal_Test..."
+clang++ ./Parareal_Test.cpp -std=c++17 -pthread -o Parareal_Test -Wall
+echo "Done."
+
+echo "Building SimServer_Test..."
+clang++ ./SimServer_Test.cpp -std=c++17 -pthread -o SimServer_Test -Wall
+echo "Done."
+
+echo "Building TextOutput_Test..."
+clang++ ./TextOutput_Test.cpp -std=c++17 -o TextOutput_Test -Wall
+echo "Done."
+
 echo "Running Integrators_Test..."
 ./Integrators_Test
 echo "Done."
@@ -26,4 +78,57 @@ echo "Done."
 
 echo "Running Simulation_Test..."
 ./Simulation_Test
-echo "Done."
\ No newline at end of file
+./Simulation_Test --float
+echo "Done."
+
+echo "Running DynamicEntityBatches_Test..."
+./DynamicEntityBatches_Test
+echo "Done."
+
+echo "Running EnsembleRunner_Test..."
+./EnsembleRunner_Test
+echo "Done."
+
+echo "Running TrajectoryFile_Test..."
+./TrajectoryFile_Test
+echo "Done."
+
+echo "Running AsyncOutput_Test..."
+./AsyncOutput_Test
+echo "Done."
+
+echo "Running Instrumentation_Test..."
+./Instrumentation_Test
+echo "Done."
+
+echo "Running RealTime_Test..."
+./RealTime_Test
+echo "Done."
+
+echo "Running World_Test..."
+./World_Test
+echo "Done."
+
+echo "Running Contacts_Test..."
+./Contacts_Test
+echo "Done."
+
+echo "Running OnlineStats_Test..."
+./OnlineStats_Test
+echo "Done."
+
+echo "Running Sensitivity_Test..."
+./Sensitivity_Test
+echo "Done."
+
+echo "Running Parareal_Test..."
+./Parareal_Test
+echo "Done."
+
+echo "Running SimServer_Test..."
+./SimServer_Test
+echo "Done."
+
+echo "Running TextOutput_Test..."
+./TextOutput_Test
+echo "Done."
@@ -8,5 +8,26 @@ echo "Cleaning..."
 rm DynamicEntities_Test
 rm Integrators_Test
 rm Simulation_Test
+rm DynamicEntityBatches_Test
+rm EnsembleRunner_Test
+rm EnsembleRunner_Bench
+rm TrajectoryFile_Test
+rm AsyncOutput_Test
+rm Instrumentation_Test
+rm RealTime_Test
+rm World_Test
+rm Contacts_Test
+rm OnlineStats_Test
+rm Sensitivity_Test
+rm Parareal_Test
+rm SimServer_Test
+rm TextOutput_Test
+rm Integrators_Bench
+rm Integrators_Bench.json
+rm StateVector_Bench
+rm TextOutput_Bench
 rm Example_Sim
+rm Dispersion_Sim
+rm Sim_Server
+rm Sim_LoadGen
 echo "Done."